@@ -706,6 +706,8 @@ VOID ReadConfig (
     MY_MUTELOGGER_SET;
     #endif
 
+    PROF_BEGIN(SpanReadConfig, "ReadConfig");
+
     // Set a few defaults only if we are loading the default file.
     if (MyStriCmp (FileName, GlobalConfig.ConfigFilename)) {
         MY_FREE_POOL(GlobalConfig.DontScanTools);
@@ -779,6 +781,7 @@ VOID ReadConfig (
         PauseForKey();
         SwitchToGraphics();
 
+        PROF_END(SpanReadConfig);
         return;
     }
 
@@ -790,6 +793,7 @@ VOID ReadConfig (
         MuteLogger = TRUE; /* Explicit For FB Infer */
         #endif
 
+        PROF_END(SpanReadConfig);
         return;
     }
 
@@ -1233,6 +1237,9 @@ VOID ReadConfig (
         else if (MyStriCmp (TokenList[0], L"follow_symlinks")) {
             GlobalConfig.FollowSymlinks = HandleBoolean (TokenList, TokenCount);
         }
+        else if (MyStriCmp (TokenList[0], L"scan_cache")) {
+            GlobalConfig.ScanCache = HandleBoolean (TokenList, TokenCount);
+        }
         else if (MyStriCmp (TokenList[0], L"prefer_uga")) {
             GlobalConfig.PreferUGA = HandleBoolean (TokenList, TokenCount);
         }
@@ -1442,6 +1449,8 @@ VOID ReadConfig (
         LOG_MSG("\n\n");
     }
     #endif
+
+    PROF_END(SpanReadConfig);
 } // VOID ReadConfig()
 
 static
@@ -686,6 +686,8 @@ BOOLEAN LoadDrivers (VOID) {
     ALT_LOG(1, LOG_LINE_SEPARATOR, L"Load UEFI Drivers");
     #endif
 
+    PROF_BEGIN(SpanLoadDrivers, "LoadDrivers");
+
     // Load drivers from the subdirectories of RefindPlus' home directory
     // specified in the DRIVER_DIRS constant.
     #if REFIT_DEBUG > 0
@@ -865,7 +867,11 @@ BOOLEAN LoadDrivers (VOID) {
 
     // Connect Devices
     // DA-TAG: Always run this
+    PROF_BEGIN(SpanConnect, "ConnectAllDriversToAllControllers");
     ConnectAllDriversToAllControllers (TRUE);
+    PROF_END(SpanConnect);
+
+    PROF_END(SpanLoadDrivers);
 
     return (NumFound > 0);
 } // BOOLEAN LoadDrivers()
@@ -429,6 +429,7 @@ typedef struct {
     BOOLEAN           DisableAMFI;
     BOOLEAN           NvramProtectEx;
     BOOLEAN           FollowSymlinks;
+    BOOLEAN           ScanCache;
     BOOLEAN           PreferUGA;
     BOOLEAN           SupplyNVME;
     BOOLEAN           SupplyAPFS;
@@ -592,6 +593,14 @@ extern CHAR16 *gLogTemp;
 
 #if REFIT_DEBUG > 0
 extern VOID LogPadding (BOOLEAN Increment);
+extern VOID SaveProfileToDebugLogFile (VOID);
+extern UINTN EFIAPI MemLogSpanBegin (IN const CHAR8 *Name);
+extern VOID  EFIAPI MemLogSpanEnd (IN UINTN Span);
+
+// Profiler spans ... 'Name' must be a string literal
+// Every PROF_BEGIN needs a PROF_END on each exit path
+#   define PROF_BEGIN(Span, Name) UINTN Span = MemLogSpanBegin (Name);
+#   define PROF_END(Span) MemLogSpanEnd (Span);
 
 #   define ALT_LOG(level, type, ...)                                             \
         do {                                                                     \
@@ -605,6 +614,8 @@ extern VOID LogPadding (BOOLEAN Increment);
 #   define RET_TAG() WayPointer (L"----->> * <<-----");
 #   define END_TAG() WayPointer (L"<<<     *     >>>");
 #else
+#   define PROF_END(...)
+#   define PROF_BEGIN(...)
 #   define END_TAG()
 #   define RET_TAG()
 #   define OUT_TAG()
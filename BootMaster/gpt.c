@@ -135,9 +135,18 @@ BOOLEAN GptHeaderValid (GPT_DATA *GptData) {
 // rEFInd uses the data only to provide access to partition names. This is
 // non-critical data, so it is OK to return nothing, but having the program
 // hang on reading garbage or return nonsense could be very bad.
-EFI_STATUS ReadGptData (REFIT_VOLUME *Volume, GPT_DATA **Data) {
+// If Sample is not NULL, it holds the first SampleSize bytes of the disk,
+// already read by the caller, and is used in place of any read it covers.
+EFI_STATUS ReadGptData (
+    REFIT_VOLUME  *Volume,
+    GPT_DATA     **Data,
+    VOID          *Sample,
+    UINTN          SampleSize
+) {
     EFI_STATUS  Status = EFI_SUCCESS;
     UINT64      BufferSize;
+    UINT64      Offset;
+    UINTN       BlockSize;
     UINTN       i;
     GPT_DATA   *GptData = NULL; // Temporary holding storage; transferred to *Data later
 
@@ -171,22 +180,34 @@ EFI_STATUS ReadGptData (REFIT_VOLUME *Volume, GPT_DATA **Data) {
         }
     }
 
+    BlockSize = (Status == EFI_SUCCESS) ? Volume->BlockIO->Media->BlockSize : 0;
+
     // Read the MBR and store it in GptData->ProtectiveMBR.
     if (Status == EFI_SUCCESS) {
-        Status = REFIT_CALL_5_WRAPPER(
-            Volume->BlockIO->ReadBlocks, Volume->BlockIO,
-            Volume->BlockIO->Media->MediaId, 0,
-            sizeof (MBR_RECORD), (VOID*) GptData->ProtectiveMBR
-        );
+        if (Sample != NULL && sizeof (MBR_RECORD) <= SampleSize) {
+            CopyMem (GptData->ProtectiveMBR, Sample, sizeof (MBR_RECORD));
+        }
+        else {
+            Status = REFIT_CALL_5_WRAPPER(
+                Volume->BlockIO->ReadBlocks, Volume->BlockIO,
+                Volume->BlockIO->Media->MediaId, 0,
+                sizeof (MBR_RECORD), (VOID*) GptData->ProtectiveMBR
+            );
+        }
     }
 
     // Read the GPT header and store it in GptData->Header.
     if (Status == EFI_SUCCESS) {
-        Status = REFIT_CALL_5_WRAPPER(
-            Volume->BlockIO->ReadBlocks, Volume->BlockIO,
-            Volume->BlockIO->Media->MediaId, 1,
-            sizeof (GPT_HEADER), GptData->Header
-        );
+        if (Sample != NULL && BlockSize + sizeof (GPT_HEADER) <= SampleSize) {
+            CopyMem (GptData->Header, (UINT8 *) Sample + BlockSize, sizeof (GPT_HEADER));
+        }
+        else {
+            Status = REFIT_CALL_5_WRAPPER(
+                Volume->BlockIO->ReadBlocks, Volume->BlockIO,
+                Volume->BlockIO->Media->MediaId, 1,
+                sizeof (GPT_HEADER), GptData->Header
+            );
+        }
     }
 
     // If it looks like a valid protective MBR & GPT header, try to do more with it.
@@ -200,12 +221,22 @@ EFI_STATUS ReadGptData (REFIT_VOLUME *Volume, GPT_DATA **Data) {
                 Status = EFI_OUT_OF_RESOURCES;
             }
 
-            if (Status == EFI_SUCCESS)
-                Status = REFIT_CALL_5_WRAPPER(
-                    Volume->BlockIO->ReadBlocks, Volume->BlockIO,
-                    Volume->BlockIO->Media->MediaId, GptData->Header->entry_lba,
-                    BufferSize, GptData->Entries
-                );
+            Offset = MultU64x32 (GptData->Header->entry_lba, (UINT32) BlockSize);
+            if (Status == EFI_SUCCESS) {
+                if (Sample != NULL &&
+                    GptData->Header->entry_lba < SampleSize &&
+                    Offset + BufferSize <= SampleSize
+                ) {
+                    CopyMem (GptData->Entries, (UINT8 *) Sample + Offset, (UINTN) BufferSize);
+                }
+                else {
+                    Status = REFIT_CALL_5_WRAPPER(
+                        Volume->BlockIO->ReadBlocks, Volume->BlockIO,
+                        Volume->BlockIO->Media->MediaId, GptData->Header->entry_lba,
+                        BufferSize, GptData->Entries
+                    );
+                }
+            }
 
             // Check CRC status of table
             if ((Status == EFI_SUCCESS) &&
@@ -285,12 +316,16 @@ VOID ForgetPartitionTables (VOID) {
 } // VOID ForgetPartitionTables()
 
 // If Volume points to a whole disk with a GPT, add it to the gPartitions
-// linked list of GPTs.
-VOID AddPartitionTable (REFIT_VOLUME *Volume) {
+// linked list of GPTs. Sample is as for ReadGptData and may be NULL.
+VOID AddPartitionTable (
+    REFIT_VOLUME *Volume,
+    VOID         *Sample,
+    UINTN         SampleSize
+) {
     GPT_DATA    *GptData = NULL, *GptList;
     EFI_STATUS  Status;
 
-    Status = ReadGptData (Volume, &GptData);
+    Status = ReadGptData (Volume, &GptData, Sample, SampleSize);
     if (Status == EFI_SUCCESS) {
         if (gPartitions == NULL) {
             gPartitions = GptData;
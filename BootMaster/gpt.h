@@ -81,10 +81,10 @@ typedef struct _gpt_data {
 #pragma pack(0)
 
 VOID ClearGptData(GPT_DATA *Data);
-EFI_STATUS ReadGptData(REFIT_VOLUME *Volume, GPT_DATA **Data);
+EFI_STATUS ReadGptData(REFIT_VOLUME *Volume, GPT_DATA **Data, VOID *Sample, UINTN SampleSize);
 // CHAR16 * PartNameFromGuid(EFI_GUID *Guid);
 GPT_ENTRY * FindPartWithGuid(EFI_GUID *Guid);
 VOID ForgetPartitionTables(VOID);
-VOID AddPartitionTable(REFIT_VOLUME *Volume);
+VOID AddPartitionTable(REFIT_VOLUME *Volume, VOID *Sample, UINTN SampleSize);
 
 #endif
\ No newline at end of file
@@ -145,7 +145,7 @@ EG_IMAGE * BuiltinIcon (
         #endif
 
         // Early Return
-        return egCopyImage (BuiltinIconTable[Id].Image);
+        return egShareImage (BuiltinIconTable[Id].Image);
     }
 
     BuiltinIconTable[Id].Image = egFindIcon (
@@ -162,7 +162,7 @@ EG_IMAGE * BuiltinIcon (
         }
     }
 
-    return egCopyImage (BuiltinIconTable[Id].Image);
+    return egShareImage (BuiltinIconTable[Id].Image);
 } // EG_IMAGE * BuiltinIcon()
 
 //
@@ -227,10 +227,10 @@ EG_IMAGE * LoadOSIcon (
         ALT_LOG(1, LOG_LINE_NORMAL, L"Setting dummy image");
         #endif
 
-        Image = DummyImageEx (GlobalConfig.IconSizes[ICON_SIZE_BIG]);
+        Image = egShareImage (DummyImageEx (GlobalConfig.IconSizes[ICON_SIZE_BIG]));
     }
 
-    return egCopyImage (Image);
+    return Image;
 } // EG_IMAGE * LoadOSIcon()
 
 EG_IMAGE * DummyImage (
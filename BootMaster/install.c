@@ -491,6 +491,9 @@ EFI_STATUS CopyDirectory (
         MY_FREE_POOL(DirEntry);
     } // while
 
+    // Also releases the iterator buffers when a copy failure stops the loop early
+    DirIterClose (&DirIter);
+
     return Status;
 } // EFI_STATUS CopyDirectory()
 
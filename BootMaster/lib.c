@@ -188,6 +188,22 @@ extern BOOLEAN     LogNewLine;
 // 68 KiB -- ReiserFS superblock begins at 64 KiB
 #define SAMPLE_SIZE 69632
 
+// Boot sector and superblock sample read for one BlockIO handle before
+// any volume is classified. See ReadVolumeSamples.
+typedef struct {
+    EFI_BLOCK_IO_PROTOCOL  *BlockIO;
+    UINT8                  *Buffer;
+    EFI_STATUS              Status;
+#ifdef __MAKEWITH_TIANO
+    EFI_BLOCK_IO2_TOKEN     Token;
+#endif
+} VOLUME_SAMPLE;
+
+// Sample for the handle currently being classified by ScanVolumes
+static VOLUME_SAMPLE *CurrentSample = NULL;
+
+extern UINT64 GetCurrentMS (VOID);
+
 
 #define NAME_FIX(Name) FindSubStr ((*Volume)->VolName, Name)) VolumeName = Name
 
@@ -502,6 +518,8 @@ VOID UninitRefitLib (VOID) {
     }
 
     UninitVolumes();
+    egFreeIconIndex();
+    egFreeIconCache();
 
     if (SelfDir != NULL) {
         REFIT_CALL_1_WRAPPER(SelfDir->Close, SelfDir);
@@ -1274,6 +1292,179 @@ VOID SetFilesystemData (
     } // if ((Buffer != NULL) && (Volume != NULL))
 } // UINT32 SetFilesystemData()
 
+// Stages one and two of the volume scan. Reads the first SAMPLE_SIZE bytes of
+// every handle, covering the boot sector, GPT and filesystem superblocks, so
+// classification in ScanVolume does not wait on each device in turn. Reads on
+// devices with BlockIo2 are all submitted before any is waited on; others are
+// read synchronously while the asynchronous reads are in flight. A sample
+// left with an error status is simply read again during classification.
+static
+VOLUME_SAMPLE * ReadVolumeSamples (
+    IN EFI_HANDLE *Handles,
+    IN UINTN       HandleCount
+) {
+    EFI_STATUS              Status;
+    UINTN                   HandleIndex;
+    UINTN                   BlockSize;
+    VOLUME_SAMPLE          *Samples;
+    VOLUME_SAMPLE          *Sample;
+    EFI_BLOCK_IO_MEDIA     *Media;
+
+#ifdef __MAKEWITH_TIANO
+    UINTN                   Index;
+    EFI_BLOCK_IO2_PROTOCOL *BlockIO2;
+#endif
+
+    #if REFIT_DEBUG > 0
+    UINT64 StageStart;
+    UINTN  AsyncCount = 0;
+    UINTN  SyncCount  = 0;
+
+    StageStart = GetCurrentMS();
+    #endif
+
+    Samples = AllocateZeroPool (sizeof (VOLUME_SAMPLE) * HandleCount);
+    if (Samples == NULL) {
+        return NULL;
+    }
+
+    // Stage 1: Submit reads
+    for (HandleIndex = 0; HandleIndex < HandleCount; HandleIndex++) {
+        Sample         = &Samples[HandleIndex];
+        Sample->Status = EFI_NOT_READY;
+
+        Status = REFIT_CALL_3_WRAPPER(
+            gBS->HandleProtocol, Handles[HandleIndex],
+            &BlockIoProtocol, (VOID **) &(Sample->BlockIO)
+        );
+        if (EFI_ERROR(Status)) {
+            Sample->BlockIO = NULL;
+            continue;
+        }
+
+        // Leave anything the plain read path would treat specially to that path
+        Media     = Sample->BlockIO->Media;
+        BlockSize = Media->BlockSize;
+        if (!Media->MediaPresent ||
+            BlockSize == 0       ||
+            BlockSize > SAMPLE_SIZE ||
+            (SAMPLE_SIZE % BlockSize) != 0 ||
+            Media->IoAlign > 8
+        ) {
+            continue;
+        }
+
+        Sample->Buffer = AllocatePool (SAMPLE_SIZE);
+        if (Sample->Buffer == NULL) {
+            continue;
+        }
+
+#ifdef __MAKEWITH_TIANO
+        Status = REFIT_CALL_3_WRAPPER(
+            gBS->HandleProtocol, Handles[HandleIndex],
+            &gEfiBlockIo2ProtocolGuid, (VOID **) &BlockIO2
+        );
+        if (!EFI_ERROR(Status)) {
+            Status = REFIT_CALL_5_WRAPPER(
+                gBS->CreateEvent, 0, TPL_CALLBACK,
+                NULL, NULL, &(Sample->Token.Event)
+            );
+            if (!EFI_ERROR(Status)) {
+                Status = REFIT_CALL_6_WRAPPER(
+                    BlockIO2->ReadBlocksEx, BlockIO2,
+                    Media->MediaId, 0,
+                    &(Sample->Token), SAMPLE_SIZE, Sample->Buffer
+                );
+                if (!EFI_ERROR(Status)) {
+                    // In flight ... Collected in Stage 2
+                    #if REFIT_DEBUG > 0
+                    AsyncCount++;
+                    #endif
+
+                    continue;
+                }
+
+                REFIT_CALL_1_WRAPPER(gBS->CloseEvent, Sample->Token.Event);
+                Sample->Token.Event = NULL;
+            }
+        }
+#endif
+
+        Sample->Status = REFIT_CALL_5_WRAPPER(
+            Sample->BlockIO->ReadBlocks, Sample->BlockIO,
+            Media->MediaId, 0,
+            SAMPLE_SIZE, Sample->Buffer
+        );
+
+        #if REFIT_DEBUG > 0
+        SyncCount++;
+        #endif
+    } // for
+
+#ifdef __MAKEWITH_TIANO
+    // Stage 2: Collect asynchronous reads
+    for (HandleIndex = 0; HandleIndex < HandleCount; HandleIndex++) {
+        Sample = &Samples[HandleIndex];
+        if (Sample->Token.Event == NULL) {
+            continue;
+        }
+
+        Status = REFIT_CALL_3_WRAPPER(
+            gBS->WaitForEvent, 1,
+            &(Sample->Token.Event), &Index
+        );
+        Sample->Status = (EFI_ERROR(Status))
+            ? Status : Sample->Token.TransactionStatus;
+
+        REFIT_CALL_1_WRAPPER(gBS->CloseEvent, Sample->Token.Event);
+        Sample->Token.Event = NULL;
+    } // for
+#endif
+
+    #if REFIT_DEBUG > 0
+    LOG_MSG(
+        "\nRead Volume Samples: %d Asynchronous ... %d Synchronous ... %ld ms",
+        AsyncCount, SyncCount, GetCurrentMS() - StageStart
+    );
+    #endif
+
+    return Samples;
+} // static VOLUME_SAMPLE * ReadVolumeSamples()
+
+static
+VOID FreeVolumeSamples (
+    IN VOLUME_SAMPLE *Samples,
+    IN UINTN          HandleCount
+) {
+    UINTN HandleIndex;
+
+    if (Samples == NULL) {
+        return;
+    }
+
+    for (HandleIndex = 0; HandleIndex < HandleCount; HandleIndex++) {
+        MY_FREE_POOL(Samples[HandleIndex].Buffer);
+    }
+    MY_FREE_POOL(Samples);
+} // static VOID FreeVolumeSamples()
+
+// Returns the prefetched sample for Volume, or NULL if it must be read
+static
+UINT8 * VolumeSampleData (
+    IN REFIT_VOLUME *Volume
+) {
+    if (CurrentSample == NULL              ||
+        CurrentSample->Buffer == NULL      ||
+        EFI_ERROR(CurrentSample->Status)   ||
+        Volume->BlockIOOffset != 0         ||
+        (Volume->BlockIO != NULL && Volume->BlockIO != CurrentSample->BlockIO)
+    ) {
+        return NULL;
+    }
+
+    return CurrentSample->Buffer;
+} // static UINT8 * VolumeSampleData()
+
 static
 VOID ScanVolumeBootcode (
     IN OUT REFIT_VOLUME  *Volume,
@@ -1281,7 +1472,8 @@ VOID ScanVolumeBootcode (
 ) {
     EFI_STATUS           Status;
     UINTN                i;
-    UINT8                Buffer[SAMPLE_SIZE];
+    UINT8                ReadBuffer[SAMPLE_SIZE];
+    UINT8               *Buffer;
     BOOLEAN              MbrTableFound = FALSE;
     MBR_PARTITION_INFO  *MbrTable;
 
@@ -1305,11 +1497,19 @@ VOID ScanVolumeBootcode (
     }
 
     // look at the boot sector (this is used for both hard disks and El Torito images!)
-    Status = REFIT_CALL_5_WRAPPER(
-        Volume->BlockIO->ReadBlocks, Volume->BlockIO,
-        Volume->BlockIO->Media->MediaId, Volume->BlockIOOffset,
-        SAMPLE_SIZE, Buffer
-    );
+    // Use the sample read ahead by ScanVolumes when there is one
+    Buffer = VolumeSampleData (Volume);
+    if (Buffer != NULL) {
+        Status = EFI_SUCCESS;
+    }
+    else {
+        Buffer = ReadBuffer;
+        Status = REFIT_CALL_5_WRAPPER(
+            Volume->BlockIO->ReadBlocks, Volume->BlockIO,
+            Volume->BlockIO->Media->MediaId, Volume->BlockIOOffset,
+            SAMPLE_SIZE, Buffer
+        );
+    }
 
     if (!EFI_ERROR(Status)) {
         SetFilesystemData (Buffer, SAMPLE_SIZE, Volume);
@@ -1801,6 +2001,8 @@ VOID ScanVolume (
     MY_HYBRIDLOGGER_SET;
     #endif
 
+    PROF_BEGIN(SpanScanVolume, "ScanVolume");
+
     // Get device path
     Volume->DevicePath = DuplicateDevicePath (
         DevicePathFromHandle (Volume->DeviceHandle)
@@ -2000,6 +2202,8 @@ VOID ScanVolume (
 
     if (Volume->RootDir == NULL) {
         Volume->IsReadable = FALSE;
+
+        PROF_END(SpanScanVolume);
         return;
     }
 
@@ -2012,6 +2216,8 @@ VOID ScanVolume (
         // on Mac unless there are actual boot file, so check for them.
         Volume->HasBootCode = HasWindowsBiosBootFiles (Volume);
     }
+
+    PROF_END(SpanScanVolume);
 } // ScanVolume()
 
 static
@@ -2389,6 +2595,7 @@ VOID ScanVolumes (VOID) {
     UINTN                   HandleCount = 0;
     UINT8                  *SectorBuffer1;
     UINT8                  *SectorBuffer2;
+    UINT8                  *SampleData;
     CHAR16                 *RoleStr = NULL;
     CHAR16                 *PartType = NULL;
     BOOLEAN                 DupFlag;
@@ -2396,8 +2603,10 @@ VOID ScanVolumes (VOID) {
     EFI_GUID                VolumeGuid;
     EFI_GUID               *UuidList;
     APPLE_APFS_VOLUME_ROLE  VolumeRole = 0;
+    VOLUME_SAMPLE          *Samples;
 
     #if REFIT_DEBUG > 0
+    UINT64   StageStart;
     CHAR16  *MsgStr        = NULL;
     CHAR16  *PartName      = NULL;
     CHAR16  *PartGUID      = NULL;
@@ -2418,6 +2627,8 @@ VOID ScanVolumes (VOID) {
     MY_FREE_POOL(MsgStr);
     #endif
 
+    PROF_BEGIN(SpanScanVolumes, "ScanVolumes");
+
     if (SelfVolRun) {
         // Clear Volume Lists if not Scanning for Self Volume
         FreeVolumes (
@@ -2447,6 +2658,7 @@ VOID ScanVolumes (VOID) {
         MY_FREE_POOL(MsgStr);
         #endif
 
+        PROF_END(SpanScanVolumes);
         return;
     }
 
@@ -2474,9 +2686,19 @@ VOID ScanVolumes (VOID) {
         MY_FREE_POOL(MsgStr);
         #endif
 
+        PROF_END(SpanScanVolumes);
         return;
     }
 
+    // Read boot sectors and superblocks for all handles before classifying any
+    PROF_BEGIN(SpanSamples, "ReadVolumeSamples");
+    Samples = ReadVolumeSamples (Handles, HandleCount);
+    PROF_END(SpanSamples);
+
+    #if REFIT_DEBUG > 0
+    StageStart = GetCurrentMS();
+    #endif
+
     // First Pass: Collect information about all handles
     DoneHeadings = FALSE;
     ScannedOnce  = FALSE;
@@ -2498,6 +2720,8 @@ VOID ScanVolumes (VOID) {
         Volume = AllocateZeroPool (sizeof (REFIT_VOLUME));
         if (Volume == NULL) {
             MY_FREE_POOL(UuidList);
+            CurrentSample = NULL;
+            FreeVolumeSamples (Samples, HandleCount);
 
             #if REFIT_DEBUG > 0
             Status = EFI_BUFFER_TOO_SMALL;
@@ -2514,12 +2738,16 @@ VOID ScanVolumes (VOID) {
             MY_FREE_POOL(MsgStr);
             #endif
 
+            PROF_END(SpanScanVolumes);
             return;
         }
 
         Volume->DeviceHandle = Handles[HandleIndex];
-        AddPartitionTable (Volume);
+        CurrentSample = (Samples != NULL) ? &Samples[HandleIndex] : NULL;
+        SampleData    = VolumeSampleData (Volume);
+        AddPartitionTable (Volume, SampleData, SAMPLE_SIZE);
         ScanVolume (Volume);
+        CurrentSample = NULL;
 
         UuidList[HandleIndex] = Volume->VolUuid;
         // Deduplicate filesystem UUID so that we do not add duplicate entries for file systems
@@ -2818,12 +3046,22 @@ VOID ScanVolumes (VOID) {
         ScannedOnce = TRUE;
     } // for: first pass
 
+    FreeVolumeSamples (Samples, HandleCount);
+
+    #if REFIT_DEBUG > 0
+    LOG_MSG(
+        "\n\nClassify Volumes: %d Handles ... %ld ms",
+        HandleCount, GetCurrentMS() - StageStart
+    );
+    #endif
+
     MY_FREE_POOL(UuidList);
     MY_FREE_POOL(Handles);
 
     if (!SelfVolSet || !SelfVolRun) {
         SelfVolRun = TRUE;
 
+        PROF_END(SpanScanVolumes);
         return;
     }
 
@@ -2947,6 +3185,8 @@ VOID ScanVolumes (VOID) {
         VetSyncAPFS();
     }
 
+    PROF_END(SpanScanVolumes);
+
     #if REFIT_DEBUG > 0
     MuteLogger = FALSE; /* Explicit For FB Infer */
     #endif
@@ -3234,204 +3474,121 @@ BOOLEAN FileExists (
 }
 
 static
-EFI_STATUS DirNextEntry (
-    IN     EFI_FILE       *Directory,
-    OUT    EFI_FILE_INFO **DirEntry,
-    IN     UINTN           FilterMode
+VOID DirIterFreePatterns (
+    IN OUT REFIT_DIR_ITER *DirIter
+) {
+    UINTN i;
+
+    if (DirIter->Patterns != NULL) {
+        for (i = 0; i < DirIter->PatternCount; i++) {
+            MY_FREE_POOL(DirIter->Patterns[i]);
+        }
+        MY_FREE_POOL(DirIter->Patterns);
+    }
+    MY_FREE_POOL(DirIter->PatternSource);
+    DirIter->PatternCount = 0;
+} // static VOID DirIterFreePatterns()
+
+// Releases the read buffer, batch staging area and split pattern list held
+// by an iterator. Called once the listing is exhausted and from DirIterClose.
+static
+VOID DirIterRelease (
+    IN OUT REFIT_DIR_ITER *DirIter
 ) {
-    EFI_STATUS  Status = EFI_BAD_BUFFER_SIZE;
-    UINTN       LastBufferSize;
+    DirIterFreePatterns (DirIter);
+    MY_FREE_POOL(DirIter->Buffer);
+    MY_FREE_POOL(DirIter->BatchData);
+    DirIter->BufferSize    = 0;
+    DirIter->BatchDataSize = 0;
+} // static VOID DirIterRelease()
+
+// Reads the next directory entry into the iterator's reusable buffer.
+// On return, *DirEntry points into DirIter->Buffer, or is NULL at the end of
+// the listing, and stays valid only until the next read on the iterator.
+static
+EFI_STATUS DirReadEntry (
+    IN OUT REFIT_DIR_ITER  *DirIter,
+    OUT    EFI_FILE_INFO  **DirEntry,
+    OUT    UINTN           *EntrySize
+) {
+    EFI_STATUS  Status;
     UINTN       BufferSize;
-    VOID       *Buffer;
-    INTN        IterCount;
+    UINTN       IterCount;
 
     #if REFIT_DEBUG > 0
-    BOOLEAN FirstRun = TRUE;
-    CHAR16  *MsgStr  = NULL;
+    CHAR16 *MsgStr;
     #endif
 
-    //#if REFIT_DEBUG > 1
-    //CHAR16 *FuncTag = L"DirNextEntry";
-    //#endif
-
-    //LOG_SEP(L"X");
-    //LOG_INCREMENT();
-    //BREAD_CRUMB(L"%s:  1 - START", FuncTag);
-
-    //BREAD_CRUMB(L"%s:  2", FuncTag);
-    for (;;) {
-        //LOG_SEP(L"X");
-        //BREAD_CRUMB(L"%s:  2a 1 - FOR LOOP:- START", FuncTag);
-        *DirEntry = NULL;
-
-        // Read next directory entry
-        //BREAD_CRUMB(L"%s:  2a 2", FuncTag);
-        LastBufferSize = BufferSize = 256;
-        Buffer         = AllocatePool (BufferSize);
-        if (Buffer == NULL) {
-            //BREAD_CRUMB(L"%s:  2a 2a 1 - END:- return EFI_STATUS = 'Bad Buffer Size'", FuncTag);
+    *DirEntry  = NULL;
+    *EntrySize = 0;
 
+    if (DirIter->Buffer == NULL) {
+        DirIter->Buffer = AllocatePool (DIR_ITER_BUFFER_SIZE);
+        if (DirIter->Buffer == NULL) {
             return EFI_BAD_BUFFER_SIZE;
         }
+        DirIter->BufferSize = DIR_ITER_BUFFER_SIZE;
+    }
 
-        //BREAD_CRUMB(L"%s:  2a 3", FuncTag);
-        for (IterCount = 0; ; IterCount++) {
-            //LOG_SEP(L"X");
-            //BREAD_CRUMB(L"%s:  2a 3a 1 - FOR LOOP:- START", FuncTag);
-            Status = REFIT_CALL_3_WRAPPER(
-                Directory->Read, Directory,
-                &BufferSize, Buffer
-            );
-
-            //BREAD_CRUMB(L"%s:  2a 3a 2", FuncTag);
-            if (Status != EFI_BUFFER_TOO_SMALL || IterCount > 3) {
-                //BREAD_CRUMB(L"%s:  2a 3a 2a 1", FuncTag);
-                #if REFIT_DEBUG > 0
-                if (!FirstRun) {
-                    //BREAD_CRUMB(L"%s:  2a 3a 2a 1a 1", FuncTag);
-                    if (IterCount > 3) {
-                        //BREAD_CRUMB(L"%s:  2a 3a 2a 1a 1a 1", FuncTag);
-                        MsgStr = StrDuplicate (L"IterCount > 3 ... Break");
-                    }
-                    else {
-                        //BREAD_CRUMB(L"%s:  2a 3a 2a 1a 1b 1", FuncTag);
-                        MsgStr = StrDuplicate (L"OK ... Break");
-                    }
-                    //BREAD_CRUMB(L"%s:  2a 3a 2a 1a 2", FuncTag);
-                    ALT_LOG(1, LOG_LINE_NORMAL, L"%s", MsgStr);
-                    LOG_MSG(":- '%s'", MsgStr);
-                    MY_FREE_POOL(MsgStr);
-                }
-                #endif
-
-                //BREAD_CRUMB(L"%s:  2a 3a 2a 2 - FOR LOOP:- BREAK ... Status/IterCount", FuncTag);
-                //LOG_SEP(L"X");
-
-                break;
-            }
-            else {
-                //BREAD_CRUMB(L"%s:  2a 3a 2b 1", FuncTag);
-                #if REFIT_DEBUG > 0
-                if (!FirstRun) {
-                    //BREAD_CRUMB(L"%s:  2a 3a 2b 1a 1", FuncTag);
-                    MsgStr = StrDuplicate (L"NOT OK!!");
-                    ALT_LOG(1, LOG_LINE_NORMAL, L"%s", MsgStr);
-                    LOG_MSG(":- '%s'", MsgStr);
-                    MY_FREE_POOL(MsgStr);
-                }
-                #endif
-                //BREAD_CRUMB(L"%s:  2a 3a 2b 2", FuncTag);
-            }
-
-            //BREAD_CRUMB(L"%s:  2a 3a 3", FuncTag);
-            if (BufferSize <= LastBufferSize) {
-                //BREAD_CRUMB(L"%s:  2a 3a 3a 1", FuncTag);
-                #if REFIT_DEBUG > 0
-                MsgStr = PoolPrint (
-                    L"Bad FS Driver Buffer Size Request %d (was %d) ... Using %d Instead",
-                    BufferSize,
-                    LastBufferSize,
-                    LastBufferSize * 2
-                );
-                ALT_LOG(1, LOG_LINE_NORMAL, L"%s", MsgStr);
-                LOG_MSG("\n%s", MsgStr);
-                MY_FREE_POOL(MsgStr);
-                #endif
-
-                BufferSize = LastBufferSize * 2;
-            }
-            else {
-                //BREAD_CRUMB(L"%s:  2a 3a 3b 1", FuncTag);
-                #if REFIT_DEBUG > 0
-                MsgStr = PoolPrint (
-                    L"Resizing DirEntry Buffer from %d to %d bytes",
-                    LastBufferSize, BufferSize
-                );
-                ALT_LOG(1, LOG_LINE_NORMAL, L"%s", MsgStr);
-                LOG_MSG("\n%s", MsgStr);
-                MY_FREE_POOL(MsgStr);
-                #endif
-            }
-            //BREAD_CRUMB(L"%s:  2a 3a 4", FuncTag);
-
-            #if REFIT_DEBUG > 0
-            FirstRun = FALSE;
-            #endif
-
-            Buffer = EfiReallocatePool (
-                Buffer, LastBufferSize, BufferSize
-            );
-            LastBufferSize = BufferSize;
-
-            //BREAD_CRUMB(L"%s:  2a 3a 5 - FOR LOOP:- END", FuncTag);
-            //LOG_SEP(L"X");
-        } // for IterCount = 0
-
-        #if REFIT_DEBUG > 0
-        FirstRun = TRUE;
-        #endif
-
-        //BREAD_CRUMB(L"%s:  2a 4", FuncTag);
-        if (EFI_ERROR(Status)) {
-            //BREAD_CRUMB(L"%s: 2a 4a 1 - FOR LOOP:- BREAK ... Status Error", FuncTag);
-            //LOG_SEP(L"X");
-
-            MY_FREE_POOL(Buffer);
+    for (IterCount = 0; ; IterCount++) {
+        BufferSize = DirIter->BufferSize;
+        Status = REFIT_CALL_3_WRAPPER(
+            DirIter->DirHandle->Read, DirIter->DirHandle,
+            &BufferSize, DirIter->Buffer
+        );
+        if (Status != EFI_BUFFER_TOO_SMALL || IterCount > 3) {
             break;
         }
 
-        // Check for End of Listing
-        //BREAD_CRUMB(L"%s:  2a 5", FuncTag);
-        if (BufferSize == 0) {
-            //BREAD_CRUMB(L"%s: 2a 5a 1 - FOR LOOP:- BREAK ... End of Listing", FuncTag);
-            //LOG_SEP(L"X");
+        if (BufferSize <= DirIter->BufferSize) {
+            #if REFIT_DEBUG > 0
+            MsgStr = PoolPrint (
+                L"Bad FS Driver Buffer Size Request %d (was %d) ... Using %d Instead",
+                BufferSize,
+                DirIter->BufferSize,
+                DirIter->BufferSize * 2
+            );
+            ALT_LOG(1, LOG_LINE_NORMAL, L"%s", MsgStr);
+            LOG_MSG("\n%s", MsgStr);
+            MY_FREE_POOL(MsgStr);
+            #endif
 
-            // End of Directory Listing
-            MY_FREE_POOL(Buffer);
-            break;
+            BufferSize = DirIter->BufferSize * 2;
         }
-
-        // Entry is ready to be returned
-        //BREAD_CRUMB(L"%s:  2a 6", FuncTag);
-        *DirEntry = (EFI_FILE_INFO *) Buffer;
-
-        // Filter results
-        //BREAD_CRUMB(L"%s:  2a 7", FuncTag);
-        if (FilterMode == 1) {
-            //BREAD_CRUMB(L"%s:  2a 7a 1", FuncTag);
-            // Only return directories
-            if (((*DirEntry)->Attribute & EFI_FILE_DIRECTORY)) {
-                //BREAD_CRUMB(L"%s:  2a 7a 1a 1 - FOR LOOP:- BREAK ... EFI_FILE_DIRECTORY", FuncTag);
-                //LOG_SEP(L"X");
-
-                break;
-            }
+        else {
+            #if REFIT_DEBUG > 0
+            MsgStr = PoolPrint (
+                L"Resizing DirEntry Buffer from %d to %d bytes",
+                DirIter->BufferSize, BufferSize
+            );
+            ALT_LOG(1, LOG_LINE_NORMAL, L"%s", MsgStr);
+            LOG_MSG("\n%s", MsgStr);
+            MY_FREE_POOL(MsgStr);
+            #endif
         }
-        else if (FilterMode == 2) {
-            //BREAD_CRUMB(L"%s:  2a 7b 1", FuncTag);
-            // Only return files
-            if (((*DirEntry)->Attribute & EFI_FILE_DIRECTORY) == 0) {
-                //BREAD_CRUMB(L"%s:  2a 7b 1a 1 - FOR LOOP:- BREAK ... EFI_FILE_DIRECTORY == 0", FuncTag);
-                //LOG_SEP(L"X");
 
-                break;
-            }
+        // Contents need not be preserved ... The entry is read again
+        MY_FREE_POOL(DirIter->Buffer);
+        DirIter->BufferSize = 0;
+        DirIter->Buffer     = AllocatePool (BufferSize);
+        if (DirIter->Buffer == NULL) {
+            return EFI_BAD_BUFFER_SIZE;
         }
+        DirIter->BufferSize = BufferSize;
+    } // for IterCount = 0
 
-        //BREAD_CRUMB(L"%s:  3a 8 - FOR LOOP:- END ... No Filter or Unknown Filter", FuncTag);
-        //LOG_SEP(L"X");
-
-        // No Filter or Unknown Filter -> Return Everything
-    } // for ;;
+    if (EFI_ERROR(Status)) {
+        return Status;
+    }
 
-    //BREAD_CRUMB(L"%s:  3 - END:- return EFI_STATUS Status = '%r'", FuncTag,
-    //    Status
-    //);
-    //LOG_DECREMENT();
-    //LOG_SEP(L"X");
+    // BufferSize is zero at the end of the listing
+    if (BufferSize > 0) {
+        *DirEntry  = (EFI_FILE_INFO *) DirIter->Buffer;
+        *EntrySize = BufferSize;
+    }
 
-    return Status;
-} // EFI_STATUS DirNextEntry()
+    return EFI_SUCCESS;
+} // static EFI_STATUS DirReadEntry()
 
 VOID DirIterOpen (
     IN  EFI_FILE        *BaseDir,
@@ -3447,6 +3604,13 @@ VOID DirIterOpen (
     LOG_INCREMENT();
     BREAD_CRUMB(L"%s:  1 - START", FuncTag);
 
+    DirIter->Buffer        = NULL;
+    DirIter->BufferSize    = 0;
+    DirIter->BatchData     = NULL;
+    DirIter->BatchDataSize = 0;
+    DirIter->PatternSource = NULL;
+    DirIter->Patterns      = NULL;
+    DirIter->PatternCount  = 0;
 
     BREAD_CRUMB(L"%s:  2", FuncTag);
     if (RelativePath == NULL) {
@@ -3511,15 +3675,82 @@ BOOLEAN RP_MetaiMatch (
 #endif
 } // static BOOLEAN RP_MetaiMatch()
 
+// Splits a comma delimited pattern list once per iterator rather than
+// once per directory entry.
+static
+VOID DirIterSplitPatterns (
+    IN OUT REFIT_DIR_ITER *DirIter,
+    IN     CHAR16         *FilePattern
+) {
+    UINTN   i;
+    UINTN   MaxCount;
+    CHAR16 *OnePattern;
+
+    DirIterFreePatterns (DirIter);
+
+    MaxCount = 1;
+    for (i = 0; FilePattern[i] != L'\0'; i++) {
+        if (FilePattern[i] == L',') {
+            MaxCount++;
+        }
+    }
+
+    DirIter->Patterns = AllocatePool (MaxCount * sizeof (CHAR16 *));
+    if (DirIter->Patterns == NULL) {
+        return;
+    }
+
+    while (DirIter->PatternCount < MaxCount &&
+        (OnePattern = FindCommaDelimited (FilePattern, DirIter->PatternCount)) != NULL
+    ) {
+        DirIter->Patterns[DirIter->PatternCount++] = OnePattern;
+    }
+    DirIter->PatternSource = StrDuplicate (FilePattern);
+} // static VOID DirIterSplitPatterns()
+
+// Applies FilterMode and FilePattern to an entry still in the read buffer,
+// so entries that are not wanted are never copied out.
+static
+BOOLEAN DirIterMatch (
+    IN OUT REFIT_DIR_ITER *DirIter,
+    IN     UINTN           FilterMode,
+    IN     CHAR16         *FilePattern OPTIONAL,
+    IN     EFI_FILE_INFO  *DirEntry
+) {
+    UINTN   i;
+    BOOLEAN IsDir;
+
+    IsDir = (DirEntry->Attribute & EFI_FILE_DIRECTORY) ? TRUE : FALSE;
+    if ((FilterMode == 1 && !IsDir) || (FilterMode == 2 && IsDir)) {
+        return FALSE;
+    }
+
+    if (FilePattern == NULL || IsDir) {
+        return TRUE;
+    }
+
+    if (DirIter->PatternSource == NULL ||
+        StrCmp (DirIter->PatternSource, FilePattern) != 0
+    ) {
+        DirIterSplitPatterns (DirIter, FilePattern);
+    }
+
+    for (i = 0; i < DirIter->PatternCount; i++) {
+        if (RP_MetaiMatch (DirEntry->FileName, DirIter->Patterns[i])) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+} // static BOOLEAN DirIterMatch()
+
 BOOLEAN DirIterNext (
     IN  OUT REFIT_DIR_ITER  *DirIter,
     IN      UINTN            FilterMode,
     IN      CHAR16          *FilePattern OPTIONAL,
     OUT     EFI_FILE_INFO  **DirEntry
 ) {
-    UINTN          i;
-    BOOLEAN        Found;
-    CHAR16        *OnePattern;
+    UINTN          EntrySize;
     EFI_FILE_INFO *LastFileInfo;
 
     #if REFIT_DEBUG > 1
@@ -3542,74 +3773,135 @@ BOOLEAN DirIterNext (
 
     BREAD_CRUMB(L"%s:  3", FuncTag);
     for (;;) {
-        //LOG_SEP(L"X");
-        //BREAD_CRUMB(L"%s:  3a 1 - FOR LOOP:- START", FuncTag);
-
-        //BREAD_CRUMB(L"%s:  3a 2", FuncTag);
-        DirIter->LastStatus = DirNextEntry (
-            DirIter->DirHandle,
-            &LastFileInfo,
-            FilterMode
-        );
-
-        //BREAD_CRUMB(L"%s:  3a 3", FuncTag);
+        DirIter->LastStatus = DirReadEntry (DirIter, &LastFileInfo, &EntrySize);
         if (EFI_ERROR(DirIter->LastStatus) || LastFileInfo == NULL) {
-            BREAD_CRUMB(L"%s:  3a 3a 1 - END:- return BOOLEAN FALSE ... ERROR DirIter->LastStatus", FuncTag);
+            BREAD_CRUMB(L"%s:  3a 1 - END:- return BOOLEAN FALSE ... End of Listing or DirIter->LastStatus Error", FuncTag);
             LOG_DECREMENT();
             LOG_SEP(L"X");
 
+            DirIterRelease (DirIter);
+
             return FALSE;
         }
 
-        //BREAD_CRUMB(L"%s:  3a 4", FuncTag);
-        if (FilePattern == NULL || LastFileInfo->Attribute & EFI_FILE_DIRECTORY) {
-            //BREAD_CRUMB(L"%s:  3a 4a 1 - END:- FilePattern == NULL ... return BOOLEAN TRUE", FuncTag);
-            //LOG_DECREMENT();
-            //LOG_SEP(L"X");
-
-            *DirEntry = LastFileInfo;
-            return TRUE;
+        // Only entries that pass the filter are copied out of the read buffer
+        if (DirIterMatch (DirIter, FilterMode, FilePattern, LastFileInfo)) {
+            break;
         }
+    } // for
 
-        //BREAD_CRUMB(L"%s:  3a 5", FuncTag);
-        i     =     0;
-        Found = FALSE;
-        while (!Found && (OnePattern = FindCommaDelimited (FilePattern, i++)) != NULL) {
-            //LOG_SEP(L"X");
-            //BREAD_CRUMB(L"%s:  3a 5a 1 - WHILE LOOP:- START", FuncTag);
-
-            //BREAD_CRUMB(L"%s:  3a 5a 2", FuncTag);
-            if (RP_MetaiMatch (LastFileInfo->FileName, OnePattern)) {
-                //BREAD_CRUMB(L"%s:  3a 5a 2a 1", FuncTag);
-                Found = TRUE;
-            }
-            MY_FREE_POOL(OnePattern);
-            //BREAD_CRUMB(L"%s:  3a 5a 3 - WHILE LOOP:- END", FuncTag);
-            //LOG_SEP(L"X");
-        } // while
+    BREAD_CRUMB(L"%s:  4", FuncTag);
+    *DirEntry = AllocateCopyPool (EntrySize, LastFileInfo);
+    if (*DirEntry == NULL) {
+        BREAD_CRUMB(L"%s:  4a 1 - END:- return BOOLEAN FALSE ... Out of Resources", FuncTag);
+        LOG_DECREMENT();
+        LOG_SEP(L"X");
 
-        //BREAD_CRUMB(L"%s:  3a 6", FuncTag);
-        if (Found) {
-            //BREAD_CRUMB(L"%s:  3a 6 - END:- Found == TRUE ... return BOOLEAN TRUE", FuncTag);
-            //LOG_DECREMENT();
-            //LOG_SEP(L"X");
+        DirIter->LastStatus = EFI_OUT_OF_RESOURCES;
+        DirIterRelease (DirIter);
 
-            *DirEntry = LastFileInfo;
-            return TRUE;
-        }
-        //BREAD_CRUMB(L"%s:  3a 7", FuncTag);
-        MY_FREE_POOL(LastFileInfo);
+        return FALSE;
+    }
 
-        //BREAD_CRUMB(L"%s:  3a 6 - FOR LOOP:- END", FuncTag);
-        //LOG_SEP(L"X");
-    } // for
-    BREAD_CRUMB(L"%s:  4 - END:- return BOOLEAN TRUE", FuncTag);
+    BREAD_CRUMB(L"%s:  5 - END:- return BOOLEAN TRUE", FuncTag);
     LOG_DECREMENT();
     LOG_SEP(L"X");
 
     return TRUE;
 } // BOOLEAN DirIterNext()
 
+// Returns up to MaxEntries matching entries in a single pool allocation.
+// The result is an array of *Count EFI_FILE_INFO pointers followed by the
+// entries themselves, so a whole batch is released with one MY_FREE_POOL
+// on the returned array. Returns NULL, with *Count set to 0, once the
+// listing is exhausted or on error; DirIterClose then reports the status.
+EFI_FILE_INFO ** DirIterNextBatch (
+    IN  OUT REFIT_DIR_ITER  *DirIter,
+    IN      UINTN            FilterMode,
+    IN      CHAR16          *FilePattern OPTIONAL,
+    IN      UINTN            MaxEntries,
+    OUT     UINTN           *Count
+) {
+    UINTN            i;
+    UINTN            Used;
+    UINTN            Needed;
+    UINTN            NewSize;
+    UINTN            Offset;
+    UINTN            EntrySize;
+    UINTN            TableSize;
+    UINT8           *Data;
+    VOID            *NewData;
+    EFI_FILE_INFO   *LastFileInfo;
+    EFI_FILE_INFO  **Batch;
+
+    *Count = 0;
+    if (MaxEntries == 0 || EFI_ERROR(DirIter->LastStatus)) {
+        return NULL;
+    }
+
+    // Matching entries are staged back to back, each preceded by its
+    // padded size, in a buffer that is reused from batch to batch
+    Used = 0;
+    while (*Count < MaxEntries) {
+        DirIter->LastStatus = DirReadEntry (DirIter, &LastFileInfo, &EntrySize);
+        if (EFI_ERROR(DirIter->LastStatus) || LastFileInfo == NULL) {
+            break;
+        }
+
+        if (!DirIterMatch (DirIter, FilterMode, FilePattern, LastFileInfo)) {
+            continue;
+        }
+
+        Needed = sizeof (UINTN) + ((EntrySize + 7) & ~((UINTN) 7));
+        if (Used + Needed > DirIter->BatchDataSize) {
+            NewSize = DirIter->BatchDataSize ? DirIter->BatchDataSize * 2 : DIR_ITER_BUFFER_SIZE * 8;
+            while (NewSize < Used + Needed) {
+                NewSize *= 2;
+            }
+
+            NewData = EfiReallocatePool (DirIter->BatchData, Used, NewSize);
+            DirIter->BatchData     = NewData;
+            DirIter->BatchDataSize = (NewData != NULL) ? NewSize : 0;
+            if (NewData == NULL) {
+                DirIter->LastStatus = EFI_OUT_OF_RESOURCES;
+                break;
+            }
+        }
+
+        Data = (UINT8 *) DirIter->BatchData + Used;
+        *(UINTN *) Data = Needed;
+        CopyMem (Data + sizeof (UINTN), LastFileInfo, EntrySize);
+        Used += Needed;
+        (*Count)++;
+    } // while
+
+    Batch = NULL;
+    if (*Count > 0 && !EFI_ERROR(DirIter->LastStatus)) {
+        TableSize = ((*Count * sizeof (EFI_FILE_INFO *)) + 7) & ~((UINTN) 7);
+        Batch     = AllocatePool (TableSize + Used);
+        if (Batch == NULL) {
+            DirIter->LastStatus = EFI_OUT_OF_RESOURCES;
+        }
+        else {
+            Data = (UINT8 *) Batch + TableSize;
+            CopyMem (Data, DirIter->BatchData, Used);
+
+            Offset = 0;
+            for (i = 0; i < *Count; i++) {
+                Batch[i] = (EFI_FILE_INFO *) (Data + Offset + sizeof (UINTN));
+                Offset  += *(UINTN *) (Data + Offset);
+            }
+        }
+    }
+
+    if (Batch == NULL) {
+        *Count = 0;
+        DirIterRelease (DirIter);
+    }
+
+    return Batch;
+} // EFI_FILE_INFO ** DirIterNextBatch()
+
 EFI_STATUS DirIterClose (
     IN OUT REFIT_DIR_ITER *DirIter
 ) {
@@ -3627,6 +3919,9 @@ EFI_STATUS DirIterClose (
         REFIT_CALL_1_WRAPPER(DirIter->DirHandle->Close, DirIter->DirHandle);
     }
 
+    // Covers iterations abandoned before the end of the listing
+    DirIterRelease (DirIter);
+
     BREAD_CRUMB(L"%s:  3 - END:- return EFI_STATUS DirIter->LastStatus = '%r'", FuncTag,
         DirIter->LastStatus
     );
@@ -71,10 +71,22 @@
 
 // types
 
+// Initial size of the per-iterator directory read buffer and
+// default number of entries returned by DirIterNextBatch
+#define DIR_ITER_BUFFER_SIZE  (512)
+#define DIR_ITER_BATCH_SIZE   (16)
+
 typedef struct {
     EFI_STATUS          LastStatus;
     EFI_FILE_HANDLE     DirHandle;
     BOOLEAN             CloseDirHandle;
+    VOID               *Buffer;         // Reused for every Directory->Read
+    UINTN               BufferSize;
+    VOID               *BatchData;      // Staging area for DirIterNextBatch
+    UINTN               BatchDataSize;
+    CHAR16             *PatternSource;  // FilePattern the split list below came from
+    CHAR16            **Patterns;
+    UINTN               PatternCount;
 } REFIT_DIR_ITER;
 
 #define DISK_KIND_INTERNAL  (0)
@@ -195,5 +207,14 @@ BOOLEAN DirIterNext (
     OUT     EFI_FILE_INFO  **DirEntry
 );
 
+
+EFI_FILE_INFO ** DirIterNextBatch (
+    IN  OUT REFIT_DIR_ITER  *DirIter,
+    IN      UINTN            FilterMode,
+    IN      CHAR16          *FilePattern OPTIONAL,
+    IN      UINTN            MaxEntries,
+    OUT     UINTN           *Count
+);
+
 REFIT_VOLUME * CopyVolume (IN REFIT_VOLUME *VolumeToCopy);
 #endif
@@ -112,6 +112,7 @@ REFIT_CONFIG GlobalConfig = {
     /* DisableAMFI = */ FALSE,
     /* NvramProtectEx = */ FALSE,
     /* FollowSymlinks = */ FALSE,
+    /* ScanCache = */ FALSE,
     /* PreferUGA = */ FALSE,
     /* SupplyNVME = */ FALSE,
     /* SupplyAPFS = */ TRUE,
@@ -2725,9 +2726,17 @@ EFI_STATUS EFIAPI efi_main (
     }
 
     // Continue Bootstrap
+    PROF_BEGIN(SpanVolumeIcons, "SetVolumeIcons");
     SetVolumeIcons();
+    PROF_END(SpanVolumeIcons);
+
+    PROF_BEGIN(SpanLoaders, "ScanForBootloaders");
     ScanForBootloaders();
+    PROF_END(SpanLoaders);
+
+    PROF_BEGIN(SpanTools, "ScanForTools");
     ScanForTools();
+    PROF_END(SpanTools);
 
     if (GlobalConfig.ShutdownAfterTimeout) {
         MainMenu->TimeoutText = StrDuplicate (L"Shutdown");
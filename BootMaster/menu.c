@@ -1882,6 +1882,7 @@ VOID GraphicsMenuStyle (
         break;
         case MENU_FUNCTION_PAINT_SELECTION:
             // Redraw selection cursor
+            egBeginScreenBatch();
             DrawText (
                 Screen->Entries[State->PreviousSelection]->Title,
                 FALSE, LineWidth,
@@ -1895,6 +1896,7 @@ VOID GraphicsMenuStyle (
                 EntriesPosX,
                 EntriesPosY + State->CurrentSelection * TextLineHeight()
             );
+            egEndScreenBatch();
 
         break;
         case MENU_FUNCTION_PAINT_TIMEOUT:
@@ -1932,6 +1934,17 @@ VOID DrawMainMenuEntry (
         return;
     }
 
+    // Compose in the back buffer when inside a screen batch
+    if (egDrawImageOnBase (
+            SelectionImages[Entry->Row],
+            Entry->Image, Entry->BadgeImage,
+            XPos, YPos
+        )
+    ) {
+        // Early Return
+        return;
+    }
+
     Background = egCropImage (
         GlobalConfig.ScreenBackground,
         XPos, YPos,
@@ -2326,28 +2339,35 @@ VOID MainMenuStyle (
         break;
         case MENU_FUNCTION_CLEANUP:
             MY_FREE_POOL(itemPosX);
+            egFreeBackBuffer();
 
         break;
         case MENU_FUNCTION_PAINT_ALL:
+            egBeginScreenBatch();
             PaintAll (Screen, State, itemPosX, row0PosY, row1PosY, textPosY);
             // For PaintArrows(), the starting Y position is moved to the midpoint
             // of the surrounding row; PaintIcon() adjusts this back up by half the
             // icon's height to properly center it.
             PaintArrows (State, row0PosX - TILE_XSPACING, row0PosY + (TileSizes[0] / 2), row0Loaders);
+            egEndScreenBatch();
 
         break;
         case MENU_FUNCTION_PAINT_SELECTION:
+            egBeginScreenBatch();
             PaintSelection (Screen, State, itemPosX, row0PosY, row1PosY, textPosY);
+            egEndScreenBatch();
 
         break;
         case MENU_FUNCTION_PAINT_TIMEOUT:
             if (!(GlobalConfig.HideUIFlags & HIDEUI_FLAG_LABEL)) {
+               egBeginScreenBatch();
                DrawTextWithTransparency (L"", 0, textPosY + TextLineHeight());
                DrawTextWithTransparency (
                    ParamText,
                    (ScreenW - egComputeTextWidth (ParamText)) >> 1,
                    textPosY + TextLineHeight()
                );
+               egEndScreenBatch();
             }
 
         break;
@@ -3318,6 +3338,13 @@ UINTN RunMainMenu (
     // Save time elaspsed from start til now
     MainMenuLoad = GetCurrentMS();
 
+    #if REFIT_DEBUG > 0
+    egLogDecoderStats();
+
+    // Boot profile up to the menu ... Next to the log file
+    SaveProfileToDebugLogFile();
+    #endif
+
     BREAD_CRUMB(L"%s:  9", FuncTag);
     do {
         LOG_SEP(L"X");
@@ -104,10 +104,21 @@ extern BOOLEAN gKernelStarted;
     do {                                                \
         if (!gKernelStarted) {                          \
             if (Image != NULL) {                        \
-                if (Image->PixelData != NULL) {         \
-                    FreePool (Image->PixelData);        \
-                    Image->PixelData = NULL;            \
+                if (Image->ShareCount != NULL &&        \
+                    *(Image->ShareCount) > 1            \
+                ) {                                     \
+                    *(Image->ShareCount) -= 1;          \
                 }                                       \
+                else {                                  \
+                    if (Image->PixelData != NULL) {     \
+                        FreePool (Image->PixelData);    \
+                    }                                   \
+                    if (Image->ShareCount != NULL) {    \
+                        FreePool (Image->ShareCount);   \
+                    }                                   \
+                }                                       \
+                Image->PixelData  = NULL;               \
+                Image->ShareCount = NULL;               \
                 FreePool (Image);                       \
                 Image = NULL;                           \
             }                                           \
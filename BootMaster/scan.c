@@ -62,6 +62,7 @@
 #include "linux.h"
 #include "scan.h"
 #include "install.h"
+#include "crc32.h"
 #include "../include/refit_call_wrapper.h"
 
 
@@ -114,6 +115,7 @@
 EFI_GUID GlobalGuid = EFI_GLOBAL_VARIABLE;
 
 extern EFI_GUID GuidAPFS;
+extern EFI_GUID GuidNull;
 
 #if REFIT_DEBUG > 0
 static CHAR16  *Spacer   = L"                ";
@@ -124,11 +126,12 @@ BOOLEAN  LogNewLine      = FALSE;
 BOOLEAN  ScanningLoaders = FALSE;
 BOOLEAN  FirstLoaderScan = FALSE;
 
-// Structure used to hold boot loader filenames and time stamps in
+// Structure used to hold boot loader filenames, sizes and time stamps in
 // a linked list; used to sort entries within a directory.
 struct
 LOADER_LIST {
     CHAR16              *FileName;
+    UINT64               FileSize;
     EFI_TIME             TimeStamp;
     struct LOADER_LIST  *NextEntry;
 };
@@ -1749,6 +1752,406 @@ BOOLEAN IsSymbolicLink (
     return (DirEntry->FileSize != FileSize2);
 } // BOOLEAN IsSymbolicLink()
 
+//
+// Scan cache
+//
+// When 'scan_cache' is active, the loaders found by ScanLoaderDir are recorded
+// per directory and kept in the 'ScanCache' variable. On later boots, a directory
+// whose volume identity and modification time are unchanged is not walked again
+// and its recorded loaders are used instead, provided each loader still has its
+// recorded size and modification time. Some filesystems, such as FAT, do not
+// update the directory time when a file is overwritten in place. Records for
+// directories that are not visited in a scan are dropped when the cache is
+// written back.
+//
+// Whether a loader duplicates the fallback loader depends on a file outside the
+// directory and is not recorded. ScanLoaderDir checks it again on a cache hit.
+
+#define SCAN_CACHE_VAR        L"ScanCache"
+#define SCAN_CACHE_SIGNATURE  0x43535052  // "RPSC"
+#define SCAN_CACHE_VERSION    2
+
+typedef struct {
+    UINT32    Signature;
+    UINT32    Version;
+    UINT32    ConfigCrc;    // Settings that change what ScanLoaderDir reports
+    UINT32    Size;         // Header plus all records
+} SCAN_CACHE_HEADER;
+
+// Followed by (StringCount - 2) SCAN_CACHE_LOADER items, one per loader, and
+// then StringCount null terminated strings: Path, Pattern, then the loaders in
+// the order they were added to the menu.
+typedef struct {
+    EFI_GUID  PartGuid;
+    EFI_GUID  VolUuid;
+    EFI_TIME  DirTime;
+    UINT32    Flags;        // Reserved ... Zero
+    UINT32    StringCount;
+    UINT32    Size;         // Record plus items and strings ... Multiple of 8
+    UINT32    Reserved;
+} SCAN_CACHE_RECORD;
+
+typedef struct {
+    UINT64    FileSize;
+    EFI_TIME  FileTime;
+} SCAN_CACHE_LOADER;
+
+static BOOLEAN  ScanCacheActive   = FALSE;
+static UINT32   ScanCacheCrc      = 0;
+static UINT8   *ScanCacheOld      = NULL;
+static UINTN    ScanCacheOldSize  = 0;
+static UINT8   *ScanCacheNew      = NULL;
+static UINTN    ScanCacheNewSize  = 0;
+static UINTN    ScanCacheNewAlloc = 0;
+
+// Loads the cache from the previous boot, if any, and starts a new one
+static
+VOID ScanCacheBegin (VOID) {
+    EFI_STATUS          Status;
+    SCAN_CACHE_HEADER  *Header;
+    UINT8               Setting;
+
+    if (!GlobalConfig.ScanCache || ScanCacheActive) {
+        return;
+    }
+
+    ScanCacheCrc = 0;
+    if (GlobalConfig.DontScanFiles != NULL) {
+        ScanCacheCrc = crc32refit (
+            ScanCacheCrc, GlobalConfig.DontScanFiles,
+            StrSize (GlobalConfig.DontScanFiles)
+        );
+    }
+    Setting      = (UINT8) GlobalConfig.FollowSymlinks;
+    ScanCacheCrc = crc32refit (ScanCacheCrc, &Setting, sizeof (Setting));
+
+    Status = EfivarGetRaw (
+        &RefindPlusGuid, SCAN_CACHE_VAR,
+        (VOID **) &ScanCacheOld, &ScanCacheOldSize
+    );
+    if (!EFI_ERROR(Status)) {
+        Header = (SCAN_CACHE_HEADER *) ScanCacheOld;
+        if (ScanCacheOldSize < sizeof (SCAN_CACHE_HEADER) ||
+            Header->Signature != SCAN_CACHE_SIGNATURE     ||
+            Header->Version   != SCAN_CACHE_VERSION       ||
+            Header->ConfigCrc != ScanCacheCrc             ||
+            Header->Size      != ScanCacheOldSize
+        ) {
+            #if REFIT_DEBUG > 0
+            ALT_LOG(1, LOG_LINE_NORMAL, L"Discarding Stale or Invalid Scan Cache");
+            #endif
+
+            MY_FREE_POOL(ScanCacheOld);
+        }
+    }
+    if (ScanCacheOld == NULL) {
+        ScanCacheOldSize = 0;
+    }
+
+    ScanCacheNewSize  = sizeof (SCAN_CACHE_HEADER);
+    ScanCacheNewAlloc = 0;
+    ScanCacheActive   = TRUE;
+} // static VOID ScanCacheBegin()
+
+// Writes the records gathered in this scan back and releases the cache
+static
+VOID ScanCacheEnd (VOID) {
+    EFI_STATUS          Status;
+    SCAN_CACHE_HEADER  *Header;
+
+    if (!ScanCacheActive) {
+        return;
+    }
+
+    if (ScanCacheNew != NULL) {
+        Header            = (SCAN_CACHE_HEADER *) ScanCacheNew;
+        Header->Signature = SCAN_CACHE_SIGNATURE;
+        Header->Version   = SCAN_CACHE_VERSION;
+        Header->ConfigCrc = ScanCacheCrc;
+        Header->Size      = (UINT32) ScanCacheNewSize;
+
+        // Does nothing when the content is unchanged
+        Status = EfivarSetRaw (
+            &RefindPlusGuid, SCAN_CACHE_VAR,
+            ScanCacheNew, ScanCacheNewSize, TRUE
+        );
+        if (Status != EFI_ALREADY_STARTED) {
+            CheckError (Status, L"in ScanCacheEnd!!");
+        }
+    }
+
+    MY_FREE_POOL(ScanCacheOld);
+    MY_FREE_POOL(ScanCacheNew);
+    ScanCacheOldSize  = 0;
+    ScanCacheNewSize  = 0;
+    ScanCacheNewAlloc = 0;
+    ScanCacheActive   = FALSE;
+} // static VOID ScanCacheEnd()
+
+// Gets the modification time of a directory. Returns FALSE if the directory
+// cannot be opened or its filesystem does not keep directory times.
+static
+BOOLEAN ScanCacheDirTime (
+    IN  REFIT_VOLUME *Volume,
+    IN  CHAR16       *Path,
+    OUT EFI_TIME     *DirTime
+) {
+    EFI_STATUS      Status;
+    EFI_FILE       *DirHandle;
+    EFI_FILE_INFO  *DirInfo;
+    BOOLEAN         Valid = FALSE;
+
+    if (Volume->RootDir == NULL || Path == NULL) {
+        return FALSE;
+    }
+
+    // Volumes without an identity cannot be matched on the next boot
+    if (GuidsAreEqual (&(Volume->PartGuid), &GuidNull) &&
+        GuidsAreEqual (&(Volume->VolUuid),  &GuidNull)
+    ) {
+        return FALSE;
+    }
+
+    Status = REFIT_CALL_5_WRAPPER(
+        Volume->RootDir->Open, Volume->RootDir,
+        &DirHandle, Path,
+        EFI_FILE_MODE_READ, 0
+    );
+    if (EFI_ERROR(Status)) {
+        return FALSE;
+    }
+
+    DirInfo = LibFileInfo (DirHandle);
+    if (DirInfo != NULL) {
+        if ((DirInfo->Attribute & EFI_FILE_DIRECTORY) && DirInfo->ModificationTime.Year != 0) {
+            *DirTime = DirInfo->ModificationTime;
+            Valid    = TRUE;
+        }
+        MY_FREE_POOL(DirInfo);
+    }
+    REFIT_CALL_1_WRAPPER(DirHandle->Close, DirHandle);
+
+    return Valid;
+} // static BOOLEAN ScanCacheDirTime()
+
+// Returns the string following String in a record, or NULL if String
+// is not terminated before RecordEnd
+static
+CHAR16 * ScanCacheNextString (
+    IN CHAR16 *String,
+    IN UINT8  *RecordEnd
+) {
+    while ((UINT8 *) (String + 1) <= RecordEnd) {
+        if (*String++ == L'\0') {
+            return String;
+        }
+    }
+
+    return NULL;
+} // static CHAR16 * ScanCacheNextString()
+
+// Returns TRUE if a recorded loader still exists with its recorded size
+// and modification time
+static
+BOOLEAN ScanCacheLoaderUnchanged (
+    IN REFIT_VOLUME       *Volume,
+    IN CHAR16             *FileName,
+    IN SCAN_CACHE_LOADER  *Item
+) {
+    EFI_STATUS      Status;
+    EFI_FILE       *FileHandle;
+    EFI_FILE_INFO  *FileInfo;
+    BOOLEAN         Unchanged = FALSE;
+
+    Status = REFIT_CALL_5_WRAPPER(
+        Volume->RootDir->Open, Volume->RootDir,
+        &FileHandle, FileName,
+        EFI_FILE_MODE_READ, 0
+    );
+    if (EFI_ERROR(Status)) {
+        return FALSE;
+    }
+
+    FileInfo = LibFileInfo (FileHandle);
+    if (FileInfo != NULL) {
+        Unchanged = (
+            !(FileInfo->Attribute & EFI_FILE_DIRECTORY) &&
+            FileInfo->FileSize == Item->FileSize        &&
+            CompareMem (&(FileInfo->ModificationTime), &(Item->FileTime), sizeof (EFI_TIME)) == 0
+        );
+        MY_FREE_POOL(FileInfo);
+    }
+    REFIT_CALL_1_WRAPPER(FileHandle->Close, FileHandle);
+
+    return Unchanged;
+} // static BOOLEAN ScanCacheLoaderUnchanged()
+
+// Looks up a directory in the previous cache. On a hit, returns TRUE with the
+// recorded loaders, in their original order, in *LoaderList. A record is not
+// used if any of its loaders has changed size or modification time.
+static
+BOOLEAN ScanCacheLookup (
+    IN  REFIT_VOLUME         *Volume,
+    IN  CHAR16               *Path,
+    IN  CHAR16               *Pattern,
+    IN  EFI_TIME             *DirTime,
+    OUT struct LOADER_LIST  **LoaderList
+) {
+    UINTN                Offset;
+    UINTN                Index;
+    UINTN                ItemsSize;
+    UINT8               *RecordEnd;
+    CHAR16              *String;
+    CHAR16              *NextString;
+    SCAN_CACHE_RECORD   *Record;
+    SCAN_CACHE_LOADER   *Item;
+    struct LOADER_LIST  *NewLoader;
+    struct LOADER_LIST  *LastLoader;
+
+    *LoaderList = NULL;
+
+    Offset = sizeof (SCAN_CACHE_HEADER);
+    while (ScanCacheOld != NULL && Offset + sizeof (SCAN_CACHE_RECORD) <= ScanCacheOldSize) {
+        Record = (SCAN_CACHE_RECORD *) (ScanCacheOld + Offset);
+        if (Record->Size < sizeof (SCAN_CACHE_RECORD) || Record->Size > ScanCacheOldSize - Offset) {
+            // Corrupt ... Ignore the rest
+            break;
+        }
+        Offset   += Record->Size;
+        RecordEnd = (UINT8 *) Record + Record->Size;
+
+        if (Record->StringCount < 2                                                   ||
+            !GuidsAreEqual (&(Record->PartGuid), &(Volume->PartGuid))                 ||
+            !GuidsAreEqual (&(Record->VolUuid),  &(Volume->VolUuid))                  ||
+            CompareMem (&(Record->DirTime), DirTime, sizeof (EFI_TIME)) != 0
+        ) {
+            continue;
+        }
+
+        // Items must leave room for the strings
+        if ((Record->StringCount - 2) >=
+            (Record->Size - sizeof (SCAN_CACHE_RECORD)) / sizeof (SCAN_CACHE_LOADER)
+        ) {
+            continue;
+        }
+        ItemsSize = (Record->StringCount - 2) * sizeof (SCAN_CACHE_LOADER);
+
+        Item       = (SCAN_CACHE_LOADER *) (Record + 1);
+        String     = (CHAR16 *) ((UINT8 *) Item + ItemsSize);
+        NextString = ScanCacheNextString (String, RecordEnd);
+        if (NextString == NULL || !MyStriCmp (String, Path)) {
+            continue;
+        }
+
+        String     = NextString;
+        NextString = ScanCacheNextString (String, RecordEnd);
+        if (NextString == NULL || !MyStriCmp (String, Pattern)) {
+            continue;
+        }
+
+        LastLoader = NULL;
+        for (Index = 2; Index < Record->StringCount; Index++) {
+            String     = NextString;
+            NextString = ScanCacheNextString (String, RecordEnd);
+            NewLoader  = (NextString != NULL && ScanCacheLoaderUnchanged (Volume, String, Item))
+                ? AllocateZeroPool (sizeof (struct LOADER_LIST)) : NULL;
+            if (NewLoader == NULL) {
+                CleanUpLoaderList (*LoaderList);
+                *LoaderList = NULL;
+
+                return FALSE;
+            }
+
+            NewLoader->FileName  = StrDuplicate (String);
+            NewLoader->FileSize  = Item->FileSize;
+            NewLoader->TimeStamp = Item->FileTime;
+            Item++;
+            if (LastLoader == NULL) {
+                *LoaderList = NewLoader;
+            }
+            else {
+                LastLoader->NextEntry = NewLoader;
+            }
+            LastLoader = NewLoader;
+        } // for
+
+        return TRUE;
+    } // while
+
+    return FALSE;
+} // static BOOLEAN ScanCacheLookup()
+
+// Adds a directory and the loaders found in it to the new cache
+static
+VOID ScanCacheStore (
+    IN REFIT_VOLUME        *Volume,
+    IN CHAR16              *Path,
+    IN CHAR16              *Pattern,
+    IN EFI_TIME            *DirTime,
+    IN struct LOADER_LIST  *LoaderList
+) {
+    UINTN                Size;
+    UINTN                NewAlloc;
+    UINT8               *NewBuffer;
+    CHAR16              *String;
+    SCAN_CACHE_RECORD   *Record;
+    SCAN_CACHE_LOADER   *Item;
+    struct LOADER_LIST  *Loader;
+
+    Size = sizeof (SCAN_CACHE_RECORD) + StrSize (Path) + StrSize (Pattern);
+    for (Loader = LoaderList; Loader != NULL; Loader = Loader->NextEntry) {
+        Size += sizeof (SCAN_CACHE_LOADER) + StrSize (Loader->FileName);
+    }
+    Size = (Size + 7) & ~((UINTN) 7);
+
+    if (ScanCacheNewSize + Size > ScanCacheNewAlloc) {
+        NewAlloc = (ScanCacheNewAlloc > 0) ? ScanCacheNewAlloc * 2 : 4096;
+        while (NewAlloc < ScanCacheNewSize + Size) {
+            NewAlloc *= 2;
+        }
+
+        NewBuffer = AllocateZeroPool (NewAlloc);
+        if (NewBuffer == NULL) {
+            return;
+        }
+        if (ScanCacheNew != NULL) {
+            CopyMem (NewBuffer, ScanCacheNew, ScanCacheNewSize);
+            MY_FREE_POOL(ScanCacheNew);
+        }
+        ScanCacheNew      = NewBuffer;
+        ScanCacheNewAlloc = NewAlloc;
+    }
+
+    Record              = (SCAN_CACHE_RECORD *) (ScanCacheNew + ScanCacheNewSize);
+    Record->PartGuid    = Volume->PartGuid;
+    Record->VolUuid     = Volume->VolUuid;
+    Record->DirTime     = *DirTime;
+    Record->Flags       = 0;
+    Record->StringCount = 2;
+    Record->Size        = (UINT32) Size;
+    Record->Reserved    = 0;
+
+    Item = (SCAN_CACHE_LOADER *) (Record + 1);
+    for (Loader = LoaderList; Loader != NULL; Loader = Loader->NextEntry) {
+        Item->FileSize = Loader->FileSize;
+        Item->FileTime = Loader->TimeStamp;
+        Item++;
+    }
+
+    String = (CHAR16 *) Item;
+    CopyMem (String, Path, StrSize (Path));
+    String += StrLen (Path) + 1;
+    CopyMem (String, Pattern, StrSize (Pattern));
+    String += StrLen (Pattern) + 1;
+    for (Loader = LoaderList; Loader != NULL; Loader = Loader->NextEntry) {
+        CopyMem (String, Loader->FileName, StrSize (Loader->FileName));
+        String += StrLen (Loader->FileName) + 1;
+        Record->StringCount++;
+    }
+
+    ScanCacheNewSize += Size;
+} // static VOID ScanCacheStore()
+
 // Scan an individual directory for EFI boot loader files and, if found,
 // add them to the list. Exception: Ignores FALLBACK_FULLNAME, which is picked
 // up in ScanEfiFiles(). Sorts the entries within the loader directory so that
@@ -1770,9 +2173,12 @@ BOOLEAN ScanLoaderDir (
     struct LOADER_LIST      *LoaderList  = NULL;
     LOADER_ENTRY            *FirstKernel = NULL;
     LOADER_ENTRY            *LatestEntry = NULL;
+    EFI_TIME                 DirTime;
     BOOLEAN                  FoundFallbackDuplicate = FALSE;
     BOOLEAN                  InSelfPath;
     BOOLEAN                  IsLinux;
+    BOOLEAN                  Cacheable = FALSE;
+    BOOLEAN                  CacheHit  = FALSE;
 
     #if REFIT_DEBUG > 1
     CHAR16 *FuncTag = L"ScanLoaderDir";
@@ -1796,12 +2202,38 @@ BOOLEAN ScanLoaderDir (
         (!InSelfPath)) && (ShouldScan (Volume, Path))
     ) {
         //BREAD_CRUMB(L"%s:  2a 1", FuncTag);
+        // Use the loaders recorded on an earlier boot if the directory is unchanged
+        if (ScanCacheActive && Path != NULL && Pattern != NULL) {
+            Cacheable = ScanCacheDirTime (Volume, Path, &DirTime);
+            if (Cacheable) {
+                CacheHit = ScanCacheLookup (
+                    Volume, Path, Pattern, &DirTime,
+                    &LoaderList
+                );
+            }
+
+            if (CacheHit) {
+                #if REFIT_DEBUG > 0
+                ALT_LOG(1, LOG_LINE_NORMAL, L"Using Cached Scan Results for '%s'", Path);
+                #endif
+
+                // The fallback loader is outside this directory and may have changed
+                for (NewLoader = LoaderList; NewLoader != NULL; NewLoader = NewLoader->NextEntry) {
+                    if (DuplicatesFallback (Volume, NewLoader->FileName)) {
+                        FoundFallbackDuplicate = TRUE;
+                    }
+                }
+            }
+        }
+
         // Look through contents of the directory
-        DirIterOpen (Volume->RootDir, Path, &DirIter);
+        if (!CacheHit) {
+            DirIterOpen (Volume->RootDir, Path, &DirIter);
+        }
 
         //BREAD_CRUMB(L"%s:  2a 2", FuncTag);
         BOOLEAN SkipDir;
-        while (DirIterNext (&DirIter, 2, Pattern, &DirEntry)) {
+        while (!CacheHit && DirIterNext (&DirIter, 2, Pattern, &DirEntry)) {
             //LOG_SEP(L"X");
             //BREAD_CRUMB(L"%s:  2a 2a 1 - WHILE LOOP:- START", FuncTag);
             Extension = FindExtension (DirEntry->FileName);
@@ -1873,6 +2305,7 @@ BOOLEAN ScanLoaderDir (
             if (NewLoader != NULL) {
                 //BREAD_CRUMB(L"%s:  2a 2a 8a 1", FuncTag);
                 NewLoader->FileName  = StrDuplicate (FullName);
+                NewLoader->FileSize  = DirEntry->FileSize;
                 NewLoader->TimeStamp = DirEntry->ModificationTime;
                 LoaderList           = AddLoaderListEntry (LoaderList, NewLoader);
 
@@ -1882,6 +2315,11 @@ BOOLEAN ScanLoaderDir (
                 }
             }
 
+            if (NewLoader == NULL || NewLoader->FileName == NULL) {
+                // Loader dropped ... Do not record the incomplete list
+                Cacheable = FALSE;
+            }
+
             //BREAD_CRUMB(L"%s:  2a 2a 8", FuncTag);
             MY_FREE_POOL(Extension);
             MY_FREE_POOL(FullName);
@@ -1892,6 +2330,15 @@ BOOLEAN ScanLoaderDir (
         } // while
 
         //BREAD_CRUMB(L"%s:  2a 3", FuncTag);
+        // Only record complete listings ... A failed open or read would
+        // otherwise be replayed for as long as the directory time is unchanged
+        if (Cacheable && (CacheHit || !EFI_ERROR(DirIter.LastStatus))) {
+            ScanCacheStore (
+                Volume, Path, Pattern, &DirTime,
+                LoaderList
+            );
+        }
+
         if (LoaderList != NULL) {
             IsLinux   = FALSE;
             NewLoader = LoaderList;
@@ -1951,7 +2398,7 @@ BOOLEAN ScanLoaderDir (
         }
 
         //BREAD_CRUMB(L"%s:  2a 4", FuncTag);
-        Status = DirIterClose (&DirIter);
+        Status = (CacheHit) ? EFI_SUCCESS : DirIterClose (&DirIter);
         // NOTE: EFI_INVALID_PARAMETER really is an error that should be reported;
         // but reports have been received from users that get this error occasionally
         // but nothing wrong has been found or the problem reproduced. It is therefore
@@ -2121,7 +2568,9 @@ VOID ScanEfiFiles (
     EFI_STATUS        Status;
     REFIT_DIR_ITER    EfiDirIter;
     EFI_FILE_INFO    *EfiDirEntry;
-    UINTN             i, Length;
+    EFI_FILE_INFO   **EfiDirBatch;
+    UINTN             i, j, Length;
+    UINTN             EfiDirCount;
     CHAR16           *Temp;
     CHAR16           *FileName;
     CHAR16           *SelfPath;
@@ -2431,60 +2880,64 @@ VOID ScanEfiFiles (
     //BREAD_CRUMB(L"%s:  9a 1", FuncTag);
     CHAR16  *Extension;
     BOOLEAN  SkipDir;
-    while (DirIterNext (&EfiDirIter, 1, NULL, &EfiDirEntry)) {
-        Extension = FindExtension (EfiDirEntry->FileName);
+    // Read the vendor directories in batches rather than one allocation per entry
+    while ((EfiDirBatch = DirIterNextBatch (&EfiDirIter, 1, NULL, DIR_ITER_BATCH_SIZE, &EfiDirCount)) != NULL) {
+        for (j = 0; j < EfiDirCount; j++) {
+            EfiDirEntry = EfiDirBatch[j];
+            Extension   = FindExtension (EfiDirEntry->FileName);
 
-        #if REFIT_DEBUG > 0
-        MY_MUTELOGGER_SET;
-        #endif
-        SkipDir = (
-            FindSubStr (EfiDirEntry->FileName, L"_BAK") ||
-            MyStriCmp (EfiDirEntry->FileName, L"APPLE")
-        );
-        #if REFIT_DEBUG > 0
-        MY_MUTELOGGER_OFF;
-        #endif
+            #if REFIT_DEBUG > 0
+            MY_MUTELOGGER_SET;
+            #endif
+            SkipDir = (
+                FindSubStr (EfiDirEntry->FileName, L"_BAK") ||
+                MyStriCmp (EfiDirEntry->FileName, L"APPLE")
+            );
+            #if REFIT_DEBUG > 0
+            MY_MUTELOGGER_OFF;
+            #endif
 
-        //LOG_SEP(L"X");
-        //BREAD_CRUMB(L"%s:  9a 1a 1 - WHILE LOOP:- START", FuncTag);
-        if (SkipDir                                     ||
-            EfiDirEntry->FileName[0] == '.'             ||
-            MyStriCmp (Extension, L".log")              ||
-            MyStriCmp (Extension, L".txt")              ||
-            MyStriCmp (Extension, L".png")              ||
-            MyStriCmp (Extension, L".bmp")              ||
-            MyStriCmp (Extension, L".jpg")              ||
-            MyStriCmp (Extension, L".jpeg")             ||
-            MyStriCmp (Extension, L".icns")             ||
-            MyStriCmp (EfiDirEntry->FileName, L"tools")
-        ) {
-            //BREAD_CRUMB(L"%s:  9a 1a 1a 1 - WHILE LOOP:- CONTINUE (Skipping This ... Invalid Item:- '%s')", FuncTag,
-            //    EfiDirEntry->FileName
-            //);
             //LOG_SEP(L"X");
+            //BREAD_CRUMB(L"%s:  9a 1a 1 - WHILE LOOP:- START", FuncTag);
+            if (SkipDir                                     ||
+                EfiDirEntry->FileName[0] == '.'             ||
+                MyStriCmp (Extension, L".log")              ||
+                MyStriCmp (Extension, L".txt")              ||
+                MyStriCmp (Extension, L".png")              ||
+                MyStriCmp (Extension, L".bmp")              ||
+                MyStriCmp (Extension, L".jpg")              ||
+                MyStriCmp (Extension, L".jpeg")             ||
+                MyStriCmp (Extension, L".icns")             ||
+                MyStriCmp (EfiDirEntry->FileName, L"tools")
+            ) {
+                //BREAD_CRUMB(L"%s:  9a 1a 1a 1 - WHILE LOOP:- CONTINUE (Skipping This ... Invalid Item:- '%s')", FuncTag,
+                //    EfiDirEntry->FileName
+                //);
+                //LOG_SEP(L"X");
 
-            // Skip this ... Does not contain boot loaders or is scanned later
-            MY_FREE_POOL(Extension);
-            MY_FREE_POOL(EfiDirEntry);
+                // Skip this ... Does not contain boot loaders or is scanned later
+                MY_FREE_POOL(Extension);
 
-            continue;
-        }
+                continue;
+            }
 
-        //BREAD_CRUMB(L"%s:  9a 1a 2", FuncTag);
-        FileName = PoolPrint (L"EFI\\%s", EfiDirEntry->FileName);
+            //BREAD_CRUMB(L"%s:  9a 1a 2", FuncTag);
+            FileName = PoolPrint (L"EFI\\%s", EfiDirEntry->FileName);
 
-        //BREAD_CRUMB(L"%s:  9a 1a 3", FuncTag);
-        if (ScanLoaderDir (Volume, FileName, MatchPatterns)) {
-            //BREAD_CRUMB(L"%s:  9a 1a 3a 1", FuncTag);
-            ScanFallbackLoader = FALSE;
-        }
+            //BREAD_CRUMB(L"%s:  9a 1a 3", FuncTag);
+            if (ScanLoaderDir (Volume, FileName, MatchPatterns)) {
+                //BREAD_CRUMB(L"%s:  9a 1a 3a 1", FuncTag);
+                ScanFallbackLoader = FALSE;
+            }
 
-        MY_FREE_POOL(FileName);
-        MY_FREE_POOL(Extension);
-        MY_FREE_POOL(EfiDirEntry);
+            MY_FREE_POOL(FileName);
+            MY_FREE_POOL(Extension);
 
-        //BREAD_CRUMB(L"%s:  9a 1a 4 - WHILE LOOP:- END", FuncTag);
-        //LOG_SEP(L"X");
+            //BREAD_CRUMB(L"%s:  9a 1a 4 - WHILE LOOP:- END", FuncTag);
+            //LOG_SEP(L"X");
+        } // for j = 0
+
+        MY_FREE_POOL(EfiDirBatch);
     } // while
 
     //BREAD_CRUMB(L"%s:  9a 2", FuncTag);
@@ -2587,7 +3040,9 @@ VOID ScanInternal (VOID) {
     FirstLoaderScan = TRUE;
     for (VolumeIndex = 0; VolumeIndex < VolumesCount; VolumeIndex++) {
         if (Volumes[VolumeIndex]->DiskKind == DISK_KIND_INTERNAL) {
+            PROF_BEGIN(SpanScanEfiFiles, "ScanEfiFiles");
             ScanEfiFiles (Volumes[VolumeIndex]);
+            PROF_END(SpanScanEfiFiles);
         }
     } // for
 
@@ -2618,7 +3073,9 @@ VOID ScanExternal (VOID) {
     FirstLoaderScan = TRUE;
     for (VolumeIndex = 0; VolumeIndex < VolumesCount; VolumeIndex++) {
         if (Volumes[VolumeIndex]->DiskKind == DISK_KIND_EXTERNAL) {
+            PROF_BEGIN(SpanScanEfiFiles, "ScanEfiFiles");
             ScanEfiFiles (Volumes[VolumeIndex]);
+            PROF_END(SpanScanEfiFiles);
         }
     } // for
 
@@ -2649,7 +3106,9 @@ VOID ScanOptical (VOID) {
     FirstLoaderScan = TRUE;
     for (VolumeIndex = 0; VolumeIndex < VolumesCount; VolumeIndex++) {
         if (Volumes[VolumeIndex]->DiskKind == DISK_KIND_OPTICAL) {
+            PROF_BEGIN(SpanScanEfiFiles, "ScanEfiFiles");
             ScanEfiFiles (Volumes[VolumeIndex]);
+            PROF_END(SpanScanEfiFiles);
         }
     } // for
     FirstLoaderScan = FALSE;
@@ -3020,6 +3479,9 @@ VOID ScanForBootloaders (VOID) {
         #endif
     } // if GlobalConfig.SyncAPFS
 
+    // Load loader records from the previous boot when 'scan_cache' is active
+    ScanCacheBegin();
+
     // Get count of options set to be scanned
     SetOptions = 0;
     for (i = 0; i < NUM_SCAN_OPTIONS; i++) {
@@ -3142,6 +3604,8 @@ VOID ScanForBootloaders (VOID) {
         } // switch
     } // for
 
+    ScanCacheEnd();
+
     #if REFIT_DEBUG > 0
     // Reset
     LogNewLine = FALSE;
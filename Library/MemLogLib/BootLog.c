@@ -119,7 +119,9 @@ CHAR16 * GetDateString (VOID) {
 } // CHAR16 * GetDateString()
 
 static
-EFI_FILE_PROTOCOL * GetDebugLogFile (VOID) {
+EFI_FILE_PROTOCOL * OpenDebugFile (
+    IN CHAR16 *FileName
+) {
     EFI_STATUS           Status;
     EFI_LOADED_IMAGE    *LoadedImage;
     EFI_FILE_PROTOCOL   *LogProtocol;
@@ -145,16 +147,10 @@ EFI_FILE_PROTOCOL * GetDebugLogFile (VOID) {
         return NULL;
     }
 
-    if (mDebugLog == NULL) {
-        CHAR16 *DateStr = GetDateString();
-        mDebugLog = PoolPrint (L"EFI\\%s.log", DateStr);
-        MY_FREE_POOL(DateStr);
-    }
-
     // Open log file from current root
     Status = REFIT_CALL_5_WRAPPER(
         mRootDir->Open, mRootDir,
-        &LogProtocol, mDebugLog,
+        &LogProtocol, FileName,
         EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE, 0
     );
 
@@ -162,7 +158,7 @@ EFI_FILE_PROTOCOL * GetDebugLogFile (VOID) {
     if (Status == EFI_NOT_FOUND) {
         REFIT_CALL_5_WRAPPER(
             mRootDir->Open, mRootDir,
-            &LogProtocol, mDebugLog,
+            &LogProtocol, FileName,
             ReadWriteCreate, 0
         );
     }
@@ -176,7 +172,7 @@ EFI_FILE_PROTOCOL * GetDebugLogFile (VOID) {
             // Try to locate log file
             Status = REFIT_CALL_5_WRAPPER(
                 mRootDir->Open, mRootDir,
-                &LogProtocol, mDebugLog,
+                &LogProtocol, FileName,
                 EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE, 0
             );
 
@@ -184,7 +180,7 @@ EFI_FILE_PROTOCOL * GetDebugLogFile (VOID) {
             if (Status == EFI_NOT_FOUND) {
                 REFIT_CALL_5_WRAPPER(
                     mRootDir->Open, mRootDir,
-                    &LogProtocol, mDebugLog,
+                    &LogProtocol, FileName,
                     ReadWriteCreate, 0
                 );
             }
@@ -200,6 +196,17 @@ EFI_FILE_PROTOCOL * GetDebugLogFile (VOID) {
     // DA-TAG: Do not set 'mRootDir' to NULL here
     //         May be used in caller when 'LogProtocol' is not NULL
     return LogProtocol;
+} // static EFI_FILE_PROTOCOL * OpenDebugFile()
+
+static
+EFI_FILE_PROTOCOL * GetDebugLogFile (VOID) {
+    if (mDebugLog == NULL) {
+        CHAR16 *DateStr = GetDateString();
+        mDebugLog = PoolPrint (L"EFI\\%s.log", DateStr);
+        MY_FREE_POOL(DateStr);
+    }
+
+    return OpenDebugFile (mDebugLog);
 } // static EFI_FILE_PROTOCOL * GetDebugLogFile()
 
 static
@@ -262,6 +269,52 @@ VOID SaveMessageToDebugLogFile (
     LogFile->Close (LogFile);
 } // static VOID SaveMessageToDebugLogFile()
 
+VOID SaveProfileToDebugLogFile (VOID) {
+    EFI_STATUS        Status;
+    EFI_FILE_HANDLE   ProfileFile;
+    CHAR8            *Json;
+    CHAR16           *ProfileName;
+    UINTN             JsonLen;
+    UINTN             NameLen;
+
+    if (gKernelStarted || DelMsgLog || mDebugLog == NULL) {
+        // Early Return ... No log file to write alongside
+        return;
+    }
+
+    // Written alongside the log as 'EFI\<DateStr>.json'
+    NameLen     = StrLen (mDebugLog);
+    ProfileName = AllocateZeroPool ((NameLen + 2) * sizeof (CHAR16));
+    if (ProfileName == NULL) {
+        // Early Return
+        return;
+    }
+    CopyMem (ProfileName, mDebugLog, NameLen * sizeof (CHAR16));
+    StrCpyS (&ProfileName[NameLen - 3], 5, L"json");
+
+    // Replace any profile saved on an earlier pass
+    ProfileFile = OpenDebugFile (ProfileName);
+    if (ProfileFile != NULL) {
+        REFIT_CALL_1_WRAPPER(ProfileFile->Delete, ProfileFile);
+        ProfileFile = OpenDebugFile (ProfileName);
+    }
+
+    Json = GetMemLogProfileJson (&JsonLen);
+    if (ProfileFile != NULL && Json != NULL) {
+        Status = REFIT_CALL_3_WRAPPER(ProfileFile->Write, ProfileFile, &JsonLen, Json);
+        if (!EFI_ERROR(Status)) {
+            REFIT_CALL_1_WRAPPER(ProfileFile->Flush, ProfileFile);
+        }
+    }
+
+    if (ProfileFile != NULL) {
+        REFIT_CALL_1_WRAPPER(ProfileFile->Close, ProfileFile);
+    }
+
+    MY_FREE_POOL(Json);
+    MY_FREE_POOL(ProfileName);
+} // VOID SaveProfileToDebugLogFile()
+
 VOID WayPointer (
     IN CHAR16 *Msg
 ) {
@@ -477,6 +530,22 @@ VOID EFIAPI MemLogCallback (
     return;
 } // static VOID EFIAPI MemLogCallback()
 
+#if REFIT_DEBUG > 0
+static
+EFI_GUID  mMemLogProfileProtocolGuid = MEM_LOG_PROFILE_PROTOCOL_GUID;
+#endif
+
 VOID InitBooterLog (VOID) {
     SetMemLogCallback (MemLogCallback);
+
+    #if REFIT_DEBUG > 0
+    // Let the FSW drivers record spans into our ring
+    MEM_LOG_PROFILE *Profile = GetMemLogProfile();
+    if (Profile != NULL) {
+        REFIT_CALL_4_WRAPPER(
+            gBS->InstallMultipleProtocolInterfaces, &gImageHandle,
+            &mMemLogProfileProtocolGuid, Profile, NULL
+        );
+    }
+    #endif
 } // VOID InitBooterLog()
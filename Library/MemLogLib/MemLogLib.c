@@ -51,6 +51,9 @@ typedef struct {
     UINT64            TscLast;
     /// TSC ticks per second.
     UINT64            TscFreqSec;
+
+    /// Profiler span ring.
+    MEM_LOG_PROFILE  *Profile;
 } MEM_LOG;
 
 
@@ -82,6 +85,23 @@ UINT64 GetCurrentMS (VOID) {
 	return CurrentMS;
 }
 
+UINT64 GetCurrentUS (VOID) {
+	UINT64    CurrentUS  = 0;
+	UINT64    CurrentTsc = 0;
+
+	if (mMemLog != NULL && mMemLog->TscFreqSec != 0) {
+		CurrentTsc = AsmReadTsc();
+
+		CurrentUS = DivU64x64Remainder (
+            MultU64x32 (CurrentTsc - mMemLog->TscStart, 1000000),
+            mMemLog->TscFreqSec,
+            NULL
+        );
+	}
+
+	return CurrentUS;
+}
+
 CHAR8 * GetTiming (VOID) {
 	UINT64    dTStartSec;
 	UINT64    dTStartMs;
@@ -188,6 +208,18 @@ EFI_STATUS EFIAPI MemLogInit (VOID) {
     mMemLog->Cursor     = mMemLog->Buffer;
     mMemLog->Callback   = NULL;
 
+    // Preallocate the span ring so recording never allocates
+    mMemLog->Profile = AllocateZeroPool (sizeof (MEM_LOG_PROFILE));
+    if (mMemLog->Profile != NULL) {
+        mMemLog->Profile->Spans = AllocateZeroPool (
+            MEM_LOG_SPAN_RING_SIZE * sizeof (MEM_LOG_SPAN)
+        );
+        if (mMemLog->Profile->Spans == NULL) {
+            FreePool (mMemLog->Profile);
+            mMemLog->Profile = NULL;
+        }
+    }
+
     // Calibrate TSC for timings
     InitError[0]='\0';
 
@@ -473,3 +505,170 @@ UINT64 EFIAPI GetMemLogTscTicksPerSecond (VOID) {
 
     return mMemLog->TscFreqSec;
 }
+
+/**
+  Converts TSC ticks since MemLogInit to microseconds.
+ **/
+static
+UINT64 TscToUS (
+    IN UINT64 Tsc
+) {
+    if (mMemLog->TscFreqSec == 0 || Tsc < mMemLog->TscStart) {
+        return 0;
+    }
+
+    return DivU64x64Remainder (
+        MultU64x32 (Tsc - mMemLog->TscStart, 1000000),
+        mMemLog->TscFreqSec,
+        NULL
+    );
+}
+
+/**
+  Opens a profiler span nested inside any span still open.
+ **/
+UINTN EFIAPI MemLogSpanBegin (
+    IN  const CHAR8   *Name
+) {
+    EFI_STATUS        Status;
+    MEM_LOG_PROFILE  *Profile;
+    MEM_LOG_SPAN     *Span;
+    UINTN             Handle;
+
+    if (Name == NULL) {
+        return MEM_LOG_SPAN_NONE;
+    }
+
+    Status = MemLogInit();
+    if (EFI_ERROR(Status) || mMemLog->Profile == NULL) {
+        return MEM_LOG_SPAN_NONE;
+    }
+
+    Profile = mMemLog->Profile;
+    Handle  = Profile->SpanCount++;
+    Span    = &Profile->Spans[Handle % MEM_LOG_SPAN_RING_SIZE];
+
+    Span->Name     = Name;
+    Span->Depth    = Profile->SpanDepth++;
+    Span->TscEnd   = 0;
+    Span->TscBegin = AsmReadTsc();
+
+    return Handle;
+}
+
+/**
+  Closes a profiler span opened with MemLogSpanBegin().
+ **/
+VOID EFIAPI MemLogSpanEnd (
+    IN  UINTN         Span
+) {
+    MEM_LOG_PROFILE  *Profile;
+    UINT64            Tsc;
+
+    Tsc = AsmReadTsc();
+
+    if (mMemLog == NULL || mMemLog->Profile == NULL) {
+        return;
+    }
+
+    Profile = mMemLog->Profile;
+    if (Span >= Profile->SpanCount) {
+        // Also catches MEM_LOG_SPAN_NONE
+        return;
+    }
+
+    if (Profile->SpanDepth > 0) {
+        Profile->SpanDepth--;
+    }
+
+    // Slot has been reused by a newer span
+    if (Profile->SpanCount - Span > MEM_LOG_SPAN_RING_SIZE) {
+        return;
+    }
+
+    Profile->Spans[Span % MEM_LOG_SPAN_RING_SIZE].TscEnd = Tsc;
+}
+
+/**
+  Returns the profiler span ring for publishing to drivers.
+ **/
+MEM_LOG_PROFILE * EFIAPI GetMemLogProfile (VOID) {
+    EFI_STATUS        Status;
+
+    Status = MemLogInit();
+    if (EFI_ERROR(Status)) {
+        return NULL;
+    }
+
+    return mMemLog->Profile;
+}
+
+/**
+  Renders the recorded spans as Chrome trace event JSON.
+ **/
+CHAR8 * EFIAPI GetMemLogProfileJson (
+    OUT UINTN         *Length
+) {
+    EFI_STATUS        Status;
+    MEM_LOG_PROFILE  *Profile;
+    MEM_LOG_SPAN     *Span;
+    CHAR8            *Json;
+    CHAR8            *Cursor;
+    UINTN             First;
+    UINTN             Index;
+    UINTN             Size;
+    UINT64            Now;
+    UINT64            BeginUS;
+    UINT64            EndUS;
+
+    *Length = 0;
+
+    Status = MemLogInit();
+    if (EFI_ERROR(Status) || mMemLog->Profile == NULL) {
+        return NULL;
+    }
+
+    Profile = mMemLog->Profile;
+    Now     = AsmReadTsc();
+    First   = (Profile->SpanCount > MEM_LOG_SPAN_RING_SIZE)
+        ? Profile->SpanCount - MEM_LOG_SPAN_RING_SIZE : 0;
+
+    // Fixed part of each event is well under 192 chars
+    Size = 64;
+    for (Index = First; Index < Profile->SpanCount; Index++) {
+        Size += AsciiStrLen (Profile->Spans[Index % MEM_LOG_SPAN_RING_SIZE].Name) + 192;
+    }
+
+    Json = AllocatePool (Size);
+    if (Json == NULL) {
+        return NULL;
+    }
+
+    Cursor  = Json;
+    Cursor += AsciiSPrint (Cursor, Size, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+    for (Index = First; Index < Profile->SpanCount; Index++) {
+        Span    = &Profile->Spans[Index % MEM_LOG_SPAN_RING_SIZE];
+        BeginUS = TscToUS (Span->TscBegin);
+        EndUS   = TscToUS ((Span->TscEnd != 0) ? Span->TscEnd : Now);
+
+        Cursor += AsciiSPrint (
+            Cursor,
+            Size - (Cursor - Json),
+            "%a\n{\"name\":\"%a\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+            "\"ts\":%ld,\"dur\":%ld,\"args\":{\"depth\":%ld,\"open\":%a}}",
+            (Index == First) ? "" : ",",
+            Span->Name,
+            BeginUS,
+            EndUS - BeginUS,
+            (UINT64) Span->Depth,
+            (Span->TscEnd != 0) ? "false" : "true"
+        );
+    }
+
+    Cursor += AsciiSPrint (Cursor, Size - (Cursor - Json), "\n]}\n");
+
+    *Length = Cursor - Json;
+
+    return Json;
+}
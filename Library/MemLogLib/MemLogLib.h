@@ -13,6 +13,8 @@
 #define MEM_LOG_MAX_SIZE        (10 * 1024 * 1024)
 #define MEM_LOG_MAX_LINE_SIZE   1024
 
+#include "../../include/mem_log_profiler.h"
+
 
 /** Callback that can be installed to be called when some message is printed with MemLog() or MemLogVA(). **/
 typedef VOID (EFIAPI *MEM_LOG_CALLBACK) (IN INTN DebugMode, IN CHAR8 *LastMessage);
@@ -80,6 +82,45 @@ VOID EFIAPI SetMemLogCallback (
 UINT64 EFIAPI GetMemLogTscTicksPerSecond (VOID);
 
 UINT64 GetCurrentMS (VOID);
+UINT64 GetCurrentUS (VOID);
+
+
+/**
+  Opens a profiler span nested inside any span still open.
+
+  @param  Name        Span name. Must stay valid for the life of the image
+                      and is written to the profile as is.
+
+  @retval Handle to pass to MemLogSpanEnd() or MEM_LOG_SPAN_NONE.
+**/
+UINTN EFIAPI MemLogSpanBegin (
+  IN  const CHAR8   *Name
+);
+
+/**
+  Closes a profiler span opened with MemLogSpanBegin().
+  Does nothing if the span has already been overwritten in the ring.
+**/
+VOID EFIAPI MemLogSpanEnd (
+  IN  UINTN         Span
+);
+
+/**
+  Returns the profiler span ring for publishing to drivers.
+**/
+MEM_LOG_PROFILE * EFIAPI GetMemLogProfile (VOID);
+
+/**
+  Renders the recorded spans as Chrome trace event JSON.
+  Spans still open are closed at the current time.
+
+  @param  Length      Receives the number of chars in the returned buffer.
+
+  @retval Pool allocated buffer the caller must free or NULL.
+**/
+CHAR8 * EFIAPI GetMemLogProfileJson (
+  OUT UINTN         *Length
+);
 
 
 #endif // __MEMLOG_LIB_H__
@@ -126,9 +126,11 @@ struct btrfs_header
 {
     btrfs_checksum_t checksum;
     btrfs_uuid_t uuid;
-    uint8_t dummy[0x30];
+    uint64_t bytenr;
+    uint8_t dummy[0x28];
     uint32_t nitems;
     uint8_t level;
+#define BTRFS_MAX_LEVEL 8
 } __attribute__ ((__packed__));
 
 struct fsw_btrfs_device_desc
@@ -146,6 +148,40 @@ struct fsw_btrfs_recover_cache
     BOOLEAN valid;
 };
 
+/* Whole tree nodes, keyed by logical address and evicted least recently used first */
+#define NODE_CACHE_SIZE 16
+struct fsw_btrfs_node_cache
+{
+    uint64_t addr;
+    uint32_t stamp;
+    uint8_t *data;
+    BOOLEAN valid;
+    BOOLEAN busy;
+};
+
+/*
+ * Decompressed file windows of compressed extents, keyed by on-disk address
+ * and offset into the uncompressed data, evicted least recently used first
+ */
+#define EXTENT_CACHE_SIZE 8
+#define EXTENT_CACHE_MAX_BYTES (128 * 1024)
+struct fsw_btrfs_extent_cache
+{
+    uint64_t laddr;
+    uint64_t offset;
+    uint64_t size;
+    uint32_t stamp;
+    char *data;
+};
+
+/* One chunk of the logical address space and its stripe layout */
+struct fsw_btrfs_chunk_map
+{
+    uint64_t start;
+    uint64_t size;
+    struct btrfs_chunk_item *chunk;
+};
+
 struct fsw_btrfs_volume
 {
     struct fsw_volume g;            //!< Generic volume structure
@@ -161,6 +197,7 @@ struct fsw_btrfs_volume
     unsigned num_devices;
     unsigned sectorshift;
     unsigned sectorsize;
+    unsigned nodesize;
     int is_master;
     int rescan_once;
 
@@ -176,6 +213,12 @@ struct fsw_btrfs_volume
     uint32_t extsize;
     struct btrfs_extent_data *extent;
     struct fsw_btrfs_recover_cache *rcache;
+    struct fsw_btrfs_node_cache *ncache;
+    uint32_t ncache_stamp;
+    struct fsw_btrfs_chunk_map *chunk_map;  //!< Sorted by start, NULL if not loaded
+    unsigned n_chunks;
+    struct fsw_btrfs_extent_cache *ecache;
+    uint32_t ecache_stamp;
 };
 
 enum
@@ -396,6 +439,7 @@ static fsw_status_t btrfs_set_superblock_info(struct fsw_btrfs_volume *vol, stru
             break;
         }
     }
+    vol->nodesize = fsw_u32_le_swap(sb->nodesize);
     if(fsw_u64_le_swap(sb->num_devices) > BTRFS_MAX_NUM_DEVICES)
         vol->num_devices = BTRFS_MAX_NUM_DEVICES;
     else
@@ -511,13 +555,127 @@ static fsw_status_t save_ref (struct fsw_btrfs_leaf_descriptor *desc,
     return FSW_SUCCESS;
 }
 
+/* Returns the key of item i of a node read by btrfs_read_node */
+static struct btrfs_key *node_key (struct btrfs_header *head, unsigned i)
+{
+    if (head->level)
+        return &((struct btrfs_internal_node *) (head + 1))[i].key;
+    return &((struct btrfs_leaf_node *) (head + 1))[i].key;
+}
+
+/*
+ * Reads the whole tree node at addr through the node cache and checks that
+ * its item table fits. The returned node stays valid until the next call.
+ */
+static fsw_status_t btrfs_read_node (struct fsw_btrfs_volume *vol,
+        uint64_t addr, int rdepth, int cache_level,
+        struct btrfs_header **head_out)
+{
+    struct fsw_btrfs_node_cache *nc, *victim = NULL;
+    struct btrfs_header *head;
+    uint32_t nitems, itemsize;
+    fsw_status_t err;
+    unsigned i;
+
+    if (vol->ncache == NULL) {
+        err = fsw_alloc_zero(sizeof (struct fsw_btrfs_node_cache) * NODE_CACHE_SIZE, (void **) &vol->ncache);
+        if (err)
+            return err;
+    }
+
+    for (i = 0; i < NODE_CACHE_SIZE; i++) {
+        nc = &vol->ncache[i];
+        if (nc->valid && nc->addr == addr) {
+            nc->stamp = ++vol->ncache_stamp;
+            *head_out = (struct btrfs_header *) nc->data;
+            return FSW_SUCCESS;
+        }
+        if (!nc->busy && (victim == NULL || nc->stamp < victim->stamp))
+            victim = nc;
+    }
+    if (victim == NULL)
+        return FSW_VOLUME_CORRUPTED;
+
+    if (victim->data == NULL) {
+        err = fsw_alloc(vol->nodesize, (void **) &victim->data);
+        if (err)
+            return err;
+    }
+
+    /* Chunk tree lookups made while reading must not take this slot */
+    victim->valid = FALSE;
+    victim->busy = TRUE;
+    err = fsw_btrfs_read_logical (vol, addr, victim->data, vol->nodesize,
+            rdepth, cache_level);
+    victim->busy = FALSE;
+    if (err)
+        return err;
+
+    head = (struct btrfs_header *) victim->data;
+    nitems = fsw_u32_le_swap (head->nitems);
+    itemsize = head->level ? sizeof (struct btrfs_internal_node) : sizeof (struct btrfs_leaf_node);
+    if (fsw_u64_le_swap (head->bytenr) != addr
+            || head->level >= BTRFS_MAX_LEVEL
+            || nitems > (vol->nodesize - sizeof (*head)) / itemsize)
+    {
+        DPRINT (L"btrfs: bad node at %lx\n", addr);
+        return FSW_VOLUME_CORRUPTED;
+    }
+
+    victim->addr = addr;
+    victim->stamp = ++vol->ncache_stamp;
+    victim->valid = TRUE;
+    *head_out = head;
+    return FSW_SUCCESS;
+}
+
+/* Copies an item out of a cached node when [addr, addr + size) lies inside one */
+static int btrfs_read_cached (struct fsw_btrfs_volume *vol,
+        uint64_t addr, void *buf, fsw_size_t size)
+{
+    struct fsw_btrfs_node_cache *nc;
+    unsigned i;
+
+    if (vol->ncache == NULL || size <= 0)
+        return 0;
+
+    for (i = 0; i < NODE_CACHE_SIZE; i++) {
+        nc = &vol->ncache[i];
+        if (nc->valid && addr >= nc->addr
+                && addr - nc->addr + (uint64_t) size <= vol->nodesize)
+        {
+            fsw_memcpy (buf, nc->data + (addr - nc->addr), size);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Returns the item data location of leaf item i, checking it stays inside the node */
+static fsw_status_t leaf_item (struct fsw_btrfs_volume *vol,
+        uint64_t addr, struct btrfs_header *head, unsigned i,
+        uint64_t *outaddr, fsw_size_t *outsize)
+{
+    struct btrfs_leaf_node *leaf = (struct btrfs_leaf_node *) (head + 1) + i;
+    uint32_t offset = fsw_u32_le_swap (leaf->offset);
+    uint32_t size = fsw_u32_le_swap (leaf->size);
+
+    if (offset > vol->nodesize - sizeof (*head)
+            || size > vol->nodesize - sizeof (*head) - offset)
+        return FSW_VOLUME_CORRUPTED;
+
+    *outsize = size;
+    *outaddr = addr + sizeof (struct btrfs_header) + offset;
+    return FSW_SUCCESS;
+}
+
 static int next (struct fsw_btrfs_volume *vol,
         struct fsw_btrfs_leaf_descriptor *desc,
         uint64_t * outaddr, fsw_size_t * outsize,
         struct btrfs_key *key_out)
 {
     fsw_status_t err;
-    struct btrfs_leaf_node leaf;
+    struct btrfs_header *head;
 
     for (; desc->depth > 0; desc->depth--)
     {
@@ -530,37 +688,39 @@ static int next (struct fsw_btrfs_volume *vol,
         return 0;
     while (!desc->data[desc->depth - 1].leaf)
     {
-        struct btrfs_internal_node node;
-        struct btrfs_header head;
-        fsw_memzero(&node, sizeof (node));
-
-        err = fsw_btrfs_read_logical (vol, desc->data[desc->depth - 1].iter
-                * sizeof (node)
-                + sizeof (struct btrfs_header)
-                + desc->data[desc->depth - 1].addr,
-                &node, sizeof (node), 0, 1);
+        struct btrfs_internal_node *node;
+        uint64_t child;
+
+        err = btrfs_read_node (vol, desc->data[desc->depth - 1].addr, 0, 1, &head);
         if (err)
             return -err;
+        if (!head->level || desc->data[desc->depth - 1].iter >= fsw_u32_le_swap (head->nitems))
+            return -FSW_VOLUME_CORRUPTED;
 
-        err = fsw_btrfs_read_logical (vol, fsw_u64_le_swap (node.addr),
-                &head, sizeof (head), 0, 1);
+        node = (struct btrfs_internal_node *) (head + 1) + desc->data[desc->depth - 1].iter;
+        child = fsw_u64_le_swap (node->addr);
+
+        err = btrfs_read_node (vol, child, 0, 1, &head);
         if (err)
             return -err;
 
-        save_ref (desc, fsw_u64_le_swap (node.addr), 0,
-                fsw_u32_le_swap (head.nitems), !head.level);
+        err = save_ref (desc, child, 0,
+                fsw_u32_le_swap (head->nitems), !head->level);
+        if (err)
+            return -err;
     }
-    err = fsw_btrfs_read_logical (vol, desc->data[desc->depth - 1].iter
-            * sizeof (leaf)
-            + sizeof (struct btrfs_header)
-            + desc->data[desc->depth - 1].addr, &leaf,
-            sizeof (leaf), 0, 1);
+
+    err = btrfs_read_node (vol, desc->data[desc->depth - 1].addr, 0, 1, &head);
     if (err)
         return -err;
-    *outsize = fsw_u32_le_swap (leaf.size);
-    *outaddr = desc->data[desc->depth - 1].addr + sizeof (struct btrfs_header)
-        + fsw_u32_le_swap (leaf.offset);
-    *key_out = leaf.key;
+    if (head->level || desc->data[desc->depth - 1].iter >= fsw_u32_le_swap (head->nitems))
+        return -FSW_VOLUME_CORRUPTED;
+
+    err = leaf_item (vol, desc->data[desc->depth - 1].addr, head,
+            desc->data[desc->depth - 1].iter, outaddr, outsize);
+    if (err)
+        return -err;
+    *key_out = *node_key (head, desc->data[desc->depth - 1].iter);
     return 1;
 }
 
@@ -596,121 +756,70 @@ static fsw_status_t lower_bound (struct fsw_btrfs_volume *vol,
     while (1)
     {
         fsw_status_t err;
-        struct btrfs_header head;
-        fsw_memzero(&head, sizeof (head));
-
-reiter:
-        depth++;
-        /* FIXME: preread few nodes into buffer. */
-        err = fsw_btrfs_read_logical (vol, addr, &head, sizeof (head),
-                rdepth + 1, depth2cache(rdepth));
+        struct btrfs_header *head;
+        unsigned nitems, lo, hi, mid;
+        int leaf;
+
+        if (++depth >= BTRFS_MAX_LEVEL)
+            return FSW_VOLUME_CORRUPTED;
+
+        err = btrfs_read_node (vol, addr, rdepth + 1, depth2cache(rdepth), &head);
         if (err)
             return err;
-        addr += sizeof (head);
-        if (head.level)
-        {
-            unsigned i;
-            struct btrfs_internal_node node, node_last;
-            int have_last = 0;
-            fsw_memzero (&node_last, sizeof (node_last));
-            for (i = 0; i < fsw_u32_le_swap (head.nitems); i++)
-            {
-                err = fsw_btrfs_read_logical (vol, addr + i * sizeof (node),
-                        &node, sizeof (node), rdepth + 1, depth2cache(rdepth));
-                if (err)
-                    return err;
 
-                DPRINT (L"btrfs: internal node (depth %d) %lx %x %lx\n", depth,
-                        node.key.object_id, node.key.type,
-                        node.key.offset);
+        nitems = fsw_u32_le_swap (head->nitems);
+        leaf = !head->level;
 
-                if (key_cmp (&node.key, key_in) == 0)
-                {
-                    err = FSW_SUCCESS;
-                    if (desc)
-                        err = save_ref (desc, addr - sizeof (head), i,
-                                fsw_u32_le_swap (head.nitems), 0);
-                    if (err)
-                        return err;
-                    addr = fsw_u64_le_swap (node.addr);
-                    goto reiter;
-                }
-                if (key_cmp (&node.key, key_in) > 0)
-                    break;
-                fsw_memcpy (&node_last, &node, sizeof(node_last));
-                have_last = 1;
-            }
-            if (have_last)
-            {
-                err = FSW_SUCCESS;
-                if (desc)
-                    err = save_ref (desc, addr - sizeof (head), i - 1,
-                            fsw_u32_le_swap (head.nitems), 0);
-                if (err)
-                    return err;
-                addr = fsw_u64_le_swap (node_last.addr);
-                goto reiter;
-            }
+        /* Binary search for the first item above key_in */
+        lo = 0;
+        hi = nitems;
+        while (lo < hi)
+        {
+            mid = lo + (hi - lo) / 2;
+            if (key_cmp (node_key (head, mid), key_in) > 0)
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+
+        if (lo == 0)
+        {
+            /* Every key is above key_in */
             *outsize = 0;
             *outaddr = 0;
             fsw_memzero (key_out, sizeof (*key_out));
             if (desc)
-                return save_ref (desc, addr - sizeof (head), -1,
-                        fsw_u32_le_swap (head.nitems), 0);
+                return save_ref (desc, addr, -1, nitems, leaf);
             return FSW_SUCCESS;
         }
-        {
-            unsigned i;
-            struct btrfs_leaf_node leaf, leaf_last;
-            int have_last    = 0;
-            leaf_last.size   = 0;
-            leaf_last.offset = 0;
-            for (i = 0; i < fsw_u32_le_swap (head.nitems); i++)
-            {
-                err = fsw_btrfs_read_logical (vol, addr + i * sizeof (leaf),
-                        &leaf, sizeof (leaf), rdepth + 1, depth2cache(rdepth));
-                if (err)
-                    return err;
 
-                DPRINT (L"btrfs: leaf (depth %d) %lx %x %lx\n", depth,
-                        leaf.key.object_id, leaf.key.type, leaf.key.offset);
+        /* Last item not above key_in */
+        lo--;
 
-                if (key_cmp (&leaf.key, key_in) == 0)
-                {
-                    fsw_memcpy (key_out, &leaf.key, sizeof (*key_out));
-                    *outsize = fsw_u32_le_swap (leaf.size);
-                    *outaddr = addr + fsw_u32_le_swap (leaf.offset);
-                    if (desc)
-                        return save_ref (desc, addr - sizeof (head), i,
-                                fsw_u32_le_swap (head.nitems), 1);
-                    return FSW_SUCCESS;
-                }
+        DPRINT (L"btrfs: %s (depth %d) %lx %x %lx\n",
+                leaf ? L"leaf" : L"internal node", depth,
+                node_key (head, lo)->object_id, node_key (head, lo)->type,
+                node_key (head, lo)->offset);
 
-                if (key_cmp (&leaf.key, key_in) > 0)
-                    break;
-
-                have_last = 1;
-                leaf_last = leaf;
-            }
-
-            if (have_last)
+        if (!leaf)
+        {
+            if (desc)
             {
-                fsw_memcpy (key_out, &leaf_last.key, sizeof (*key_out));
-                *outsize = fsw_u32_le_swap (leaf_last.size);
-                *outaddr = addr + fsw_u32_le_swap (leaf_last.offset);
-                if (desc)
-                    return save_ref (desc, addr - sizeof (head), i - 1,
-                            fsw_u32_le_swap (head.nitems), 1);
-                return FSW_SUCCESS;
+                err = save_ref (desc, addr, lo, nitems, 0);
+                if (err)
+                    return err;
             }
-            *outsize = 0;
-            *outaddr = 0;
-            fsw_memzero (key_out, sizeof (*key_out));
-            if (desc)
-                return save_ref (desc, addr - sizeof (head), -1,
-                        fsw_u32_le_swap (head.nitems), 1);
-            return FSW_SUCCESS;
+            addr = fsw_u64_le_swap (((struct btrfs_internal_node *) (head + 1))[lo].addr);
+            continue;
         }
+
+        err = leaf_item (vol, addr, head, lo, outaddr, outsize);
+        if (err)
+            return err;
+        fsw_memcpy (key_out, node_key (head, lo), sizeof (*key_out));
+        if (desc)
+            return save_ref (desc, addr, lo, nitems, 1);
+        return FSW_SUCCESS;
     }
 }
 
@@ -886,13 +995,50 @@ static struct fsw_btrfs_recover_cache *get_recover_cache(struct fsw_btrfs_volume
     return rc;
 }
 
+/* Binary search of the chunk map for the chunk holding addr */
+static struct fsw_btrfs_chunk_map *find_chunk_map (struct fsw_btrfs_volume *vol, uint64_t addr)
+{
+    unsigned lo = 0, hi = vol->n_chunks, mid;
+
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        if (vol->chunk_map[mid].start > addr)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    if (lo == 0 || addr - vol->chunk_map[lo - 1].start >= vol->chunk_map[lo - 1].size)
+        return NULL;
+    return &vol->chunk_map[lo - 1];
+}
+
+static void free_chunk_map (struct fsw_btrfs_volume *vol)
+{
+    unsigned i;
+
+    if (vol->chunk_map == NULL)
+        return;
+    for (i = 0; i < vol->n_chunks; i++)
+        FreePool (vol->chunk_map[i].chunk);
+    FreePool (vol->chunk_map);
+    vol->chunk_map = NULL;
+    vol->n_chunks = 0;
+}
+
 static fsw_status_t fsw_btrfs_read_logical (struct fsw_btrfs_volume *vol, uint64_t addr,
         void *buf, fsw_size_t size, int rdepth, int cache_level)
 {
+    struct fsw_btrfs_chunk_map *map;
     struct stripe_table *stripe_table = NULL;
     int challoc = 0;
     struct btrfs_chunk_item *chunk = NULL;
     fsw_status_t err = 0;
+
+    /* Items found by lower_bound usually sit in a node that is still cached */
+    if (btrfs_read_cached (vol, addr, buf, size))
+        return FSW_SUCCESS;
+
     while (size > 0)
     {
         uint8_t *ptr;
@@ -902,8 +1048,17 @@ static fsw_status_t fsw_btrfs_read_logical (struct fsw_btrfs_volume *vol, uint64
         struct btrfs_key key_in;
         fsw_size_t chsize;
         uint64_t chaddr;
+        uint64_t chstart;
 
 	err = 0;
+        map = find_chunk_map (vol, addr);
+        if (map)
+        {
+            chunk = map->chunk;
+            chstart = map->start;
+            goto chunk_found;
+        }
+
         for (ptr = vol->bootstrap_mapping; ptr < vol->bootstrap_mapping + sizeof (vol->bootstrap_mapping) - sizeof (struct btrfs_key);)
         {
             key = (struct btrfs_key *) ptr;
@@ -914,6 +1069,7 @@ static fsw_status_t fsw_btrfs_read_logical (struct fsw_btrfs_volume *vol, uint64
                     && addr < fsw_u64_le_swap (key->offset)
                     + fsw_u64_le_swap (chunk->size))
             {
+                chstart = fsw_u64_le_swap (key->offset);
                 goto chunk_found;
             }
             ptr += sizeof (*key) + sizeof (*chunk)
@@ -934,6 +1090,7 @@ static fsw_status_t fsw_btrfs_read_logical (struct fsw_btrfs_volume *vol, uint64
             return FSW_VOLUME_CORRUPTED;
         }
         // "couldn't find the chunk descriptor");
+        chstart = fsw_u64_le_swap (key->offset);
 
         chunk = AllocatePool (chsize);
         if (!chunk) {
@@ -957,7 +1114,7 @@ chunk_found:
             UINTREM stripen;
             UINTREM stripeq = 0;
             UINTREM stripe_offset;
-            uint64_t off = addr - fsw_u64_le_swap (key->offset);
+            uint64_t off = addr - chstart;
             unsigned redundancy = 1;
             unsigned i;
 
@@ -968,7 +1125,7 @@ chunk_found:
 	    uint16_t nstripes = fsw_u16_le_swap (chunk->nstripes);
 
             DPRINT(L"btrfs chunk 0x%lx+0xlx %d stripes (%d substripes) of %lx\n",
-                    fsw_u64_le_swap (key->offset),
+                    chstart,
                     fsw_u64_le_swap (chunk->size),
                     nstripes,
                     fsw_u16_le_swap (chunk->nsubstripes),
@@ -1096,7 +1253,7 @@ begin_direct_read:
                     paddr = fsw_u64_le_swap (stripe->offset) + stripe_offset;
 
                     DPRINT (L"btrfs: chunk 0x%lx+0x%lx (%d stripes (%d substripes) of %lx) stripe %lx maps to 0x%lx\n",
-                            fsw_u64_le_swap (key->offset),
+                            chstart,
                             fsw_u64_le_swap (chunk->size),
                             nstripes,
                             fsw_u16_le_swap (chunk->nsubstripes),
@@ -1299,6 +1456,102 @@ volume_corrupted:
     err = FSW_VOLUME_CORRUPTED;
 io_error:
     if(stripe_table) FreePool(stripe_table);
+    if (challoc) FreePool (chunk);
+    return err;
+}
+
+/*
+ * Loads every chunk item of the chunk tree into vol->chunk_map so that
+ * fsw_btrfs_read_logical can translate addresses without a tree walk.
+ * The chunk tree itself is found through the superblock bootstrap mapping.
+ */
+static fsw_status_t btrfs_load_chunk_map (struct fsw_btrfs_volume *vol)
+{
+    struct fsw_btrfs_leaf_descriptor desc;
+    struct fsw_btrfs_chunk_map *map = NULL, *newmap;
+    struct btrfs_chunk_item *chunk;
+    struct btrfs_key key_in, key_out;
+    unsigned n = 0, allocated = 0;
+    uint64_t elemaddr;
+    fsw_size_t elemsize;
+    fsw_status_t err;
+    int r = 1;
+
+    desc.data = NULL;
+    key_in.object_id = fsw_u64_le_swap (GRUB_BTRFS_OBJECT_ID_CHUNK);
+    key_in.type = GRUB_BTRFS_ITEM_TYPE_CHUNK;
+    key_in.offset = 0;
+    err = lower_bound (vol, &key_in, &key_out, vol->chunk_tree, &elemaddr, &elemsize, &desc, 0);
+    if (err)
+        goto out;
+
+    if (key_out.object_id != key_in.object_id || key_out.type != GRUB_BTRFS_ITEM_TYPE_CHUNK)
+        r = next (vol, &desc, &elemaddr, &elemsize, &key_out);
+
+    for (; r > 0 && key_out.object_id == key_in.object_id; r = next (vol, &desc, &elemaddr, &elemsize, &key_out))
+    {
+        if (key_out.type != GRUB_BTRFS_ITEM_TYPE_CHUNK)
+            continue;
+
+        if (elemsize < (fsw_size_t) sizeof (*chunk))
+        {
+            err = FSW_VOLUME_CORRUPTED;
+            goto out;
+        }
+        chunk = AllocatePool (elemsize);
+        if (!chunk)
+        {
+            err = FSW_OUT_OF_MEMORY;
+            goto out;
+        }
+        err = fsw_btrfs_read_logical (vol, elemaddr, chunk, elemsize, 0, 1);
+        if (!err && (fsw_u16_le_swap (chunk->nstripes) == 0
+                || sizeof (*chunk) + sizeof (struct btrfs_chunk_stripe) * fsw_u16_le_swap (chunk->nstripes) > (unsigned) elemsize
+                || (n > 0 && fsw_u64_le_swap (key_out.offset) < map[n - 1].start + map[n - 1].size)))
+        {
+            err = FSW_VOLUME_CORRUPTED;
+        }
+        if (err)
+        {
+            FreePool (chunk);
+            goto out;
+        }
+
+        if (n == allocated)
+        {
+            allocated = allocated ? allocated * 2 : 16;
+            newmap = AllocatePool (sizeof (*map) * allocated);
+            if (!newmap)
+            {
+                FreePool (chunk);
+                err = FSW_OUT_OF_MEMORY;
+                goto out;
+            }
+            if (map)
+            {
+                fsw_memcpy (newmap, map, sizeof (*map) * n);
+                FreePool (map);
+            }
+            map = newmap;
+        }
+        map[n].start = fsw_u64_le_swap (key_out.offset);
+        map[n].size = fsw_u64_le_swap (chunk->size);
+        map[n].chunk = chunk;
+        n++;
+    }
+    if (r < 0)
+        err = -r;
+
+out:
+    if (desc.data)
+        free_iterator (&desc);
+    vol->chunk_map = map;
+    vol->n_chunks = n;
+    if (err || n == 0)
+    {
+        DPRINT (L"btrfs: chunk map not loaded, err %d\n", err);
+        free_chunk_map (vol);
+    }
     return err;
 }
 
@@ -1322,6 +1575,10 @@ static fsw_status_t fsw_btrfs_volume_mount(struct fsw_volume *volg) {
     if(vol->sectorshift == 0)
         return FSW_UNSUPPORTED;
 
+    if(vol->nodesize < vol->sectorsize || vol->nodesize > 0x10000
+            || (vol->nodesize & (vol->nodesize - 1)))
+        return FSW_UNSUPPORTED;
+
     if(vol->num_devices >= BTRFS_MAX_NUM_DEVICES)
         return FSW_UNSUPPORTED;
 
@@ -1366,6 +1623,9 @@ static fsw_status_t fsw_btrfs_volume_mount(struct fsw_volume *volg) {
         return err;
     }
 
+    /* Not fatal, reads fall back to walking the chunk tree */
+    btrfs_load_chunk_map(vol);
+
     err = fsw_btrfs_get_default_root(vol, sblock.root_dir_objectid);
     if (err) {
         DPRINT(L"root not found\n");
@@ -1400,10 +1660,23 @@ static void fsw_btrfs_volume_free(struct fsw_volume *volg)
         FreePool (vol->extent);
     if(vol->rcache) {
 	for(i = 0; i < RECOVER_CACHE_SIZE; i++)
-	    if(vol->rcache->buffer)
-		FreePool(vol->rcache->buffer);
+	    if(vol->rcache[i].buffer)
+		FreePool(vol->rcache[i].buffer);
         FreePool (vol->rcache);
     }
+    free_chunk_map(vol);
+    if(vol->ecache) {
+        for(i = 0; i < EXTENT_CACHE_SIZE; i++)
+            if(vol->ecache[i].data)
+                FreePool(vol->ecache[i].data);
+        FreePool (vol->ecache);
+    }
+    if(vol->ncache) {
+        for(i = 0; i < NODE_CACHE_SIZE; i++)
+            if(vol->ncache[i].data)
+                FreePool(vol->ncache[i].data);
+        FreePool (vol->ncache);
+    }
 }
 
 static fsw_status_t fsw_btrfs_volume_stat(struct fsw_volume *volg, struct fsw_volume_stat *sb)
@@ -1611,6 +1884,78 @@ static fsw_ssize_t btrfs_decompress(uint8_t comp,
 	return btrfs_decompressor_table[comp-1](ibuf, isize, off, obuf, osize);
 }
 
+/*
+ * Returns the whole decompressed file window of the current regular extent,
+ * decompressing it only when it is not already in the extent cache.
+ */
+static fsw_status_t btrfs_get_decompressed(struct fsw_btrfs_volume *vol,
+        struct fsw_btrfs_extent_cache **ec_out)
+{
+    uint64_t laddr = fsw_u64_le_swap (vol->extent->laddr);
+    uint64_t offset = fsw_u64_le_swap (vol->extent->offset);
+    uint64_t size = vol->extend - vol->extstart;
+    uint64_t zsize;
+    struct fsw_btrfs_extent_cache *ec, *victim = NULL;
+    fsw_ssize_t ret;
+    fsw_status_t err;
+    char *tmp;
+    unsigned i;
+
+    if (vol->ecache == NULL) {
+        err = fsw_alloc_zero(sizeof (struct fsw_btrfs_extent_cache) * EXTENT_CACHE_SIZE, (void **) &vol->ecache);
+        if (err)
+            return err;
+    }
+
+    for (i = 0; i < EXTENT_CACHE_SIZE; i++) {
+        ec = &vol->ecache[i];
+        if (ec->data && ec->laddr == laddr && ec->offset == offset && ec->size >= size) {
+            ec->stamp = ++vol->ecache_stamp;
+            *ec_out = ec;
+            return FSW_SUCCESS;
+        }
+        if (victim == NULL || (victim->data && (!ec->data || ec->stamp < victim->stamp)))
+            victim = ec;
+    }
+
+    if (victim->data) {
+        FreePool (victim->data);
+        victim->data = NULL;
+    }
+
+    zsize = fsw_u64_le_swap (vol->extent->compressed_size);
+    tmp = AllocatePool (zsize);
+    if (!tmp)
+        return FSW_OUT_OF_MEMORY;
+    err = fsw_btrfs_read_logical (vol, laddr, tmp, zsize, 0, 0);
+    if (err) {
+        FreePool (tmp);
+        return FSW_VOLUME_CORRUPTED;
+    }
+
+    victim->data = AllocatePool (size);
+    if (!victim->data) {
+        FreePool (tmp);
+        return FSW_OUT_OF_MEMORY;
+    }
+
+    ret = btrfs_decompress (vol->extent->compression, tmp, zsize, offset,
+            victim->data, size);
+    FreePool (tmp);
+    if (ret != (fsw_ssize_t) size) {
+        FreePool (victim->data);
+        victim->data = NULL;
+        return FSW_VOLUME_CORRUPTED;
+    }
+
+    victim->laddr = laddr;
+    victim->offset = offset;
+    victim->size = size;
+    victim->stamp = ++vol->ecache_stamp;
+    *ec_out = victim;
+    return FSW_SUCCESS;
+}
+
 static fsw_status_t fsw_btrfs_get_extent(struct fsw_volume *volg, struct fsw_dnode *dnog,
         struct fsw_extent *extent)
 {
@@ -1750,6 +2095,22 @@ static fsw_status_t fsw_btrfs_get_extent(struct fsw_volume *volg, struct fsw_dno
             if (vol->extent->compression > GRUB_BTRFS_COMPRESSION_MAX)
                     return -FSW_VOLUME_CORRUPTED;
 
+            /* Btrfs compresses at most 128K per extent, so this is the usual path */
+            if (vol->extend - vol->extstart <= EXTENT_CACHE_MAX_BYTES)
+            {
+                struct fsw_btrfs_extent_cache *ec;
+
+                err = btrfs_get_decompressed (vol, &ec);
+                if (err)
+                    return err;
+
+                buf = AllocatePool( count << vol->sectorshift);
+                if(!buf)
+                    return FSW_OUT_OF_MEMORY;
+                fsw_memcpy (buf, ec->data + extoff, csize);
+                break;
+            }
+
             {
                 char *tmp;
                 uint64_t zsize;
@@ -1780,7 +2141,7 @@ static fsw_status_t fsw_btrfs_get_extent(struct fsw_volume *volg, struct fsw_dno
                 FreePool (tmp);
 
                 if (ret != (fsw_ssize_t) csize) {
-                    FreePool(tmp);
+                    FreePool(buf);
                     return -FSW_VOLUME_CORRUPTED;
                 }
 
@@ -38,14 +38,23 @@
  */
 
 #include "fsw_core.h"
-#include "fsw_efi.h"
 
 
 // functions
 
+static fsw_status_t fsw_blockcache_init(struct fsw_volume *vol);
+static void fsw_blockcache_lru_unlink(struct fsw_volume *vol, struct fsw_blockcache *bc);
 static void fsw_blockcache_free(struct fsw_volume *vol);
+static fsw_status_t fsw_dcache_lookup(struct fsw_dnode *dno, struct fsw_string *lookup_name,
+                                      struct fsw_dnode **child_dno_out);
+static void fsw_dcache_flush(struct fsw_volume *vol);
 
-#define MAX_CACHE_LEVEL (5)
+/** Largest number of blocks passed to the host's read_blocks function in one call. */
+#define FSW_MAX_READ_BLOCKS (4096)
+
+/** Hash bucket index of a physical block number in the block cache. */
+#define FSW_BCACHE_HASH(vol, bno) \
+    (((fsw_u32)(bno) ^ (fsw_u32)FSW_U64_SHR((bno), 32)) & (vol)->bcache_hash_mask)
 
 /**
  * Mount a volume with a given file system driver. This function is called by the
@@ -82,6 +91,8 @@ fsw_status_t fsw_mount(void *host_data,
     vol->host_table     = host_table;
     vol->fstype_table   = fstype_table;
     vol->host_string_type = host_table->native_string_type;
+    vol->bcache_max_bytes = FSW_BCACHE_MAX_BYTES;
+    vol->dcache_max     = FSW_DCACHE_MAX_ENTRIES;
 
     // let the fs driver mount the file system
     status = vol->fstype_table->volume_mount(vol);
@@ -108,6 +119,7 @@ errorexit:
 
 void fsw_unmount(struct fsw_volume *vol)
 {
+    fsw_dcache_flush(vol);
     if (vol->root)
         fsw_dnode_release(vol->root);
     // TODO: check that no other dnodes are still around
@@ -176,110 +188,162 @@ void fsw_set_blocksize(struct fsw_volume *vol, fsw_u32 phys_blocksize, fsw_u32 l
  *
  * If this function returns successfully, the returned data pointer is valid until the
  * caller calls fsw_block_release.
+ *
+ * Cached blocks are found through a hash of the physical block number. Once the data
+ * held by the cache reaches vol->bcache_max_bytes, the least recently released block
+ * of the lowest populated cache level is recycled. Blocks still in use are never
+ * evicted, so the cache can grow past the ceiling while many blocks are held.
  */
 
 fsw_status_t fsw_block_get(struct VOLSTRUCTNAME *vol, fsw_u64 phys_bno, fsw_u32 cache_level, void **buffer_out)
 {
     fsw_status_t    status;
-    fsw_u32         i, discard_level, new_bcache_size;
-    struct fsw_blockcache *new_bcache;
+    fsw_u32         bucket, level;
+    struct fsw_blockcache *bc, **link;
 
     // TODO: allow the host driver to do its own caching; just call through if
     //  the appropriate function pointers are set
 
-    if (cache_level > MAX_CACHE_LEVEL)
-        cache_level = MAX_CACHE_LEVEL;
+    if (cache_level > FSW_MAX_CACHE_LEVEL)
+        cache_level = FSW_MAX_CACHE_LEVEL;
+
+    if (vol->bcache_hash == NULL) {
+        status = fsw_blockcache_init(vol);
+        if (status)
+            return status;
+    }
 
     // check block cache
-    for (i = 0; i < vol->bcache_size; i++) {
-        if (vol->bcache[i].phys_bno == phys_bno) {
+    bucket = FSW_BCACHE_HASH(vol, phys_bno);
+    for (bc = vol->bcache_hash[bucket]; bc != NULL; bc = bc->hash_next) {
+        if (bc->phys_bno == phys_bno) {
             // cache hit!
-            if (vol->bcache[i].cache_level < cache_level)
-                vol->bcache[i].cache_level = cache_level;  // promote the entry
-            vol->bcache[i].refcount++;
-            *buffer_out = vol->bcache[i].data;
+            if (bc->refcount == 0)
+                fsw_blockcache_lru_unlink(vol, bc);
+            if (bc->cache_level < cache_level)
+                bc->cache_level = cache_level;  // promote the entry
+            bc->refcount++;
+            *buffer_out = bc->data;
             return FSW_SUCCESS;
         }
     }
 
-    // find a free entry in the cache table
-    for (i = 0; i < vol->bcache_size; i++) {
-        if (vol->bcache[i].phys_bno == (fsw_u64)FSW_INVALID_BNO)
-            break;
-    }
-    if (i >= vol->bcache_size) {
-        for (discard_level = 0; discard_level <= MAX_CACHE_LEVEL; discard_level++) {
-            for (i = 0; i < vol->bcache_size; i++) {
-                if (vol->bcache[i].refcount == 0 && vol->bcache[i].cache_level <= discard_level)
-                    break;
-            }
-            if (i < vol->bcache_size)
+    // recycle the least recently used entry of the lowest level once the ceiling is reached
+    bc = NULL;
+    if ((fsw_u64)vol->bcache_size * vol->phys_blocksize >= vol->bcache_max_bytes) {
+        for (level = 0; level <= FSW_MAX_CACHE_LEVEL; level++) {
+            if (vol->bcache_lru_tail[level] != NULL) {
+                bc = vol->bcache_lru_tail[level];
                 break;
+            }
         }
     }
-    if (i >= vol->bcache_size) {
-        // enlarge / create the cache
-        if (vol->bcache_size < 16)
-            new_bcache_size = 16;
-        else
-            new_bcache_size = vol->bcache_size << 1;
-        status = fsw_alloc(new_bcache_size * sizeof (struct fsw_blockcache), &new_bcache);
+    if (bc != NULL) {
+        fsw_blockcache_lru_unlink(vol, bc);
+        for (link = &vol->bcache_hash[FSW_BCACHE_HASH(vol, bc->phys_bno)]; *link != bc; link = &(*link)->hash_next)
+            ;
+        *link = bc->hash_next;
+    } else {
+        // below the ceiling, or every entry is in use: add a new entry
+        status = fsw_alloc(sizeof (struct fsw_blockcache) + vol->phys_blocksize, &bc);
         if (status)
             return status;
-        if (vol->bcache_size > 0)
-            fsw_memcpy(new_bcache, vol->bcache, vol->bcache_size * sizeof (struct fsw_blockcache));
-        for (i = vol->bcache_size; i < new_bcache_size; i++) {
-            new_bcache[i].refcount = 0;
-            new_bcache[i].cache_level = 0;
-            new_bcache[i].phys_bno = (fsw_u64)FSW_INVALID_BNO;
-            new_bcache[i].data = NULL;
-        }
-        i = vol->bcache_size;
-
-        // switch caches
-        if (vol->bcache != NULL)
-            fsw_free(vol->bcache);
-        vol->bcache = new_bcache;
-        vol->bcache_size = new_bcache_size;
+        bc->data = bc + 1;
+        vol->bcache_size++;
     }
-    vol->bcache[i].phys_bno = (fsw_u64)FSW_INVALID_BNO;
 
     // read the data
-    if (vol->bcache[i].data == NULL) {
-        status = fsw_alloc(vol->phys_blocksize, &vol->bcache[i].data);
-        if (status)
-            return status;
-    }
-    status = vol->host_table->read_block(vol, phys_bno, vol->bcache[i].data);
-    if (status)
+    status = vol->host_table->read_block(vol, phys_bno, bc->data);
+    if (status) {
+        fsw_free(bc);
+        vol->bcache_size--;
         return status;
+    }
 
-    vol->bcache[i].phys_bno = phys_bno;
-    vol->bcache[i].cache_level = cache_level;
-    vol->bcache[i].refcount = 1;
-    *buffer_out = vol->bcache[i].data;
+    bc->phys_bno = phys_bno;
+    bc->cache_level = cache_level;
+    bc->refcount = 1;
+    bc->lru_prev = NULL;
+    bc->lru_next = NULL;
+    bc->hash_next = vol->bcache_hash[bucket];
+    vol->bcache_hash[bucket] = bc;
+    *buffer_out = bc->data;
     return FSW_SUCCESS;
 }
 
 /**
  * Releases a disk block. This function must be called to release disk blocks returned
- * from fsw_block_get.
+ * from fsw_block_get. Once the last reference is dropped, the block becomes the most
+ * recently used candidate for eviction at its cache level.
  */
 
 void fsw_block_release(struct VOLSTRUCTNAME *vol, fsw_u64 phys_bno, void *buffer)
 {
-    fsw_u32 i;
+    struct fsw_blockcache *bc;
 
     // TODO: allow the host driver to do its own caching; just call through if
     //  the appropriate function pointers are set
 
+    if (vol->bcache_hash == NULL)
+        return;
+
     // update block cache
-    for (i = 0; i < vol->bcache_size; i++) {
-        if (vol->bcache[i].phys_bno == phys_bno && vol->bcache[i].refcount > 0)
-            vol->bcache[i].refcount--;
+    for (bc = vol->bcache_hash[FSW_BCACHE_HASH(vol, phys_bno)]; bc != NULL; bc = bc->hash_next) {
+        if (bc->phys_bno == phys_bno) {
+            if (bc->refcount > 0 && --bc->refcount == 0) {
+                bc->lru_prev = NULL;
+                bc->lru_next = vol->bcache_lru_head[bc->cache_level];
+                if (bc->lru_next != NULL)
+                    bc->lru_next->lru_prev = bc;
+                else
+                    vol->bcache_lru_tail[bc->cache_level] = bc;
+                vol->bcache_lru_head[bc->cache_level] = bc;
+            }
+            break;
+        }
     }
 }
 
+/**
+ * Set up the hash buckets of the block cache. Called internally on the first block
+ * access after mounting or changing block sizes. The bucket count is derived from
+ * the number of blocks that fit under the memory ceiling.
+ */
+
+static fsw_status_t fsw_blockcache_init(struct fsw_volume *vol)
+{
+    fsw_status_t    status;
+    fsw_u32         buckets, max_entries;
+
+    max_entries = vol->bcache_max_bytes / vol->phys_blocksize;
+    for (buckets = 64; buckets < 8192 && buckets * 4 < max_entries; buckets <<= 1)
+        ;
+
+    status = fsw_alloc_zero(buckets * sizeof (struct fsw_blockcache *), (void **) &vol->bcache_hash);
+    if (status)
+        return status;
+    vol->bcache_hash_mask = buckets - 1;
+    return FSW_SUCCESS;
+}
+
+/**
+ * Remove an unreferenced entry from the LRU list of its cache level.
+ */
+
+static void fsw_blockcache_lru_unlink(struct fsw_volume *vol, struct fsw_blockcache *bc)
+{
+    if (bc->lru_prev != NULL)
+        bc->lru_prev->lru_next = bc->lru_next;
+    else
+        vol->bcache_lru_head[bc->cache_level] = bc->lru_next;
+    if (bc->lru_next != NULL)
+        bc->lru_next->lru_prev = bc->lru_prev;
+    else
+        vol->bcache_lru_tail[bc->cache_level] = bc->lru_prev;
+    bc->lru_prev = NULL;
+    bc->lru_next = NULL;
+}
+
 /**
  * Release the block cache. Called internally when changing block sizes and when
  * unmounting the volume. It frees all data occupied by the generic block cache.
@@ -288,17 +352,24 @@ void fsw_block_release(struct VOLSTRUCTNAME *vol, fsw_u64 phys_bno, void *buffer
 static void fsw_blockcache_free(struct fsw_volume *vol)
 {
     fsw_u32 i;
+    struct fsw_blockcache *bc, *next;
 
-    for (i = 0; i < vol->bcache_size; i++) {
-        if (vol->bcache[i].data != NULL)
-            fsw_free(vol->bcache[i].data);
-    }
-    if (vol->bcache != NULL) {
-        fsw_free(vol->bcache);
-        vol->bcache = NULL;
+    if (vol->bcache_hash != NULL) {
+        for (i = 0; i <= vol->bcache_hash_mask; i++) {
+            for (bc = vol->bcache_hash[i]; bc != NULL; bc = next) {
+                next = bc->hash_next;
+                fsw_free(bc);
+            }
+        }
+        fsw_free(vol->bcache_hash);
+        vol->bcache_hash = NULL;
     }
+    vol->bcache_hash_mask = 0;
     vol->bcache_size = 0;
-    fsw_efi_clear_cache();
+    for (i = 0; i <= FSW_MAX_CACHE_LEVEL; i++) {
+        vol->bcache_lru_head[i] = NULL;
+        vol->bcache_lru_tail[i] = NULL;
+    }
 }
 
 /**
@@ -517,6 +588,9 @@ fsw_status_t fsw_dnode_stat(struct fsw_dnode *dno, struct fsw_dnode_stat *sb)
  * If the dnode is not a directory, the call will fail. The caller is responsible for
  * resolving symbolic links before calling this function.
  *
+ * Results, including names that were not found, are kept in the volume's name lookup
+ * cache, so repeated lookups of the same name do not reach the file system driver.
+ *
  * If the function returns FSW_SUCCESS, *child_dno_out points to the requested directory
  * entry. The caller must call fsw_dnode_release on it.
  */
@@ -532,7 +606,143 @@ fsw_status_t fsw_dnode_lookup(struct fsw_dnode *dno,
     if (dno->type != FSW_DNODE_TYPE_DIR)
         return FSW_UNSUPPORTED;
 
-    return dno->vol->fstype_table->dir_lookup(dno->vol, dno, lookup_name, child_dno_out);
+    return fsw_dcache_lookup(dno, lookup_name, child_dno_out);
+}
+
+/**
+ * Hash a name lookup by the parent's ids and the raw bytes of the name.
+ */
+
+static fsw_u32 fsw_dcache_hash(struct fsw_dnode *dno, struct fsw_string *name)
+{
+    fsw_u32         hash, i;
+    fsw_u8          *p = (fsw_u8 *)name->data;
+
+    hash = 2166136261U ^ (fsw_u32)dno->dnode_id ^ ((fsw_u32)dno->tree_id << 16);
+    for (i = 0; i < (fsw_u32)name->size; i++)
+        hash = (hash ^ p[i]) * 16777619U;
+    return hash;
+}
+
+/**
+ * Remove an entry from the name lookup cache, dropping its dnode references.
+ */
+
+static void fsw_dcache_evict(struct fsw_volume *vol, struct fsw_dcache_entry *dce)
+{
+    struct fsw_dcache_entry **link;
+
+    for (link = &vol->dcache_hash[dce->hash & (FSW_DCACHE_HASH_SIZE - 1)]; *link != dce; link = &(*link)->hash_next)
+        ;
+    *link = dce->hash_next;
+
+    if (dce->lru_prev != NULL)
+        dce->lru_prev->lru_next = dce->lru_next;
+    else
+        vol->dcache_lru_head = dce->lru_next;
+    if (dce->lru_next != NULL)
+        dce->lru_next->lru_prev = dce->lru_prev;
+    else
+        vol->dcache_lru_tail = dce->lru_prev;
+    vol->dcache_size--;
+
+    if (dce->child != NULL)
+        fsw_dnode_release(dce->child);
+    fsw_dnode_release(dce->parent);
+    fsw_strfree(&dce->name);
+    fsw_free(dce);
+}
+
+/**
+ * Look up a name in a directory through the volume's name lookup cache. On a miss,
+ * the file system driver's dir_lookup is called and its result, found or not found,
+ * is recorded. Other errors are passed on without being cached. Once the cache holds
+ * vol->dcache_max entries, the least recently used one is dropped.
+ */
+
+static fsw_status_t fsw_dcache_lookup(struct fsw_dnode *dno, struct fsw_string *lookup_name,
+                                      struct fsw_dnode **child_dno_out)
+{
+    fsw_status_t    status;
+    struct fsw_volume *vol = dno->vol;
+    struct fsw_dcache_entry *dce;
+    struct fsw_dnode *child_dno = NULL;
+    fsw_u32         hash, bucket;
+
+    if (vol->dcache_max == 0)
+        return vol->fstype_table->dir_lookup(vol, dno, lookup_name, child_dno_out);
+
+    // check the cache
+    hash = fsw_dcache_hash(dno, lookup_name);
+    bucket = hash & (FSW_DCACHE_HASH_SIZE - 1);
+    for (dce = vol->dcache_hash[bucket]; dce != NULL; dce = dce->hash_next) {
+        if (dce->hash == hash && dce->parent == dno &&
+            dce->name.type == lookup_name->type && fsw_streq(&dce->name, lookup_name)) {
+            // cache hit! move it to the front of the LRU list
+            if (dce->lru_prev != NULL) {
+                dce->lru_prev->lru_next = dce->lru_next;
+                if (dce->lru_next != NULL)
+                    dce->lru_next->lru_prev = dce->lru_prev;
+                else
+                    vol->dcache_lru_tail = dce->lru_prev;
+                dce->lru_prev = NULL;
+                dce->lru_next = vol->dcache_lru_head;
+                vol->dcache_lru_head->lru_prev = dce;
+                vol->dcache_lru_head = dce;
+            }
+
+            if (dce->child == NULL)
+                return FSW_NOT_FOUND;
+            fsw_dnode_retain(dce->child);
+            *child_dno_out = dce->child;
+            return FSW_SUCCESS;
+        }
+    }
+
+    status = vol->fstype_table->dir_lookup(vol, dno, lookup_name, &child_dno);
+    if (status != FSW_SUCCESS && status != FSW_NOT_FOUND)
+        return status;
+
+    // record the result; caching is best effort, so allocation failures are ignored
+    if (vol->dcache_size >= vol->dcache_max)
+        fsw_dcache_evict(vol, vol->dcache_lru_tail);
+    if (fsw_alloc(sizeof (struct fsw_dcache_entry), &dce) == FSW_SUCCESS) {
+        if (fsw_strdup_coerce(&dce->name, lookup_name->type, lookup_name) == FSW_SUCCESS) {
+            dce->parent = dno;
+            fsw_dnode_retain(dno);
+            dce->child = (status == FSW_SUCCESS) ? child_dno : NULL;
+            if (dce->child != NULL)
+                fsw_dnode_retain(dce->child);
+            dce->hash = hash;
+            dce->hash_next = vol->dcache_hash[bucket];
+            vol->dcache_hash[bucket] = dce;
+            dce->lru_prev = NULL;
+            dce->lru_next = vol->dcache_lru_head;
+            if (dce->lru_next != NULL)
+                dce->lru_next->lru_prev = dce;
+            else
+                vol->dcache_lru_tail = dce;
+            vol->dcache_lru_head = dce;
+            vol->dcache_size++;
+        } else {
+            fsw_free(dce);
+        }
+    }
+
+    if (status == FSW_SUCCESS)
+        *child_dno_out = child_dno;
+    return status;
+}
+
+/**
+ * Drop all entries of the name lookup cache. Called internally when unmounting the
+ * volume, before the remaining dnodes are released.
+ */
+
+static void fsw_dcache_flush(struct fsw_volume *vol)
+{
+    while (vol->dcache_lru_tail != NULL)
+        fsw_dcache_evict(vol, vol->dcache_lru_tail);
 }
 
 /**
@@ -624,7 +834,7 @@ fsw_status_t fsw_dnode_lookup_path(struct fsw_dnode *dno,
 
             } else {
                 // do an actual lookup
-                status = vol->fstype_table->dir_lookup(vol, dno, &lookup_name, &child_dno);
+                status = fsw_dcache_lookup(dno, &lookup_name, &child_dno);
                 if (status)
                     goto errorexit;
             }
@@ -856,6 +1066,10 @@ void fsw_shandle_close(struct fsw_shandle *shand)
 /**
  * Read data from a shandle (storage handle for a dnode). This function is called by the
  * host driver or internally when data is read from a file. TODO: more
+ *
+ * File data (cache level 0) that covers whole physical blocks is read through the host's
+ * read_blocks function, if provided, directly into the caller's buffer in runs of up to
+ * FSW_MAX_READ_BLOCKS blocks. Everything else goes through the block cache.
  */
 
 fsw_status_t fsw_shandle_read(struct fsw_shandle *shand, fsw_u32 *buffer_size_inout, void *buffer_in)
@@ -865,7 +1079,7 @@ fsw_status_t fsw_shandle_read(struct fsw_shandle *shand, fsw_u32 *buffer_size_in
     struct fsw_volume *vol = dno->vol;
     fsw_u8          *buffer, *block_buffer;
     fsw_u64         buflen, copylen, pos;
-    fsw_u64         log_bno, pos_in_extent, phys_bno, pos_in_physblock;
+    fsw_u64         log_bno, pos_in_extent, phys_bno, pos_in_physblock, block_count;
     fsw_u32         cache_level;
 
     if (shand->pos >= dno->size) {   // already at EOF
@@ -908,6 +1122,28 @@ fsw_status_t fsw_shandle_read(struct fsw_shandle *shand, fsw_u32 *buffer_size_in
             // convert to physical block number and offset
             phys_bno = shand->extent.phys_start + FSW_U64_DIV(pos_in_extent, vol->phys_blocksize);
             pos_in_physblock = pos_in_extent & (vol->phys_blocksize - 1);
+
+            if (cache_level == 0 && pos_in_physblock == 0 &&
+                buflen >= vol->phys_blocksize && vol->host_table->read_blocks != NULL) {
+                // Read whole blocks of file data straight into the caller's buffer
+                block_count = FSW_U64_DIV((fsw_u64)shand->extent.log_count * vol->log_blocksize - pos_in_extent,
+                                          vol->phys_blocksize);
+                if (block_count > FSW_U64_DIV(buflen, vol->phys_blocksize))
+                    block_count = FSW_U64_DIV(buflen, vol->phys_blocksize);
+                if (block_count > FSW_MAX_READ_BLOCKS)
+                    block_count = FSW_MAX_READ_BLOCKS;
+
+                status = vol->host_table->read_blocks(vol, phys_bno, (fsw_u32)block_count, buffer);
+                if (status)
+                    return status;
+
+                copylen = block_count * vol->phys_blocksize;
+                buffer += copylen;
+                buflen -= copylen;
+                pos    += copylen;
+                continue;
+            }
+
             copylen = vol->phys_blocksize - pos_in_physblock;
             if (copylen > buflen)
                 copylen = buflen;
@@ -56,6 +56,22 @@
 /** Indicates that the block cache entry is empty. */
 #define FSW_INVALID_BNO 0xFFFFFFFFFFFFFFFF
 
+/** Highest cache level accepted by fsw_block_get. */
+#define FSW_MAX_CACHE_LEVEL (5)
+
+/** Default number of name lookup results cached per volume. */
+#ifndef FSW_DCACHE_MAX_ENTRIES
+#define FSW_DCACHE_MAX_ENTRIES (256)
+#endif
+
+/** Number of hash buckets in the name lookup cache (a power of 2). */
+#define FSW_DCACHE_HASH_SIZE (64)
+
+/** Default memory ceiling for the block cache of a volume, in bytes. */
+#ifndef FSW_BCACHE_MAX_BYTES
+#define FSW_BCACHE_MAX_BYTES (16 * 1024 * 1024)
+#endif
+
 
 //
 // Byte-swapping macros
@@ -213,6 +229,26 @@ struct fsw_blockcache {
     fsw_u32     cache_level;        //!< Level of importance of this block
     fsw_u64     phys_bno;           //!< Physical block number
     void        *data;              //!< Block data buffer
+
+    struct fsw_blockcache *hash_next;   //!< Next entry in the same hash bucket
+    struct fsw_blockcache *lru_prev;    //!< LRU list of unreferenced entries: more recently used
+    struct fsw_blockcache *lru_next;    //!< LRU list of unreferenced entries: less recently used
+};
+
+/**
+ * Core: A cached result of a name lookup in a directory. A NULL child records
+ * that the name does not exist. The entry holds references on both dnodes.
+ */
+
+struct fsw_dcache_entry {
+    struct fsw_dnode *parent;       //!< Directory the name was looked up in
+    struct fsw_dnode *child;        //!< Dnode found for the name, NULL if not found
+    struct fsw_string name;         //!< Copy of the name looked up
+    fsw_u32     hash;               //!< Hash of parent and name
+
+    struct fsw_dcache_entry *hash_next;     //!< Next entry in the same hash bucket
+    struct fsw_dcache_entry *lru_prev;      //!< LRU list: more recently used
+    struct fsw_dcache_entry *lru_next;      //!< LRU list: less recently used
 };
 
 /**
@@ -228,8 +264,18 @@ struct fsw_volume {
 
     struct fsw_dnode *dnode_head;   //!< List of all dnodes allocated for this volume
 
-    struct fsw_blockcache *bcache;  //!< Array of block cache entries
-    fsw_u32     bcache_size;        //!< Number of entries in the block cache array
+    struct fsw_blockcache **bcache_hash;    //!< Hash buckets of block cache entries, keyed by phys_bno
+    fsw_u32     bcache_hash_mask;   //!< Number of hash buckets minus one
+    fsw_u32     bcache_size;        //!< Number of entries in the block cache
+    fsw_u32     bcache_max_bytes;   //!< Memory ceiling for cached block data
+    struct fsw_blockcache *bcache_lru_head[FSW_MAX_CACHE_LEVEL + 1];  //!< Most recently released entry per level
+    struct fsw_blockcache *bcache_lru_tail[FSW_MAX_CACHE_LEVEL + 1];  //!< Least recently released entry per level
+
+    struct fsw_dcache_entry *dcache_hash[FSW_DCACHE_HASH_SIZE];  //!< Hash buckets of the name lookup cache
+    struct fsw_dcache_entry *dcache_lru_head;   //!< Most recently used name lookup
+    struct fsw_dcache_entry *dcache_lru_tail;   //!< Least recently used name lookup
+    fsw_u32     dcache_size;        //!< Number of entries in the name lookup cache
+    fsw_u32     dcache_max;         //!< Maximum number of entries in the name lookup cache, 0 disables it
 
     void        *host_data;         //!< Hook for a host-specific data structure
     struct fsw_host_table *host_table;      //!< Dispatch table for host-specific functions
@@ -343,6 +389,7 @@ struct fsw_host_table
                                      fsw_u32 old_phys_blocksize, fsw_u32 old_log_blocksize,
                                      fsw_u32 new_phys_blocksize, fsw_u32 new_log_blocksize);
     fsw_status_t EFIAPI (*read_block)(struct fsw_volume *vol, fsw_u64 phys_bno, void *buffer);
+    fsw_status_t EFIAPI (*read_blocks)(struct fsw_volume *vol, fsw_u64 phys_bno, fsw_u32 count, void *buffer); //!< Optional, may be NULL
 };
 
 /**
@@ -64,6 +64,7 @@
 
 #include "../include/refit_call_wrapper.h"
 #include "../include/version.h"
+#include "../include/mem_log_profiler.h"
 
 #define DEBUG_LEVEL 0
 
@@ -82,9 +83,20 @@ EFI_GUID gMyEfiFileSystemVolumeLabelInfoIdGuid = EFI_FILE_SYSTEM_VOLUME_LABEL_IN
 
 /** Helper macro for stringification. */
 #define FSW_EFI_STRINGIFY(x) #x
+#define FSW_EFI_XSTRINGIFY(x) FSW_EFI_STRINGIFY(x)
 /** Expands to the UEFI driver name given the file system type name. */
 #define FSW_EFI_DRIVER_NAME(t) L"RefindPlus " FSW_EFI_STRINGIFY(t) L" File System Driver"
 
+#if defined(__MAKEWITH_TIANO) && !defined(EFIAARCH64)
+/** Boot profiler span ring published by a RefindPlus DBG build, if any. */
+static MEM_LOG_PROFILE *fsw_efi_profile = NULL;
+EFI_GUID gMyMemLogProfileProtocolGuid  = MEM_LOG_PROFILE_PROTOCOL_GUID;
+#endif
+
+/** Span names for the boot profiler. */
+#define FSW_EFI_SPAN_MOUNT "FSW Mount (" FSW_EFI_XSTRINGIFY(FSTYPE) ")"
+#define FSW_EFI_SPAN_READ  "FSW Read (" FSW_EFI_XSTRINGIFY(FSTYPE) ")"
+
 // function prototypes
 
 EFI_STATUS EFIAPI fsw_efi_DriverBinding_Supported(
@@ -127,6 +139,12 @@ fsw_status_t EFIAPI fsw_efi_read_block(
     fsw_u64 phys_bno,
     void *buffer
 );
+fsw_status_t EFIAPI fsw_efi_read_blocks(
+    struct fsw_volume *vol,
+    fsw_u64 phys_bno,
+    fsw_u32 count,
+    void *buffer
+);
 EFI_STATUS fsw_efi_map_status(
     fsw_status_t     fsw_status,
     FSW_VOLUME_DATA *Volume
@@ -181,22 +199,6 @@ EFI_STATUS fsw_efi_dnode_fill_FileInfo(
     OUT VOID *Buffer
 );
 
-/**
- * Structure for holding disk cache data.
- */
-
-#define CACHE_SIZE 131072 /* 128KiB */
-struct cache_data {
-   fsw_u8            *Cache;
-   fsw_u64           CacheStart;
-   BOOLEAN           CacheValid;
-   FSW_VOLUME_DATA   *Volume; // NOTE: Do not deallocate; copied here to ID volume
-};
-
-#define NUM_CACHES 2 /* Do not increase without modifying fsw_efi_read_block() */
-static struct cache_data    Caches[NUM_CACHES];
-static int LastRead = -1;
-
 /**
  * Interface structure for the UEFI Driver Binding protocol.
  */
@@ -225,27 +227,89 @@ REFINDPLUS_EFI_COMPONENT_NAME_PROTOCOL fsw_efi_ComponentName_table = {
 struct fsw_host_table   fsw_efi_host_table = {
     FSW_STRING_TYPE_UTF16,
     fsw_efi_change_blocksize,
-    fsw_efi_read_block
+    fsw_efi_read_block,
+    fsw_efi_read_blocks
 };
 
 extern struct fsw_fstype_table   FSW_FSTYPE_TABLE_NAME(FSTYPE);
 
 
-VOID EFIAPI fsw_efi_clear_cache(VOID) {
-   int i;
+/**
+ * Drop the readahead windows of a volume and free their buffers. Called when the
+ * volume is opened, when its block size changes and before it is released.
+ */
+
+/**
+ * Opens a boot profiler span. Returns MEM_LOG_SPAN_NONE when no
+ * profiler has been published.
+ */
+
+static UINTN fsw_efi_span_begin(const CHAR8 *Name) {
+#if defined(__MAKEWITH_TIANO) && !defined(EFIAARCH64)
+    MEM_LOG_SPAN    *Span;
+    UINTN           Handle;
+
+    if (fsw_efi_profile == NULL) {
+        return MEM_LOG_SPAN_NONE;
+    }
+
+    Handle = fsw_efi_profile->SpanCount++;
+    Span = &fsw_efi_profile->Spans[Handle % MEM_LOG_SPAN_RING_SIZE];
+    Span->Name     = Name;
+    Span->Depth    = fsw_efi_profile->SpanDepth++;
+    Span->TscEnd   = 0;
+    Span->TscBegin = AsmReadTsc();
+
+    return Handle;
+#else
+    return MEM_LOG_SPAN_NONE;
+#endif
+}
+
+/**
+ * Closes a boot profiler span opened with fsw_efi_span_begin.
+ */
+
+static void fsw_efi_span_end(UINTN Handle) {
+#if defined(__MAKEWITH_TIANO) && !defined(EFIAARCH64)
+    UINT64          Tsc = AsmReadTsc();
+
+    if (fsw_efi_profile == NULL || Handle >= fsw_efi_profile->SpanCount) {
+        return;
+    }
+    if (fsw_efi_profile->SpanDepth > 0) {
+        fsw_efi_profile->SpanDepth--;
+    }
+    if (fsw_efi_profile->SpanCount - Handle <= MEM_LOG_SPAN_RING_SIZE) {
+        fsw_efi_profile->Spans[Handle % MEM_LOG_SPAN_RING_SIZE].TscEnd = Tsc;
+    }
+#endif
+}
+
+VOID EFIAPI fsw_efi_clear_cache(FSW_VOLUME_DATA *Volume) {
+   UINTN i;
+
+#if DEBUG_LEVEL
+   if (Volume->CacheHits || Volume->CacheMisses) {
+      Print(L"fsw_efi_clear_cache: %lu hits, %lu misses\n", Volume->CacheHits, Volume->CacheMisses);
+   }
+#endif
 
    // clear the cache
-   for (i = 0; i < NUM_CACHES; i++) {
-      if (Caches[i].Cache != NULL) {
-         FreePool(Caches[i].Cache);
-         Caches[i].Cache = NULL;
+   for (i = 0; i < FSW_EFI_NUM_CACHES; i++) {
+      if (Volume->Caches[i].Data != NULL) {
+         FreePool(Volume->Caches[i].Data);
+         Volume->Caches[i].Data = NULL;
       } // if
 
-      Caches[i].CacheStart = 0;
-      Caches[i].CacheValid = FALSE;
-      Caches[i].Volume     = NULL;
+      Volume->Caches[i].Start   = 0;
+      Volume->Caches[i].Size    = 0;
+      Volume->Caches[i].LastUse = 0;
    }
-   LastRead = -1;
+   Volume->CacheWindow = FSW_EFI_CACHE_INIT_SIZE;
+   Volume->CacheClock  = 0;
+   Volume->CacheHits   = 0;
+   Volume->CacheMisses = 0;
 } // VOID EFIAPI fsw_efi_clear_cache();
 
 /**
@@ -359,11 +423,22 @@ fsw_efi_DriverBinding_Start(
     EFI_BLOCK_IO        *BlockIo;
     EFI_DISK_IO         *DiskIo;
     FSW_VOLUME_DATA     *Volume;
+    UINTN               Span;
 
 #if DEBUG_LEVEL
     Print(L"fsw_efi_DriverBinding_Start\n");
 #endif
 
+#if defined(__MAKEWITH_TIANO) && !defined(EFIAARCH64)
+    // RefindPlus may have published its profiler since the last mount
+    if (fsw_efi_profile == NULL) {
+        REFIT_CALL_3_WRAPPER(
+            gBS->LocateProtocol, &gMyMemLogProfileProtocolGuid,
+            NULL, (VOID **) &fsw_efi_profile
+        );
+    }
+#endif
+
     // open consumed protocols
     Status = REFIT_CALL_6_WRAPPER(
         gBS->OpenProtocol, ControllerHandle,
@@ -393,8 +468,10 @@ fsw_efi_DriverBinding_Start(
     Volume->DiskIo          = DiskIo;
     Volume->MediaId         = BlockIo->Media->MediaId;
     Volume->LastIOStatus    = EFI_SUCCESS;
+    Volume->CacheWindow     = FSW_EFI_CACHE_INIT_SIZE;
 
     // mount the filesystem
+    Span = fsw_efi_span_begin(FSW_EFI_SPAN_MOUNT);
     Status = fsw_efi_map_status(
         fsw_mount(
             Volume,
@@ -404,6 +481,7 @@ fsw_efi_DriverBinding_Start(
         ),
         Volume
     );
+    fsw_efi_span_end(Span);
     if (!EFI_ERROR(Status)) {
         // register the SimpleFileSystem protocol
         Volume->FileSystem.Revision     = EFI_FILE_IO_INTERFACE_REVISION;
@@ -420,6 +498,7 @@ fsw_efi_DriverBinding_Start(
         if (Volume->vol != NULL) {
             fsw_unmount(Volume->vol);
         }
+        fsw_efi_clear_cache(Volume);
         FreePool(Volume);
 
         REFIT_CALL_4_WRAPPER(
@@ -484,6 +563,7 @@ EFI_STATUS EFIAPI fsw_efi_DriverBinding_Stop(
     if (Volume->vol != NULL) {
         fsw_unmount(Volume->vol);
     }
+    fsw_efi_clear_cache(Volume);
     FreePool(Volume);
 
     // Close the consumed protocols
@@ -492,9 +572,6 @@ EFI_STATUS EFIAPI fsw_efi_DriverBinding_Stop(
         &gMyEfiDiskIoProtocolGuid, This->DriverBindingHandle, ControllerHandle
     );
 
-    // Clear the cache
-    fsw_efi_clear_cache();
-
     return Status;
 }
 
@@ -548,19 +625,21 @@ void EFIAPI fsw_efi_change_blocksize(
     fsw_u32 new_phys_blocksize,
     fsw_u32 new_log_blocksize)
 {
-    // nothing to do
-    return;
+    // drop the readahead windows; they may straddle the new block boundaries
+    fsw_efi_clear_cache((FSW_VOLUME_DATA *)vol->host_data);
 }
 
 /**
  * FSW interface function to read data blocks. This function is called by the FSW core
  * to read a block of data from the device. The buffer is allocated by the core code.
- * Two caches are maintained, so as to improve performance on some systems. (VirtualBox
- * is particularly susceptible to performance problems with an uncached driver -- the
- * ext2 driver can take 200 seconds to load a Linux kernel under VirtualBox, whereas
- * the time is more like 3 seconds with a cache!) Two independent caches are maintained
- * because the ext2fs driver tends to alternate between accessing two parts of the
- * disk.
+ * Each volume keeps FSW_EFI_NUM_CACHES readahead windows, so as to improve performance
+ * on some systems. (VirtualBox is particularly susceptible to performance problems with
+ * an uncached driver -- the ext2 driver can take 200 seconds to load a Linux kernel under
+ * VirtualBox, whereas the time is more like 3 seconds with a cache!) Several windows are
+ * kept because file systems tend to alternate between accessing different parts of the
+ * disk. On a miss, the least recently used window is reloaded. A miss that starts right
+ * where a window ends is taken as a sequential stream and grows the next window, while
+ * other misses shrink it.
  */
 
 fsw_status_t EFIAPI fsw_efi_read_block(
@@ -568,43 +647,60 @@ fsw_status_t EFIAPI fsw_efi_read_block(
     fsw_u64            phys_bno,
     void              *buffer
 ) {
-   int              i, ReadCache = -1;
+   UINTN            i;
    FSW_VOLUME_DATA  *Volume = (FSW_VOLUME_DATA *)vol->host_data;
+   FSW_EFI_CACHE    *Cache = NULL;
    EFI_STATUS       Status = EFI_SUCCESS;
-   BOOLEAN          ReadOneBlock = FALSE;
+   BOOLEAN          Sequential = FALSE;
+   UINTN            ReadSize;
    UINT64           StartRead = (UINT64) phys_bno * (UINT64) vol->phys_blocksize;
 
    if (buffer == NULL)
       return (fsw_status_t) EFI_BAD_BUFFER_SIZE;
 
-   // Initialize static data structures, if necessary.
-   if (LastRead < 0) {
-      fsw_efi_clear_cache();
-   } // if
+   Volume->CacheClock++;
 
    // Look for a cache hit on the current query.
-   i = 0;
-   do {
-      if ((Caches[i].Volume == Volume) &&
-          Caches[i].CacheValid &&
-          (StartRead >= Caches[i].CacheStart) &&
-          ((StartRead + vol->phys_blocksize) <= (Caches[i].CacheStart + CACHE_SIZE))) {
-         ReadCache = i;
+   for (i = 0; i < FSW_EFI_NUM_CACHES; i++) {
+      if ((Volume->Caches[i].Size > 0) &&
+          (StartRead >= Volume->Caches[i].Start) &&
+          ((StartRead + vol->phys_blocksize) <= (Volume->Caches[i].Start + Volume->Caches[i].Size))) {
+         Cache = &Volume->Caches[i];
+         break;
+      }
+      if ((Volume->Caches[i].Size > 0) &&
+          (StartRead == Volume->Caches[i].Start + Volume->Caches[i].Size)) {
+         Sequential = TRUE;
       }
-      i++;
-   } while ((i < NUM_CACHES) && (ReadCache < 0));
-
-   // No cache hit found; load new cache and pass it on.
-   if (ReadCache < 0) {
-      if (LastRead == -1)
-         LastRead = 1;
-      ReadCache = 1 - LastRead; // NOTE: If NUM_CACHES > 2, this must become more complex
-      Caches[ReadCache].CacheValid = FALSE;
-      if (Caches[ReadCache].Cache == NULL) {
-          Caches[ReadCache].Cache = AllocatePool(CACHE_SIZE);
+   }
+
+   if (Cache != NULL) {
+      Volume->CacheHits++;
+   } else {
+      // No cache hit found; load the least recently used window and pass it on.
+      Volume->CacheMisses++;
+      if (Sequential) {
+         if (Volume->CacheWindow < FSW_EFI_CACHE_MAX_SIZE)
+            Volume->CacheWindow <<= 1;
+      } else if (Volume->CacheWindow > FSW_EFI_CACHE_MIN_SIZE) {
+         Volume->CacheWindow >>= 1;
       }
-      if (Caches[ReadCache].Cache == NULL) {
-         ReadOneBlock = TRUE;
+      ReadSize = Volume->CacheWindow;
+      if (ReadSize < vol->phys_blocksize)
+         ReadSize = vol->phys_blocksize;
+
+      Cache = &Volume->Caches[0];
+      for (i = 1; i < FSW_EFI_NUM_CACHES; i++) {
+         if (Volume->Caches[i].LastUse < Cache->LastUse)
+            Cache = &Volume->Caches[i];
+      }
+      Cache->Size = 0;
+      if (Cache->Data == NULL) {
+         Cache->Data = AllocatePool(FSW_EFI_CACHE_MAX_SIZE);
+      }
+
+      if (Cache->Data == NULL || ReadSize > FSW_EFI_CACHE_MAX_SIZE) {
+         Cache = NULL;
       } else {
          // TODO: Below call hangs on my 32-bit Mac Mini when compiled with GNU-EFI.
          // The same binary is fine under VirtualBox, and the same call is fine when
@@ -619,26 +715,21 @@ fsw_status_t EFIAPI fsw_efi_read_block(
          Status = REFIT_CALL_5_WRAPPER(
              Volume->DiskIo->ReadDisk, Volume->DiskIo,
              Volume->MediaId, StartRead,
-             (UINTN) CACHE_SIZE, (VOID*) Caches[ReadCache].Cache
+             ReadSize, (VOID*) Cache->Data
          );
          if (EFI_ERROR(Status)) {
-            ReadOneBlock = TRUE;
+            Cache = NULL;
          } else {
-            Caches[ReadCache].CacheStart = StartRead;
-            Caches[ReadCache].CacheValid = TRUE;
-            Caches[ReadCache].Volume     = Volume;
-            LastRead                     = ReadCache;
+            Cache->Start = StartRead;
+            Cache->Size  = ReadSize;
          }
       } // if cache memory allocated
-   } // if (ReadCache < 0)
-
-   if (Caches[ReadCache].Cache != NULL && Caches[ReadCache].CacheValid && vol->phys_blocksize > 0) {
-      CopyMem(buffer, &Caches[ReadCache].Cache[StartRead - Caches[ReadCache].CacheStart], vol->phys_blocksize);
-   } else {
-      ReadOneBlock = TRUE;
-   }
+   } // if (Cache == NULL)
 
-   if (ReadOneBlock) { // Something's failed, so try a simple disk read of one block.
+   if (Cache != NULL) {
+      Cache->LastUse = Volume->CacheClock;
+      CopyMem(buffer, &Cache->Data[StartRead - Cache->Start], vol->phys_blocksize);
+   } else { // Something's failed, so try a simple disk read of one block.
       Status = REFIT_CALL_5_WRAPPER(
           Volume->DiskIo->ReadDisk, Volume->DiskIo,
           Volume->MediaId, phys_bno * vol->phys_blocksize,
@@ -650,6 +741,34 @@ fsw_status_t EFIAPI fsw_efi_read_block(
    return Status;
 } // fsw_status_t *fsw_efi_read_block()
 
+/**
+ * FSW interface function to read a run of contiguous data blocks. This function is
+ * called by the FSW core to read file data straight into the caller's buffer. The
+ * read bypasses the readahead caches, which are left for metadata access.
+ */
+
+fsw_status_t EFIAPI fsw_efi_read_blocks(
+    struct fsw_volume *vol,
+    fsw_u64            phys_bno,
+    fsw_u32            count,
+    void              *buffer
+) {
+   FSW_VOLUME_DATA  *Volume = (FSW_VOLUME_DATA *)vol->host_data;
+   EFI_STATUS       Status;
+
+   if (buffer == NULL)
+      return (fsw_status_t) EFI_BAD_BUFFER_SIZE;
+
+   Status = REFIT_CALL_5_WRAPPER(
+       Volume->DiskIo->ReadDisk, Volume->DiskIo,
+       Volume->MediaId, phys_bno * vol->phys_blocksize,
+       (UINTN) count * vol->phys_blocksize, (VOID*) buffer
+   );
+   Volume->LastIOStatus = Status;
+
+   return Status;
+} // fsw_status_t *fsw_efi_read_blocks()
+
 /**
  * Map FSW status codes to EFI status codes. The FSW_IO_ERROR code is only produced
  * by fsw_efi_read_block, so we map it back to the EFI status code remembered from
@@ -694,7 +813,7 @@ EFI_STATUS EFIAPI fsw_efi_FileSystem_OpenVolume(
     Print(L"fsw_efi_FileSystem_OpenVolume\n");
 #endif
 
-    fsw_efi_clear_cache();
+    fsw_efi_clear_cache(Volume);
     Status = fsw_efi_dnode_to_FileHandle(Volume->vol->root, Root);
 
     return Status;
@@ -933,15 +1052,18 @@ EFI_STATUS fsw_efi_file_read(
 ) {
     EFI_STATUS          Status;
     fsw_u32             buffer_size;
+    UINTN               Span;
 
 #if DEBUG_LEVEL
     Print(L"fsw_efi_file_read %d bytes\n", *BufferSize);
 #endif
 
+    Span = fsw_efi_span_begin(FSW_EFI_SPAN_READ);
     buffer_size = (fsw_u32)*BufferSize;
     Status = fsw_efi_map_status(fsw_shandle_read(&File->shand, &buffer_size, Buffer),
                                 (FSW_VOLUME_DATA *)File->shand.dnode->vol->host_data);
     *BufferSize = buffer_size;
+    fsw_efi_span_end(Span);
 
     return Status;
 }
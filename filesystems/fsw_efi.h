@@ -54,6 +54,28 @@
     0x964e5b21, 0x6459, 0x11d2, {0x8e, 0x39, 0x0, 0xa0, 0xc9, 0x69, 0x72, 0x3b } \
   }
 
+/** Number of readahead windows kept per volume. */
+#ifndef FSW_EFI_NUM_CACHES
+#define FSW_EFI_NUM_CACHES      (4)
+#endif
+/** Smallest readahead window, used for scattered access. */
+#define FSW_EFI_CACHE_MIN_SIZE  (16384)     /* 16KiB */
+/** Largest readahead window, used for sequential streams. */
+#define FSW_EFI_CACHE_MAX_SIZE  (262144)    /* 256KiB */
+/** Readahead window used until an access pattern is detected. */
+#define FSW_EFI_CACHE_INIT_SIZE (131072)    /* 128KiB */
+
+/**
+ * EFI Host: A readahead window of disk data.
+ */
+
+typedef struct {
+    UINT8                       *Data;          //!< Window buffer, FSW_EFI_CACHE_MAX_SIZE bytes
+    UINT64                      Start;          //!< Disk offset of the first byte in the window
+    UINTN                       Size;           //!< Valid bytes in the window, zero if empty
+    UINT64                      LastUse;        //!< Value of CacheClock at the last hit
+} FSW_EFI_CACHE;
+
 /**
  * EFI Host: Private per-volume structure.
  */
@@ -70,6 +92,12 @@ typedef struct {
 
     struct fsw_volume           *vol;           //!< FSW volume structure
 
+    FSW_EFI_CACHE               Caches[FSW_EFI_NUM_CACHES]; //!< Readahead windows
+    UINTN                       CacheWindow;    //!< Size of the next readahead window
+    UINT64                      CacheClock;     //!< Block read counter, orders the windows by use
+    UINT64                      CacheHits;      //!< Block reads served from a window
+    UINT64                      CacheMisses;    //!< Block reads that loaded a new window
+
 } FSW_VOLUME_DATA;
 
 /** Signature for the volume structure. */
@@ -110,6 +138,6 @@ VOID fsw_efi_decode_time(OUT EFI_TIME *EfiTime, IN UINT32 UnixTime);
 
 UINTN fsw_efi_strsize(struct fsw_string *s);
 VOID fsw_efi_strcpy(CHAR16 *Dest, struct fsw_string *src);
-VOID EFIAPI fsw_efi_clear_cache(VOID);
+VOID EFIAPI fsw_efi_clear_cache(FSW_VOLUME_DATA *Volume);
 
 #endif
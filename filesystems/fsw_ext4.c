@@ -47,6 +47,8 @@ static fsw_status_t fsw_ext4_dir_lookup(struct fsw_ext4_volume *vol, struct fsw_
 static fsw_status_t fsw_ext4_dir_read(struct fsw_ext4_volume *vol, struct fsw_ext4_dnode *dno,
                                       struct fsw_shandle *shand, struct fsw_ext4_dnode **child_dno);
 static fsw_status_t fsw_ext4_read_dentry(struct fsw_shandle *shand, struct ext4_dir_entry *entry);
+static fsw_status_t fsw_ext4_dx_lookup(struct fsw_ext4_volume *vol, struct fsw_ext4_dnode *dno,
+                                       struct fsw_string *lookup_name, struct ext4_dir_entry *entry);
 
 static fsw_status_t fsw_ext4_readlink(struct fsw_ext4_volume *vol, struct fsw_ext4_dnode *dno,
                                       struct fsw_string *link);
@@ -392,77 +394,175 @@ static fsw_status_t fsw_ext4_get_extent(struct fsw_ext4_volume *vol, struct fsw_
     }
 }
 
+/**
+ * Map a logical block through an extent tree leaf. The leaf's extents are sorted by
+ * logical block, so a binary search finds the last extent starting at or before bno.
+ * Blocks not covered by any extent, and unwritten extents, are returned as sparse.
+ * leaf_end bounds the hole after the last extent of the leaf.
+ */
+static void fsw_ext4_map_leaf(struct ext4_extent_header *header, fsw_u32 leaf_end,
+                              struct fsw_extent *extent)
+{
+    fsw_u32       bno, len, next;
+    int           lo, hi, mid;
+    struct ext4_extent *ext4_extent = (struct ext4_extent *)(header + 1);
+
+    bno = (fsw_u32)extent->log_start;
+
+    if (header->eh_entries == 0 || bno < ext4_extent[0].ee_block) {
+        // hole before the first extent
+        next = header->eh_entries ? ext4_extent[0].ee_block : leaf_end;
+        extent->type = FSW_EXTENT_TYPE_SPARSE;
+        extent->log_count = next - bno;
+    } else {
+        lo = 0;
+        hi = header->eh_entries - 1;
+        while (lo < hi) {
+            mid = (lo + hi + 1) / 2;
+            if (ext4_extent[mid].ee_block <= bno)
+                lo = mid;
+            else
+                hi = mid - 1;
+        }
+        FSW_MSG_DEBUG((FSW_MSGSTR("fsw_ext4_map_leaf: extent node cover %d...\n"), ext4_extent[lo].ee_block));
+
+        len = ext4_extent[lo].ee_len;
+        if (len > EXT_INIT_MAX_LEN)
+            len -= EXT_INIT_MAX_LEN;
+
+        if (bno < ext4_extent[lo].ee_block + len) {
+            extent->log_count = ext4_extent[lo].ee_block + len - bno;
+            if (ext4_extent[lo].ee_len > EXT_INIT_MAX_LEN) {
+                // unwritten extent, reads as zeroes
+                extent->type = FSW_EXTENT_TYPE_SPARSE;
+            } else {
+                extent->phys_start = ((fsw_u64)ext4_extent[lo].ee_start_hi << 32) | ext4_extent[lo].ee_start_lo;
+                extent->phys_start += (bno - ext4_extent[lo].ee_block);
+            }
+        } else {
+            // hole after this extent
+            next = (lo + 1 < header->eh_entries) ? ext4_extent[lo + 1].ee_block : leaf_end;
+            extent->type = FSW_EXTENT_TYPE_SPARSE;
+            extent->log_count = next - bno;
+        }
+    }
+
+    if (extent->log_count > EXT_INIT_MAX_LEN)
+        extent->log_count = EXT_INIT_MAX_LEN;
+}
+
 /**
  * New ext4 extents...
+ *
+ * The extent tree is descended from the root in the inode, picking the last index
+ * entry starting at or before the requested block on each level by binary search.
+ * The leaf reached, and the range of logical blocks it covers, are remembered in the
+ * dnode so that the next request in the same range goes straight to that leaf.
  */
 static fsw_status_t fsw_ext4_get_by_extent(struct fsw_ext4_volume *vol, struct fsw_ext4_dnode *dno,
                                         struct fsw_extent *extent)
 {
     fsw_status_t  status;
-    fsw_u32       bno, buf_offset;
-    int           ext_cnt;
+    fsw_u32       bno, leaf_start, leaf_end, max_entries;
+    fsw_u64       leaf_bno, next_bno;
+    int           depth, lo, hi, mid;
     void          *buffer;
 
     struct ext4_extent_header  *ext4_extent_header;
     struct ext4_extent_idx     *ext4_extent_idx;
-    struct ext4_extent         *ext4_extent;
 
     // Logical block requested by core...
-    bno = extent->log_start;
+    bno = (fsw_u32)extent->log_start;
 
-    // First buffer is the i_block field from inode...
-    buffer = (void *)dno->raw->i_block;
-    buf_offset = 0;
-    while(1) {
-        ext4_extent_header = (struct ext4_extent_header *)((char *)buffer + buf_offset);
-        buf_offset += sizeof (struct ext4_extent_header);
-        FSW_MSG_DEBUG((FSW_MSGSTR("fsw_ext4_get_by_extent: extent header with %d entries\n"),
-                      ext4_extent_header->eh_entries));
-        if(ext4_extent_header->eh_magic != EXT4_EXT_MAGIC)
+    if (dno->ext_leaf_bno != 0 && bno >= dno->ext_leaf_start && bno < dno->ext_leaf_end) {
+        // Resume from the leaf used for the previous request
+        leaf_bno = dno->ext_leaf_bno;
+        leaf_end = dno->ext_leaf_end;
+        status = fsw_block_get(vol, leaf_bno, 1, &buffer);
+        if (status)
+            return status;
+        ext4_extent_header = (struct ext4_extent_header *)buffer;
+        max_entries = (vol->g.phys_blocksize - sizeof (struct ext4_extent_header)) / sizeof (struct ext4_extent);
+        if (ext4_extent_header->eh_magic != EXT4_EXT_MAGIC ||
+            ext4_extent_header->eh_depth != 0 ||
+            ext4_extent_header->eh_entries > max_entries) {
+            fsw_block_release(vol, leaf_bno, buffer);
             return FSW_VOLUME_CORRUPTED;
-
-        for(ext_cnt = 0;ext_cnt < ext4_extent_header->eh_entries;ext_cnt++)
-        {
-            if(ext4_extent_header->eh_depth == 0)
-            {
-                // Leaf node, the header follows actual extents
-                ext4_extent = (struct ext4_extent *)((char *)buffer + buf_offset);
-                buf_offset += sizeof (struct ext4_extent);
-                FSW_MSG_DEBUG((FSW_MSGSTR("fsw_ext4_get_by_extent: extent node cover %d...\n"), ext4_extent->ee_block));
-
-                // Is the requested block in this extent?
-                if(bno >= ext4_extent->ee_block && bno < ext4_extent->ee_block + ext4_extent->ee_len)
-                {
-                    extent->phys_start = ((fsw_u64)ext4_extent->ee_start_hi << 32) | ext4_extent->ee_start_lo;
-                    extent->phys_start += (bno - ext4_extent->ee_block);
-                    extent->log_count = ext4_extent->ee_len - (bno - ext4_extent->ee_block);
-                    return FSW_SUCCESS;
-                }
+        }
+    } else {
+        // First buffer is the i_block field from inode...
+        buffer = (void *)dno->raw->i_block;
+        max_entries = (sizeof (dno->raw->i_block) - sizeof (struct ext4_extent_header)) / sizeof (struct ext4_extent);
+        leaf_bno = 0;
+        leaf_start = 0;
+        leaf_end = 0xFFFFFFFF;
+
+        for (depth = 0; ; depth++) {
+            ext4_extent_header = (struct ext4_extent_header *)buffer;
+            FSW_MSG_DEBUG((FSW_MSGSTR("fsw_ext4_get_by_extent: extent header with %d entries\n"),
+                          ext4_extent_header->eh_entries));
+            if (ext4_extent_header->eh_magic != EXT4_EXT_MAGIC ||
+                ext4_extent_header->eh_entries > max_entries ||
+                depth > EXT4_EXT_MAX_DEPTH) {
+                status = FSW_VOLUME_CORRUPTED;
+                goto errorexit;
             }
-            else
-            {
-                FSW_MSG_DEBUG((FSW_MSGSTR("fsw_ext4_get_by_extent: index extents, depth %d\n"),
+            if (ext4_extent_header->eh_depth == 0)
+                break;
+
+            FSW_MSG_DEBUG((FSW_MSGSTR("fsw_ext4_get_by_extent: index extents, depth %d\n"),
                           ext4_extent_header->eh_depth));
-                ext4_extent_idx = (struct ext4_extent_idx *)((char *)buffer + buf_offset);
-                buf_offset += sizeof (struct ext4_extent_idx);
-
-                FSW_MSG_DEBUG((FSW_MSGSTR("fsw_ext4_get_by_extent: index node covers block %d...\n"),
-                          ext4_extent_idx->ei_block));
-                if(bno >= ext4_extent_idx->ei_block)
-                {
-                    // Follow extent tree...
-                    fsw_u64 phys_bno = ((fsw_u64)ext4_extent_idx->ei_leaf_hi << 32) | ext4_extent_idx->ei_leaf_lo;
-                    status = fsw_block_get(vol, phys_bno, 1, (void **) &buffer);
-                    if (status)
-                        return status;
-                    buf_offset = 0;
-                    break;
-                }
+            if (ext4_extent_header->eh_entries == 0) {
+                status = FSW_VOLUME_CORRUPTED;
+                goto errorexit;
+            }
+
+            // Find the last index entry that starts at or before the requested block
+            ext4_extent_idx = (struct ext4_extent_idx *)(ext4_extent_header + 1);
+            lo = 0;
+            hi = ext4_extent_header->eh_entries - 1;
+            while (lo < hi) {
+                mid = (lo + hi + 1) / 2;
+                if (ext4_extent_idx[mid].ei_block <= bno)
+                    lo = mid;
+                else
+                    hi = mid - 1;
             }
+            FSW_MSG_DEBUG((FSW_MSGSTR("fsw_ext4_get_by_extent: index node covers block %d...\n"),
+                          ext4_extent_idx[lo].ei_block));
+
+            // Narrow the range of logical blocks covered below this entry
+            if (ext4_extent_idx[lo].ei_block > leaf_start)
+                leaf_start = ext4_extent_idx[lo].ei_block;
+            if (lo + 1 < ext4_extent_header->eh_entries && ext4_extent_idx[lo + 1].ei_block < leaf_end)
+                leaf_end = ext4_extent_idx[lo + 1].ei_block;
+
+            // Follow extent tree...
+            next_bno = ((fsw_u64)ext4_extent_idx[lo].ei_leaf_hi << 32) | ext4_extent_idx[lo].ei_leaf_lo;
+            if (leaf_bno)
+                fsw_block_release(vol, leaf_bno, buffer);
+            leaf_bno = 0;
+            status = fsw_block_get(vol, next_bno, 1, &buffer);
+            if (status)
+                return status;
+            leaf_bno = next_bno;
+            max_entries = (vol->g.phys_blocksize - sizeof (struct ext4_extent_header)) / sizeof (struct ext4_extent);
+        }
+
+        if (leaf_bno) {
+            dno->ext_leaf_bno = leaf_bno;
+            dno->ext_leaf_start = leaf_start;
+            dno->ext_leaf_end = leaf_end;
         }
     }
 
-    return FSW_NOT_FOUND;
+    fsw_ext4_map_leaf(ext4_extent_header, leaf_end, extent);
+    status = FSW_SUCCESS;
+
+errorexit:
+    if (leaf_bno)
+        fsw_block_release(vol, leaf_bno, buffer);
+    return status;
 }
 
 /**
@@ -574,6 +674,20 @@ static fsw_status_t fsw_ext4_dir_lookup(struct fsw_ext4_volume *vol, struct fsw_
 
     entry_name.type = FSW_STRING_TYPE_ISO88591;
 
+    // use the hash index if the directory has one
+    if ((dno->raw->i_flags & EXT4_INDEX_FL) &&
+        (vol->sb->s_feature_compat & EXT4_FEATURE_COMPAT_DIR_INDEX)) {
+        status = fsw_ext4_dx_lookup(vol, dno, lookup_name, &entry);
+        if (status == FSW_SUCCESS) {
+            entry_name.len = entry_name.size = entry.name_len;
+            entry_name.data = entry.name;
+            return fsw_dnode_create(dno, entry.inode, FSW_DNODE_TYPE_UNKNOWN, &entry_name, child_dno_out);
+        }
+        if (status != FSW_UNSUPPORTED)
+            return status;
+        // the index cannot be used, fall back to scanning the directory
+    }
+
     // setup handle to read the directory
     status = fsw_shandle_open(dno, &shand);
     if (status)
@@ -609,6 +723,355 @@ errorexit:
     return status;
 }
 
+//
+// Directory hash functions, as used by the Linux kernel for htree indexes
+//
+
+#define EXT4_ROL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+#define DX_MD4_F(x, y, z) ((z) ^ ((x) & ((y) ^ (z))))
+#define DX_MD4_G(x, y, z) (((x) & (y)) + (((x) ^ (y)) & (z)))
+#define DX_MD4_H(x, y, z) ((x) ^ (y) ^ (z))
+#define DX_MD4_ROUND(f, a, b, c, d, x, s) (a += f(b, c, d) + (x), a = EXT4_ROL32(a, s))
+#define DX_MD4_K2 013240474631UL
+#define DX_MD4_K3 015666365641UL
+
+static void fsw_ext4_half_md4_transform(fsw_u32 buf[4], const fsw_u32 in[8])
+{
+    fsw_u32 a = buf[0], b = buf[1], c = buf[2], d = buf[3];
+
+    DX_MD4_ROUND(DX_MD4_F, a, b, c, d, in[0],  3);
+    DX_MD4_ROUND(DX_MD4_F, d, a, b, c, in[1],  7);
+    DX_MD4_ROUND(DX_MD4_F, c, d, a, b, in[2], 11);
+    DX_MD4_ROUND(DX_MD4_F, b, c, d, a, in[3], 19);
+    DX_MD4_ROUND(DX_MD4_F, a, b, c, d, in[4],  3);
+    DX_MD4_ROUND(DX_MD4_F, d, a, b, c, in[5],  7);
+    DX_MD4_ROUND(DX_MD4_F, c, d, a, b, in[6], 11);
+    DX_MD4_ROUND(DX_MD4_F, b, c, d, a, in[7], 19);
+
+    DX_MD4_ROUND(DX_MD4_G, a, b, c, d, in[1] + DX_MD4_K2,  3);
+    DX_MD4_ROUND(DX_MD4_G, d, a, b, c, in[3] + DX_MD4_K2,  5);
+    DX_MD4_ROUND(DX_MD4_G, c, d, a, b, in[5] + DX_MD4_K2,  9);
+    DX_MD4_ROUND(DX_MD4_G, b, c, d, a, in[7] + DX_MD4_K2, 13);
+    DX_MD4_ROUND(DX_MD4_G, a, b, c, d, in[0] + DX_MD4_K2,  3);
+    DX_MD4_ROUND(DX_MD4_G, d, a, b, c, in[2] + DX_MD4_K2,  5);
+    DX_MD4_ROUND(DX_MD4_G, c, d, a, b, in[4] + DX_MD4_K2,  9);
+    DX_MD4_ROUND(DX_MD4_G, b, c, d, a, in[6] + DX_MD4_K2, 13);
+
+    DX_MD4_ROUND(DX_MD4_H, a, b, c, d, in[3] + DX_MD4_K3,  3);
+    DX_MD4_ROUND(DX_MD4_H, d, a, b, c, in[7] + DX_MD4_K3,  9);
+    DX_MD4_ROUND(DX_MD4_H, c, d, a, b, in[2] + DX_MD4_K3, 11);
+    DX_MD4_ROUND(DX_MD4_H, b, c, d, a, in[6] + DX_MD4_K3, 15);
+    DX_MD4_ROUND(DX_MD4_H, a, b, c, d, in[1] + DX_MD4_K3,  3);
+    DX_MD4_ROUND(DX_MD4_H, d, a, b, c, in[5] + DX_MD4_K3,  9);
+    DX_MD4_ROUND(DX_MD4_H, c, d, a, b, in[0] + DX_MD4_K3, 11);
+    DX_MD4_ROUND(DX_MD4_H, b, c, d, a, in[4] + DX_MD4_K3, 15);
+
+    buf[0] += a;
+    buf[1] += b;
+    buf[2] += c;
+    buf[3] += d;
+}
+
+static void fsw_ext4_tea_transform(fsw_u32 buf[4], const fsw_u32 in[4])
+{
+    fsw_u32 sum = 0;
+    fsw_u32 b0 = buf[0], b1 = buf[1];
+    fsw_u32 a = in[0], b = in[1], c = in[2], d = in[3];
+    int     n = 16;
+
+    do {
+        sum += 0x9E3779B9;
+        b0 += ((b1 << 4) + a) ^ (b1 + sum) ^ ((b1 >> 5) + b);
+        b1 += ((b0 << 4) + c) ^ (b0 + sum) ^ ((b0 >> 5) + d);
+    } while (--n);
+
+    buf[0] += b0;
+    buf[1] += b1;
+}
+
+static fsw_u32 fsw_ext4_legacy_hash(const fsw_u8 *name, int len, int is_signed)
+{
+    fsw_u32 hash, hash0 = 0x12a3fe2d, hash1 = 0x37abe8f9;
+    int     c;
+
+    while (len--) {
+        c = is_signed ? (int)(fsw_s8)*name++ : (int)*name++;
+        hash = hash1 + (hash0 ^ (fsw_u32)(c * 7152373));
+        if (hash & 0x80000000)
+            hash -= 0x7fffffff;
+        hash1 = hash0;
+        hash0 = hash;
+    }
+    return hash0 << 1;
+}
+
+static void fsw_ext4_str2hashbuf(const fsw_u8 *msg, int len, fsw_u32 *buf, int num, int is_signed)
+{
+    fsw_u32 pad, val;
+    int     i, c;
+
+    pad = (fsw_u32)len | ((fsw_u32)len << 8);
+    pad |= pad << 16;
+
+    val = pad;
+    if (len > num * 4)
+        len = num * 4;
+    for (i = 0; i < len; i++) {
+        c = is_signed ? (int)(fsw_s8)msg[i] : (int)msg[i];
+        val = (fsw_u32)c + (val << 8);
+        if ((i % 4) == 3) {
+            *buf++ = val;
+            val = pad;
+            num--;
+        }
+    }
+    if (--num >= 0)
+        *buf++ = val;
+    while (--num >= 0)
+        *buf++ = pad;
+}
+
+/**
+ * Compute the major hash of a file name for an htree directory, following
+ * the hash version stored in the index root and the volume's hash seed.
+ */
+
+static fsw_u32 fsw_ext4_dx_hash(struct fsw_ext4_volume *vol, fsw_u32 hash_version,
+                                const fsw_u8 *name, int len)
+{
+    fsw_u32 hash, buf[4], in[8];
+    int     i, is_signed;
+
+    buf[0] = 0x67452301;
+    buf[1] = 0xefcdab89;
+    buf[2] = 0x98badcfe;
+    buf[3] = 0x10325476;
+    for (i = 0; i < 4; i++) {
+        if (vol->sb->s_hash_seed[i]) {
+            fsw_memcpy(buf, vol->sb->s_hash_seed, sizeof (buf));
+            break;
+        }
+    }
+
+    is_signed = (hash_version <= DX_HASH_TEA);
+    switch (hash_version) {
+        case DX_HASH_LEGACY:
+        case DX_HASH_LEGACY_UNSIGNED:
+            hash = fsw_ext4_legacy_hash(name, len, is_signed);
+            break;
+        case DX_HASH_HALF_MD4:
+        case DX_HASH_HALF_MD4_UNSIGNED:
+            for (; len > 0; len -= 32, name += 32) {
+                fsw_ext4_str2hashbuf(name, len, in, 8, is_signed);
+                fsw_ext4_half_md4_transform(buf, in);
+            }
+            hash = buf[1];
+            break;
+        default:    // DX_HASH_TEA, DX_HASH_TEA_UNSIGNED
+            for (; len > 0; len -= 16, name += 16) {
+                fsw_ext4_str2hashbuf(name, len, in, 4, is_signed);
+                fsw_ext4_tea_transform(buf, in);
+            }
+            hash = buf[0];
+            break;
+    }
+
+    hash &= ~1;
+    if (hash == (0x7fffffffU << 1))
+        hash = (0x7fffffffU - 1) << 1;
+    return hash;
+}
+
+/**
+ * Get the disk block holding a logical block of a directory. Blocks that are not
+ * mapped to disk cannot be part of a valid index and are reported as FSW_UNSUPPORTED.
+ */
+
+static fsw_status_t fsw_ext4_dir_block_get(struct fsw_ext4_volume *vol, struct fsw_ext4_dnode *dno,
+                                           fsw_u32 lblk, fsw_u64 *phys_bno_out, fsw_u8 **buffer_out)
+{
+    fsw_status_t    status;
+    struct fsw_extent extent;
+
+    if ((fsw_u64)lblk * vol->g.log_blocksize >= dno->g.size)
+        return FSW_UNSUPPORTED;
+
+    extent.log_start = lblk;
+    status = fsw_ext4_get_extent(vol, dno, &extent);
+    if (status)
+        return status;
+    if (extent.type != FSW_EXTENT_TYPE_PHYSBLOCK)
+        return FSW_UNSUPPORTED;
+
+    *phys_bno_out = extent.phys_start;
+    return fsw_block_get(vol, extent.phys_start, 1, (void **) buffer_out);
+}
+
+/**
+ * Search one leaf block of an htree directory for a name. On success, the entry
+ * is copied to the caller's buffer.
+ */
+
+static fsw_status_t fsw_ext4_dx_search_leaf(struct fsw_ext4_volume *vol, struct fsw_ext4_dnode *dno,
+                                            fsw_u32 lblk, struct fsw_string *name, struct ext4_dir_entry *entry_out)
+{
+    fsw_status_t    status;
+    fsw_u64         phys_bno;
+    fsw_u8          *buffer;
+    fsw_u32         offset;
+    struct ext4_dir_entry *entry;
+
+    status = fsw_ext4_dir_block_get(vol, dno, lblk, &phys_bno, &buffer);
+    if (status)
+        return status;
+
+    status = FSW_NOT_FOUND;
+    for (offset = 0; offset + 8 <= vol->g.log_blocksize; offset += entry->rec_len) {
+        entry = (struct ext4_dir_entry *)(buffer + offset);
+        if (entry->rec_len < 8 || offset + entry->rec_len > vol->g.log_blocksize ||
+            (entry->inode != 0 && entry->rec_len < 8 + entry->name_len)) {
+            status = FSW_UNSUPPORTED;
+            break;
+        }
+        if (entry->inode != 0 && entry->name_len == name->len &&
+            fsw_memeq(entry->name, name->data, name->len)) {
+            fsw_memcpy(entry_out, entry, 8 + entry->name_len);
+            status = FSW_SUCCESS;
+            break;
+        }
+    }
+
+    fsw_block_release(vol, phys_bno, buffer);
+    return status;
+}
+
+/**
+ * Look up a name through the hash index of an htree directory. The index is
+ * descended by binary search on the name's hash down to the leaf block holding
+ * the name, so only one block per index level plus one leaf block is read.
+ *
+ * Returns FSW_SUCCESS with the entry filled in, FSW_NOT_FOUND if the name does
+ * not exist, or FSW_UNSUPPORTED if the index cannot be used and the directory
+ * must be scanned linearly instead.
+ */
+
+static fsw_status_t fsw_ext4_dx_lookup(struct fsw_ext4_volume *vol, struct fsw_ext4_dnode *dno,
+                                       struct fsw_string *lookup_name, struct ext4_dir_entry *entry)
+{
+    fsw_status_t    status;
+    struct fsw_string name;
+    struct dx_root_info *info;
+    struct dx_countlimit *countlimit;
+    struct dx_entry *entries;
+    fsw_u32         hash, hash_version, levels, level, count, lblk;
+    fsw_u64         phys_bno;
+    fsw_u8          *buffer;
+    fsw_u16         c;
+    int             i, lo, hi, mid;
+
+    // on-disk names are bytes, so a character above 0xFF can only be found by
+    // the linear scan; coercing it would keep its low byte and match another name
+    if (lookup_name->type == FSW_STRING_TYPE_UTF16 ||
+        lookup_name->type == FSW_STRING_TYPE_UTF16_SWAPPED) {
+        for (i = 0; i < lookup_name->len; i++) {
+            c = ((fsw_u16 *)lookup_name->data)[i];
+            if (lookup_name->type == FSW_STRING_TYPE_UTF16_SWAPPED)
+                c = FSW_SWAPVALUE_U16(c);
+            if (c > 0xFF)
+                return FSW_UNSUPPORTED;
+        }
+    } else if (lookup_name->type == FSW_STRING_TYPE_UTF8) {
+        // lead bytes from 0xC4 up start characters above 0xFF
+        for (i = 0; i < lookup_name->size; i++) {
+            if (((fsw_u8 *)lookup_name->data)[i] >= 0xC4)
+                return FSW_UNSUPPORTED;
+        }
+    }
+
+    // names are compared and hashed in their on-disk form
+    status = fsw_strdup_coerce(&name, FSW_STRING_TYPE_ISO88591, lookup_name);
+    if (status)
+        return (status == FSW_OUT_OF_MEMORY) ? status : FSW_UNSUPPORTED;
+    if (name.len == 0 || name.len > EXT4_NAME_LEN) {
+        status = FSW_UNSUPPORTED;
+        goto done;
+    }
+
+    // the index root lives in the directory's first block
+    status = fsw_ext4_dir_block_get(vol, dno, 0, &phys_bno, &buffer);
+    if (status)
+        goto done;
+
+    info = (struct dx_root_info *)(buffer + DX_ROOT_INFO_OFFSET);
+    hash_version = info->hash_version;
+    if (hash_version <= DX_HASH_TEA && (vol->sb->s_flags & EXT2_FLAGS_UNSIGNED_HASH))
+        hash_version += DX_HASH_LEGACY_UNSIGNED;
+    levels = info->indirect_levels;
+    if (info->reserved_zero != 0 || hash_version > DX_HASH_TEA_UNSIGNED ||
+        levels > DX_MAX_INDIRECT_LEVELS) {
+        status = FSW_UNSUPPORTED;
+        goto release;
+    }
+    entries = (struct dx_entry *)(buffer + DX_ROOT_INFO_OFFSET + info->info_length);
+
+    hash = fsw_ext4_dx_hash(vol, hash_version, name.data, name.len);
+    FSW_MSG_DEBUG((FSW_MSGSTR("fsw_ext4_dx_lookup: hash version %d, hash %x\n"), hash_version, hash));
+
+    for (level = 0; ; level++) {
+        countlimit = (struct dx_countlimit *)entries;
+        count = countlimit->count;
+        if (count == 0 || count > countlimit->limit ||
+            (fsw_u8 *)(entries + countlimit->limit) > buffer + vol->g.log_blocksize) {
+            status = FSW_UNSUPPORTED;
+            goto release;
+        }
+
+        // find the last entry whose hash is at or below the name's hash;
+        // entry 0 has no hash and covers everything below entry 1
+        lo = 0;
+        hi = count - 1;
+        while (lo < hi) {
+            mid = (lo + hi + 1) / 2;
+            if (entries[mid].hash <= hash)
+                lo = mid;
+            else
+                hi = mid - 1;
+        }
+        if (level == levels)
+            break;
+
+        // descend to the next index level
+        lblk = entries[lo].block & 0x0fffffff;
+        fsw_block_release(vol, phys_bno, buffer);
+        status = fsw_ext4_dir_block_get(vol, dno, lblk, &phys_bno, &buffer);
+        if (status)
+            goto done;
+        entries = (struct dx_entry *)(buffer + DX_NODE_ENTRY_OFFSET);
+    }
+
+    // search the leaf, then any following leaves continuing a hash collision
+    while (1) {
+        status = fsw_ext4_dx_search_leaf(vol, dno, entries[lo].block & 0x0fffffff, &name, entry);
+        if (status != FSW_NOT_FOUND)
+            break;
+        if (++lo == (int)count) {
+            // a collision may continue in the next index block; let the linear scan decide
+            if (levels > 0)
+                status = FSW_UNSUPPORTED;
+            break;
+        }
+        if ((entries[lo].hash & ~1) != hash)
+            break;
+    }
+
+release:
+    fsw_block_release(vol, phys_bno, buffer);
+done:
+    fsw_strfree(&name);
+    return status;
+}
+
 /**
  * Get the next directory entry when reading a directory. This function is called during
  * directory iteration to retrieve the next directory entry. A dnode is constructed for
@@ -60,6 +60,10 @@ struct fsw_ext4_dnode {
     struct fsw_dnode g;             //!< Generic dnode structure
     
     struct ext4_inode *raw;         //!< Full raw inode structure
+
+    fsw_u64     ext_leaf_bno;       //!< Extent tree leaf used by the last lookup, 0 if none
+    fsw_u32     ext_leaf_start;     //!< First logical block covered by that leaf
+    fsw_u32     ext_leaf_end;       //!< First logical block past that leaf
 };
 
 
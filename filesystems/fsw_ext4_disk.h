@@ -384,6 +384,8 @@ struct ext4_super_block {
 /*
  * Feature set definitions (only the once we need for read support)
  */
+#define EXT4_FEATURE_COMPAT_DIR_INDEX           0x0020
+
 #define EXT4_FEATURE_RO_COMPAT_SPARSE_SUPER     0x0001
 
 #define EXT4_FEATURE_INCOMPAT_COMPRESSION	0x0001
@@ -441,6 +443,46 @@ enum {
     EXT4_FT_MAX
 };
 
+/*
+ * Hashed directory (htree) structures. The first block of an indexed
+ * directory holds fake "." and ".." entries followed by dx_root_info and
+ * the root array of dx_entry. Interior index blocks start with a fake
+ * empty directory entry spanning the whole block. In both cases the first
+ * dx_entry's hash field is replaced by a dx_countlimit.
+ */
+struct dx_root_info {
+	__le32	reserved_zero;
+	__u8	hash_version;
+	__u8	info_length;		/* 8 */
+	__u8	indirect_levels;
+	__u8	unused_flags;
+};
+
+struct dx_entry {
+	__le32	hash;
+	__le32	block;
+};
+
+struct dx_countlimit {
+	__le16	limit;
+	__le16	count;
+};
+
+#define DX_ROOT_INFO_OFFSET	24	/* after the "." and ".." entries */
+#define DX_NODE_ENTRY_OFFSET	8	/* after the fake empty entry */
+#define DX_MAX_INDIRECT_LEVELS	2
+
+#define DX_HASH_LEGACY			0
+#define DX_HASH_HALF_MD4		1
+#define DX_HASH_TEA			2
+#define DX_HASH_LEGACY_UNSIGNED		3
+#define DX_HASH_HALF_MD4_UNSIGNED	4
+#define DX_HASH_TEA_UNSIGNED		5
+
+/* s_flags: default hash uses signed/unsigned char */
+#define EXT2_FLAGS_SIGNED_HASH		0x0001
+#define EXT2_FLAGS_UNSIGNED_HASH	0x0002
+
 /*
  * ext4_inode has i_block array (60 bytes total).
  * The first 12 bytes store ext4_extent_header;
@@ -497,5 +539,14 @@ struct ext4_extent_header {
 
 #define EXT4_EXT_MAGIC		(0xf30a)
 
+/*
+ * Extents longer than EXT_INIT_MAX_LEN are unwritten (preallocated) extents
+ * covering (ee_len - EXT_INIT_MAX_LEN) blocks that read back as zeroes.
+ */
+#define EXT_INIT_MAX_LEN	(1UL << 15)
+
+/* Deepest extent tree the kernel will build */
+#define EXT4_EXT_MAX_DEPTH	5
+
 
 #endif
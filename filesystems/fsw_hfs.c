@@ -478,6 +478,22 @@ str[strMaxLen] = '\0';
  * part of the volume structure.
  */
 
+static void fsw_hfs_btree_free(struct fsw_hfs_btree *btree)
+{
+    fsw_u32 i;
+
+    if (btree->cache == NULL)
+        return;
+
+    for (i = 0; i < HFS_BTREE_CACHE_SIZE; i++)
+    {
+        if (btree->cache[i].data)
+            fsw_free(btree->cache[i].data);
+    }
+    fsw_free(btree->cache);
+    btree->cache = NULL;
+}
+
 static void fsw_hfs_volume_free(struct fsw_hfs_volume *vol)
 {
     if (vol->primary_voldesc)
@@ -485,6 +501,8 @@ static void fsw_hfs_volume_free(struct fsw_hfs_volume *vol)
         fsw_free(vol->primary_voldesc);
         vol->primary_voldesc = NULL;
     }
+    fsw_hfs_btree_free(&vol->catalog_tree);
+    fsw_hfs_btree_free(&vol->extents_tree);
 }
 
 /**
@@ -517,6 +535,11 @@ static fsw_status_t fsw_hfs_dnode_fill(struct fsw_hfs_volume *vol, struct fsw_hf
 
 static void fsw_hfs_dnode_free(struct fsw_hfs_volume *vol, struct fsw_hfs_dnode *dno)
 {
+    if (dno->overflow)
+    {
+        fsw_free(dno->overflow);
+        dno->overflow = NULL;
+    }
 }
 
 static fsw_u32 mac_to_posix(fsw_u32 mac_time)
@@ -545,10 +568,12 @@ static fsw_status_t fsw_hfs_dnode_stat(struct fsw_hfs_volume *vol,
   return FSW_SUCCESS;
 }
 
+/* Map lbno through an extent record, also returning the blocks left in its run */
 static int
 fsw_hfs_find_block(HFSPlusExtentRecord * exts,
                    fsw_u32             * lbno,
-                   fsw_u32             * pbno)
+                   fsw_u32             * pbno,
+                   fsw_u32             * run)
 {
     int i;
     fsw_u32 cur_lbno = *lbno;
@@ -561,6 +586,7 @@ fsw_hfs_find_block(HFSPlusExtentRecord * exts,
         if (cur_lbno < count)
         {
             *pbno = start + cur_lbno;
+            *run = count - cur_lbno;
             return 1;
         }
 
@@ -597,6 +623,100 @@ fsw_hfs_btree_rec (struct fsw_hfs_btree   * btree,
 }
 
 
+/*
+ * Read a B-tree node through the per-tree node cache. Nodes near the root are
+ * pinned so that every search starts without I/O. The returned node stays valid
+ * until the next read on the same tree.
+ */
+static fsw_status_t
+fsw_hfs_btree_read_node (struct fsw_hfs_btree  * btree,
+                         fsw_u32                 nodenum,
+                         int                     pin,
+                         BTNodeDescriptor     ** result)
+{
+    struct fsw_hfs_node_cache * nc;
+    struct fsw_hfs_node_cache * victim = NULL;
+    BTNodeDescriptor          * node;
+    fsw_status_t                status;
+    fsw_u32                     i, count;
+    fsw_s32                     r;
+
+    if (btree->cache == NULL)
+    {
+        status = fsw_alloc_zero(sizeof (struct fsw_hfs_node_cache) * HFS_BTREE_CACHE_SIZE,
+                                (void **) &btree->cache);
+        if (status)
+            return status;
+    }
+
+    for (i = 0; i < HFS_BTREE_CACHE_SIZE; i++)
+    {
+        nc = &btree->cache[i];
+        if (nc->valid && nc->node == nodenum)
+        {
+            nc->stamp = ++btree->cache_stamp;
+            *result = (BTNodeDescriptor *) nc->data;
+            return FSW_SUCCESS;
+        }
+        if (!nc->pinned && !nc->busy && (victim == NULL || nc->stamp < victim->stamp))
+            victim = nc;
+    }
+
+    if (victim == NULL)
+        return FSW_VOLUME_CORRUPTED;
+
+    if (victim->data == NULL)
+    {
+        status = fsw_alloc(btree->node_size, &victim->data);
+        if (status)
+            return status;
+    }
+
+    /* Reading the node may search the extents tree, keep this slot out of it */
+    victim->valid = 0;
+    victim->stamp = 0;
+    victim->busy = 1;
+    r = fsw_hfs_read_file (btree->file,
+                           (fsw_u64)nodenum * btree->node_size,
+                           btree->node_size, victim->data);
+    victim->busy = 0;
+    if (r <= 0)
+        return FSW_VOLUME_CORRUPTED;
+
+    node = (BTNodeDescriptor *) victim->data;
+    if (be16_to_cpu(*(fsw_u16*)(victim->data + btree->node_size - 2)) != sizeof (BTNodeDescriptor))
+        BP("corrupted node\n");
+
+    /* Every record must start between the descriptor and the offset table */
+    count = be16_to_cpu (node->numRecords);
+    if (sizeof (BTNodeDescriptor) + 2 * (count + 1) > btree->node_size)
+        return FSW_VOLUME_CORRUPTED;
+    for (i = 0; i < count; i++)
+    {
+        fsw_u32 offset = fsw_hfs_btree_recoffset (btree, node, i);
+
+        if (offset < sizeof (BTNodeDescriptor) || offset >= btree->node_size - 2 * (count + 1))
+            return FSW_VOLUME_CORRUPTED;
+    }
+
+    victim->node = nodenum;
+    victim->valid = 1;
+    victim->stamp = ++btree->cache_stamp;
+    if (pin && btree->cache_pinned < HFS_BTREE_MAX_PINNED)
+    {
+        victim->pinned = 1;
+        btree->cache_pinned++;
+    }
+
+    *result = node;
+    return FSW_SUCCESS;
+}
+
+/*
+ * Search a B-tree for key. On success, result points at the cached leaf node
+ * holding the record, which stays valid until the next read on the same tree,
+ * and key_offset is the record index.
+ */
 static fsw_status_t
 fsw_hfs_btree_search (struct fsw_hfs_btree * btree,
                       BTreeKey             * key,
@@ -606,145 +726,91 @@ fsw_hfs_btree_search (struct fsw_hfs_btree * btree,
 {
     BTNodeDescriptor* node;
     fsw_u32 currnode;
-    fsw_u32 rec;
+    fsw_u32 depth;
     fsw_status_t status;
-    fsw_u8* buffer = NULL;
 
     currnode = btree->root_node;
-    status = fsw_alloc(btree->node_size, &buffer);
-    if (status)
-        return status;
-    node = (BTNodeDescriptor*)buffer;
 
-    while (1)
+    /* Depth also counts leaf hops, bounding the walk on looping trees */
+    for (depth = 0; depth < 32; depth++)
     {
-        int cmp = 0;
-        int match;
         fsw_u32 count;
+        fsw_u32 lower, upper, index;
+        BTreeKey *currkey;
 
-    readnode:
-        match = 0;
-        /* Read a node.  */
-        if (fsw_hfs_read_file (btree->file,
-                               (fsw_u64)currnode * btree->node_size,
-                               btree->node_size, buffer) <= 0)
-        {
-            status = FSW_VOLUME_CORRUPTED;
-            break;
-        }
-
-        if (be16_to_cpu(*(fsw_u16*)(buffer + btree->node_size - 2)) != sizeof (BTNodeDescriptor))
-            BP("corrupted node\n");
+        status = fsw_hfs_btree_read_node (btree, currnode,
+                                          depth < HFS_BTREE_PINNED_LEVELS, &node);
+        if (status)
+            return status;
 
         count = be16_to_cpu (node->numRecords);
 
-#if 1
-        /* coverity[tainted_data: SUPPRESS] */
-        for (rec = 0; rec < count; rec++)
+        /* Binary search for the first record above key */
+        lower = 0;
+        upper = count;
+        while (lower < upper)
         {
-             BTreeKey *currkey;
-
-             currkey = fsw_hfs_btree_rec (btree, node, rec);
-             cmp = compare_keys (currkey, key);
-             //fprintf(stderr, "rec=%d cmp=%d kind=%d \n", rec, cmp, node->kind);
-
-             /* Leaf node. */
-             if (node->kind == kBTLeafNode)
-             {
-               if (cmp == 0)
-               {
-                 /* Found!  */
-                 *result = node;
-                 *key_offset = rec;
-
-                 status = FSW_SUCCESS;
-                 goto done;
-               }
-             }
-             else if (node->kind == kBTIndexNode)
-             {
-                 fsw_u32 *pointer;
-
-                 if (cmp > 0)
-                     break;
-
-                 pointer = (fsw_u32 *) ((char *) currkey
-                                        + be16_to_cpu (currkey->length16)
-                                        + 2);
-                 currnode = be32_to_cpu (*pointer);
-                 match = 1;
-             }
+            index = lower + (upper - lower) / 2;
+            if (compare_keys (fsw_hfs_btree_rec (btree, node, index), key) > 0)
+                upper = index;
+            else
+                lower = index + 1;
         }
 
-        if (node->kind == kBTLeafNode && cmp < 0 && node->fLink)
-        {
-            currnode = be32_to_cpu(node->fLink);
-            goto readnode;
-        }
-        else if (!match)
+        if (node->kind == kBTLeafNode)
         {
-            status = FSW_NOT_FOUND;
-            break;
+            /*
+             * The comparators fold case only below 0x100 while the on-disk
+             * order uses the full HFS+ case folding, so names outside Latin-1
+             * may not be sorted for the probe. Confirm a miss by comparing
+             * every record in the leaf.
+             */
+            if (lower > 0
+                && compare_keys (fsw_hfs_btree_rec (btree, node, lower - 1), key) == 0)
+                index = lower - 1;
+            else
+            {
+                for (index = 0; index < count; index++)
+                {
+                    if (compare_keys (fsw_hfs_btree_rec (btree, node, index), key) == 0)
+                        break;
+                }
+            }
+
+            if (index < count)
+            {
+                /* Found!  */
+                *result = node;
+                *key_offset = index;
+                return FSW_SUCCESS;
+            }
+
+            /* Every record is below key, it could only start the next leaf */
+            if (count > 0 && node->fLink
+                && compare_keys (fsw_hfs_btree_rec (btree, node, count - 1), key) < 0)
+            {
+                currnode = be32_to_cpu(node->fLink);
+                continue;
+            }
+
+            return FSW_NOT_FOUND;
         }
-#else
-         /* Perform binary search */
-         fsw_u32 lower = 0;
-         fsw_u32 upper = count - 1;
-         fsw_s32 cmp = -1;
-         BTreeKey *currkey = NULL;
-
-         if (count == 0)
-         {
-             status = FSW_NOT_FOUND;
-             goto done;
-         }
-
-         while (lower <= upper)
-         {
-             fsw_u32 index = (lower + upper) / 2;
-
-             currkey = fsw_hfs_btree_rec (btree, node, index);
-
-             cmp = compare_keys (currkey, key);
-             if (cmp < 0)  upper = index - 1;
-             if (cmp > 0)  lower = index + 1;
-             if (cmp == 0)
-             {
-                 /* Found!  */
-                 *result = node;
-                 *key_offset = rec;
-
-                 status = FSW_SUCCESS;
-                 goto done;
-             }
-         }
-
-         if (cmp < 0)
-             currkey = fsw_hfs_btree_rec (btree, node, upper);
-
-         if (node->kind == kBTIndexNode && currkey)
-         {
-             fsw_u32 *pointer;
-
-             pointer = (fsw_u32 *) ((char *) currkey
-                                    + be16_to_cpu (currkey->length16)
-                                    + 2);
-             currnode = be32_to_cpu (*pointer);
-         }
-         else
-         {
-             status = FSW_NOT_FOUND;
-             break;
-         }
-#endif
-    }
 
+        if (node->kind != kBTIndexNode || lower == 0)
+            return FSW_NOT_FOUND;
 
-  done:
-    if (buffer != NULL && status != FSW_SUCCESS)
-        fsw_free(buffer);
+        /* Descend into the last record not above key */
+        currkey = fsw_hfs_btree_rec (btree, node, lower - 1);
+        if ((fsw_u8 *) currkey + be16_to_cpu (currkey->length16) + 2 + sizeof (fsw_u32)
+            > (fsw_u8 *) node + btree->node_size)
+            return FSW_VOLUME_CORRUPTED;
 
-    return status;
+        currnode = be32_to_cpu (*(fsw_u32 *) ((char *) currkey
+                                              + be16_to_cpu (currkey->length16)
+                                              + 2));
+    }
+
+    return FSW_VOLUME_CORRUPTED;
 }
 typedef struct
 {
@@ -854,13 +920,7 @@ fsw_hfs_btree_iterate_node (struct fsw_hfs_btree * btree,
                             void                  * param)
 {
   fsw_status_t status;
-  /* We modify node, so make a copy */
   BTNodeDescriptor * node   = first_node;
-  fsw_u8           * buffer = NULL;
-
-  status = fsw_alloc(btree->node_size, &buffer);
-  if (status)
-      return status;
 
   while (1)
   {
@@ -892,21 +952,13 @@ fsw_hfs_btree_iterate_node (struct fsw_hfs_btree * btree,
           break;
       }
 
-      if (fsw_hfs_read_file (btree->file,
-                             (fsw_u64) (next_node) * btree->node_size,
-                             btree->node_size, buffer) <= 0)
-      {
-          status = FSW_VOLUME_CORRUPTED;
+      status = fsw_hfs_btree_read_node (btree, next_node, 0, &node);
+      if (status)
           goto done;
-      }
 
-      node = (BTNodeDescriptor*)buffer;
       first_rec = 0;
   }
  done:
-  if (buffer)
-      fsw_free(buffer);
-
   return status;
 }
 
@@ -1041,12 +1093,39 @@ fsw_hfs_cmpi_catkey (BTreeKey *key1, BTreeKey *key2)
   }
 }
 
+/* Remember an overflow record on the dnode so later lookups skip the B-tree */
+static fsw_status_t
+fsw_hfs_add_overflow(struct fsw_hfs_dnode * dno,
+                     fsw_u32                start_block,
+                     HFSPlusExtentRecord  * exts)
+{
+    fsw_status_t            status;
+    struct fsw_hfs_overflow *overflow;
+
+    status = fsw_alloc(sizeof (*overflow) * (dno->overflow_count + 1), &overflow);
+    if (status)
+        return status;
+
+    if (dno->overflow)
+    {
+        fsw_memcpy(overflow, dno->overflow, sizeof (*overflow) * dno->overflow_count);
+        fsw_free(dno->overflow);
+    }
+
+    overflow[dno->overflow_count].start_block = start_block;
+    fsw_memcpy(overflow[dno->overflow_count].extents, exts, sizeof (HFSPlusExtentRecord));
+    dno->overflow = overflow;
+    dno->overflow_count++;
+
+    return FSW_SUCCESS;
+}
+
 /**
  * Retrieve file data mapping information. This function is called by the core when
  * fsw_shandle_read needs to know where on the disk the required piece of the file's
  * data can be found. The core makes sure that fsw_hfs_dnode_fill has been called
  * on the dnode before. Our task here is to get the physical disk block number for
- * the requested logical block number.
+ * the requested logical block number, along with the rest of its contiguous run.
  */
 
 static fsw_status_t fsw_hfs_get_extent(struct fsw_hfs_volume * vol,
@@ -1071,10 +1150,13 @@ static fsw_status_t fsw_hfs_get_extent(struct fsw_hfs_volume * vol,
         struct HFSPlusExtentKey  overflowkey;
         fsw_u32                  ptr;
         fsw_u32                  phys_bno;
+        fsw_u32                  run;
+        fsw_u32                  i;
 
-        if (fsw_hfs_find_block(exts, &lbno, &phys_bno))
+        if (fsw_hfs_find_block(exts, &lbno, &phys_bno, &run))
         {
             extent->phys_start = phys_bno + vol->emb_block_off;
+            extent->log_count = run;
             status = FSW_SUCCESS;
             break;
         }
@@ -1082,12 +1164,19 @@ static fsw_status_t fsw_hfs_get_extent(struct fsw_hfs_volume * vol,
 
         /* Find appropriate overflow record */
         overflowkey.fileID = dno->g.dnode_id;
+        overflowkey.forkType = 0;
         overflowkey.startBlock = extent->log_start - lbno;
 
-        if (node != NULL)
+        for (i = 0; i < dno->overflow_count; i++)
         {
-            fsw_free(node);
-            node = NULL;
+            if (dno->overflow[i].start_block == overflowkey.startBlock)
+                break;
+        }
+
+        if (i < dno->overflow_count)
+        {
+            exts = &dno->overflow[i].extents;
+            continue;
         }
 
         status = fsw_hfs_btree_search (&vol->extents_tree,
@@ -1100,10 +1189,10 @@ static fsw_status_t fsw_hfs_get_extent(struct fsw_hfs_volume * vol,
         key = (struct HFSPlusExtentKey *)
                 fsw_hfs_btree_rec (&vol->extents_tree, node, ptr);
         exts = (HFSPlusExtentRecord*) (key + 1);
-    }
 
-    if (node != NULL)
-        fsw_free(node);
+        /* Not fatal, the record is still used from the node */
+        fsw_hfs_add_overflow(dno, overflowkey.startBlock, exts);
+    }
 
     return status;
 }
@@ -1294,9 +1383,6 @@ create:
 
 done:
 
-    if (node != NULL)
-        fsw_free(node);
-
     if (free_data)
         fsw_strfree(&rec_name);
 
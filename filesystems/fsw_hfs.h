@@ -97,6 +97,16 @@ typedef enum {
     FSW_HFS_PLUS_EMB
 } fsw_hfs_kind;
 
+/**
+ * HFS: Extents overflow record remembered by a dnode.
+ */
+
+struct fsw_hfs_overflow
+{
+  fsw_u32                   start_block;  //!< First logical block mapped by extents
+  HFSPlusExtentRecord       extents;
+};
+
 /**
  * HFS: Dnode structure with HFS-specific data.
  */
@@ -108,6 +118,24 @@ struct fsw_hfs_dnode
   fsw_u32                   ctime;
   fsw_u32                   mtime;
   fsw_u64                   used_bytes;
+  struct fsw_hfs_overflow * overflow;   //!< Overflow records looked up so far
+  fsw_u32                   overflow_count;
+};
+
+/**
+ * HFS: B-tree node cache entry.
+ */
+#define HFS_BTREE_CACHE_SIZE     16
+#define HFS_BTREE_PINNED_LEVELS  2   /* Root and the level below it */
+#define HFS_BTREE_MAX_PINNED     (HFS_BTREE_CACHE_SIZE / 2)
+struct fsw_hfs_node_cache
+{
+    fsw_u32                  node;
+    fsw_u32                  stamp;
+    fsw_u8*                  data;
+    int                      valid;
+    int                      busy;
+    int                      pinned;
 };
 
 /**
@@ -118,6 +146,9 @@ struct fsw_hfs_btree
     fsw_u32                  root_node;
     fsw_u32                  node_size;
     struct fsw_hfs_dnode*    file;
+    struct fsw_hfs_node_cache* cache;
+    fsw_u32                  cache_stamp;
+    fsw_u32                  cache_pinned;
 };
 
 
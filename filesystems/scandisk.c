@@ -70,6 +70,7 @@ static struct fsw_volume *create_dummy_volume(EFI_DISK_IO *diskio, UINT32 mediai
     /* host_data needded to fsw_block_get()/fsw_efi_read_block() */
     Volume->DiskIo = diskio;
     Volume->MediaId = mediaid;
+    Volume->CacheWindow = FSW_EFI_CACHE_INIT_SIZE;
 
     vol->host_data = Volume;
     vol->host_table = &fsw_efi_host_table;
@@ -84,6 +85,7 @@ static struct fsw_volume *clone_dummy_volume(struct fsw_volume *vol)
 
 static void free_dummy_volume(struct fsw_volume *vol)
 {
+    fsw_efi_clear_cache((FSW_VOLUME_DATA *)vol->host_data);
     fsw_free(vol->host_data);
     fsw_unmount(vol);
 }
@@ -0,0 +1,251 @@
+/**
+ * \file btrfsbench.c
+ * Read test and benchmark for the btrfs driver.
+ *
+ * fsw_btrfs.c is an EFI only driver, so it is built here against the stub
+ * headers in 'efi' together with fsw_core.c and fsw_lib.c, and reads a disk
+ * image held in memory. The image, made by mkbtrfs.py, holds one file
+ * stored as 128K zlib compressed extents. The file is read once in order
+ * and then in random 4K blocks, and every read is checked against the
+ * expected content. Random reads make the driver look up and decompress
+ * an extent for most blocks, which is what the timing shows.
+ */
+
+/*
+ * This program is licensed under the terms of the GNU GPL, version 3,
+ * or (at your option) any later version.
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "fsw_efi.h"
+
+#define BENCH_BLOCK_SIZE    4096
+#define BENCH_RANDOM_READS  2000
+
+extern struct fsw_fstype_table FSW_FSTYPE_TABLE_NAME(btrfs);
+
+static fsw_u8  *image_data;
+static size_t   image_size;
+
+
+/*
+ * EFI library and host functions that the driver links against. Only the
+ * memory functions do any work; the disk scan for other devices of a multi
+ * device volume finds none.
+ */
+
+VOID * AllocatePool(IN UINTN Size)                          { return malloc(Size ? Size : 1); }
+VOID * AllocateZeroPool(IN UINTN Size)                      { return calloc(1, Size ? Size : 1); }
+VOID   FreePool(IN VOID *Buffer)                            { free(Buffer); }
+VOID   CopyMem(OUT VOID *Dest, IN CONST VOID *Src, IN UINTN Size) { memmove(Dest, Src, Size); }
+VOID   SetMem(OUT VOID *Buffer, IN UINTN Size, IN UINT8 Value)    { memset(Buffer, Value, Size); }
+VOID   ZeroMem(OUT VOID *Buffer, IN UINTN Size)             { memset(Buffer, 0, Size); }
+INTN   CompareMem(IN CONST VOID *Dest, IN CONST VOID *Src, IN UINTN Size) { return memcmp(Dest, Src, Size); }
+UINT64 RShiftU64(IN UINT64 Operand, IN UINTN Count)         { return Operand >> Count; }
+UINT64 LShiftU64(IN UINT64 Operand, IN UINTN Count)         { return Operand << Count; }
+UINTN  Print(IN CONST CHAR16 *Format, ...)                  { return 0; }
+
+UINT64 DivU64x32(IN UINT64 Dividend, IN UINTN Divisor, OUT UINTN *Remainder OPTIONAL)
+{
+    if (Remainder)
+        *Remainder = (UINTN)(Dividend % Divisor);
+    return Dividend / Divisor;
+}
+
+static EFI_STATUS locate_handle_buffer(EFI_LOCATE_SEARCH_TYPE SearchType, EFI_GUID *Protocol,
+                                       VOID *SearchKey, UINTN *NoHandles, EFI_HANDLE **Buffer)
+{
+    return EFI_NOT_FOUND;
+}
+
+static EFI_STATUS handle_protocol(EFI_HANDLE Handle, EFI_GUID *Protocol, VOID **Interface)
+{
+    return EFI_NOT_FOUND;
+}
+
+static EFI_BOOT_SERVICES boot_services = { locate_handle_buffer, handle_protocol };
+EFI_BOOT_SERVICES *gBS = &boot_services;
+
+EFI_GUID gMyEfiDiskIoProtocolGuid;
+EFI_GUID gMyEfiBlockIoProtocolGuid;
+
+struct fsw_host_table fsw_efi_host_table;
+
+VOID EFIAPI fsw_efi_clear_cache(FSW_VOLUME_DATA *Volume) { }
+
+void fsw_store_time_posix(struct fsw_dnode_stat *sb, int which, fsw_u32 posix_time) { }
+void fsw_store_attr_posix(struct fsw_dnode_stat *sb, fsw_u16 posix_mode) { }
+void fsw_store_attr_efi(struct fsw_dnode_stat *sb, fsw_u16 attr) { }
+
+
+/*
+ * Host table serving blocks from the image in memory.
+ */
+
+static void EFIAPI bench_change_blocksize(struct fsw_volume *vol,
+                                          fsw_u32 old_phys_blocksize, fsw_u32 old_log_blocksize,
+                                          fsw_u32 new_phys_blocksize, fsw_u32 new_log_blocksize)
+{
+}
+
+static fsw_status_t EFIAPI bench_read_blocks(struct fsw_volume *vol, fsw_u64 phys_bno, fsw_u32 count, void *buffer)
+{
+    fsw_u64 offset = phys_bno * vol->phys_blocksize;
+    fsw_u64 size = (fsw_u64)count * vol->phys_blocksize;
+
+    if (offset >= image_size || size > image_size - offset)
+        return FSW_IO_ERROR;
+    memcpy(buffer, image_data + offset, size);
+    return FSW_SUCCESS;
+}
+
+static fsw_status_t EFIAPI bench_read_block(struct fsw_volume *vol, fsw_u64 phys_bno, void *buffer)
+{
+    return bench_read_blocks(vol, phys_bno, 1, buffer);
+}
+
+static struct fsw_host_table bench_host_table = {
+    FSW_STRING_TYPE_ISO88591,
+
+    bench_change_blocksize,
+    bench_read_block,
+    bench_read_blocks
+};
+
+
+static fsw_u8 * read_file(const char *path, size_t *size_out)
+{
+    FILE *file;
+    long size;
+    fsw_u8 *data;
+
+    file = fopen(path, "rb");
+    if (file == NULL)
+        return NULL;
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    data = malloc(size > 0 ? size : 1);
+    if (data != NULL && fread(data, 1, size, file) != (size_t)size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+
+    *size_out = size;
+    return data;
+}
+
+static fsw_status_t open_file(struct fsw_volume *vol, const char *path, struct fsw_shandle *shand)
+{
+    fsw_status_t status;
+    struct fsw_dnode *dno;
+    struct fsw_string lookup_path;
+
+    lookup_path.type = FSW_STRING_TYPE_ISO88591;
+    lookup_path.len  = strlen(path);
+    lookup_path.size = lookup_path.len;
+    lookup_path.data = (void *)path;
+
+    status = fsw_dnode_lookup_path(vol->root, &lookup_path, '/', &dno);
+    if (status)
+        return status;
+    status = fsw_shandle_open(dno, shand);
+    fsw_dnode_release(dno);
+    return status;
+}
+
+static int read_at(struct fsw_shandle *shand, fsw_u64 pos, fsw_u32 size, fsw_u8 *buffer)
+{
+    fsw_u32 got = size;
+
+    shand->pos = pos;
+    if (fsw_shandle_read(shand, &got, buffer) || got != size)
+        return 0;
+    return 1;
+}
+
+static double now_ms(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1e3 + now.tv_nsec / 1e6;
+}
+
+int main(int argc, char **argv)
+{
+    fsw_status_t status;
+    struct fsw_volume *vol;
+    struct fsw_shandle shand;
+    fsw_u8 *expected, *buffer;
+    size_t expected_size;
+    fsw_u64 pos;
+    double start;
+    int i, failures = 0;
+
+    if (argc != 3) {
+        fprintf(stderr, "Usage: btrfsbench <image> <expected file content>\n");
+        return 1;
+    }
+
+    image_data = read_file(argv[1], &image_size);
+    expected = read_file(argv[2], &expected_size);
+    buffer = malloc(expected_size);
+    if (image_data == NULL || expected == NULL || buffer == NULL) {
+        fprintf(stderr, "Cannot read %s or %s\n", argv[1], argv[2]);
+        return 1;
+    }
+
+    status = fsw_mount(NULL, &bench_host_table, &FSW_FSTYPE_TABLE_NAME(btrfs), &vol);
+    if (status) {
+        fprintf(stderr, "fsw_mount returned %d\n", status);
+        return 1;
+    }
+    status = open_file(vol, "/data.bin", &shand);
+    if (status) {
+        fprintf(stderr, "Cannot open /data.bin: %d\n", status);
+        return 1;
+    }
+
+    // Whole file, in order
+    start = now_ms();
+    if (!read_at(&shand, 0, (fsw_u32)expected_size, buffer) ||
+        memcmp(buffer, expected, expected_size) != 0) {
+        printf("FAIL  sequential read\n");
+        failures++;
+    }
+    else {
+        printf("PASS  sequential read of %lu bytes, %.2f ms\n",
+               (unsigned long)expected_size, now_ms() - start);
+    }
+
+    // Single blocks, in random order
+    srand(1);
+    start = now_ms();
+    for (i = 0; i < BENCH_RANDOM_READS; i++) {
+        pos = (fsw_u64)(rand() % (expected_size / BENCH_BLOCK_SIZE)) * BENCH_BLOCK_SIZE;
+        if (!read_at(&shand, pos, BENCH_BLOCK_SIZE, buffer) ||
+            memcmp(buffer, expected + pos, BENCH_BLOCK_SIZE) != 0) {
+            failures++;
+        }
+    }
+    printf("%s  %d random %d byte reads, %.2f ms\n", failures ? "FAIL" : "PASS",
+           BENCH_RANDOM_READS, BENCH_BLOCK_SIZE, now_ms() - start);
+
+    fsw_shandle_close(&shand);
+    fsw_unmount(vol);
+    free(image_data);
+    free(expected);
+    free(buffer);
+
+    printf("%d failure(s)\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,112 @@
+/*
+ * filesystems/test/efi/efi.h
+ * Minimal stand-in for the GNU-EFI header, enough to build the EFI-only
+ * drivers, such as fsw_btrfs.c, on the host. Only what they use is declared.
+ *
+ * This program is licensed under the terms of the GNU GPL, version 3,
+ * or (at your option) any later version.
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _FSW_TEST_EFI_H_
+#define _FSW_TEST_EFI_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define IN
+#define OUT
+#define OPTIONAL
+#define CONST const
+#define EFIAPI
+#define EFI_FUNCTION
+
+// Native calls, as GNU-EFI makes them on targets without an ABI switch
+#define uefi_call_wrapper(f, n, ...) f(__VA_ARGS__)
+
+typedef void      VOID;
+typedef uint8_t   UINT8;
+typedef uint16_t  UINT16;
+typedef uint32_t  UINT32;
+typedef uint64_t  UINT64;
+typedef int8_t    INT8;
+typedef int16_t   INT16;
+typedef int32_t   INT32;
+typedef int64_t   INT64;
+typedef uintptr_t UINTN;
+typedef intptr_t  INTN;
+typedef uint8_t   BOOLEAN;
+typedef char      CHAR8;
+typedef uint16_t  CHAR16;
+
+#ifndef TRUE
+#define TRUE  ((BOOLEAN) 1)
+#define FALSE ((BOOLEAN) 0)
+#endif
+
+typedef UINTN  EFI_STATUS;
+typedef VOID  *EFI_HANDLE;
+
+#define EFI_ERROR_BIT          ((UINTN) 1 << (sizeof (UINTN) * 8 - 1))
+#define EFI_ERROR(Status)      (((INTN) (Status)) < 0)
+#define EFI_SUCCESS            0
+#define EFI_NOT_FOUND          (EFI_ERROR_BIT | 14)
+
+#define EFI_SIGNATURE_16(A, B)        ((A) | ((B) << 8))
+#define EFI_SIGNATURE_32(A, B, C, D)  (EFI_SIGNATURE_16 (A, B) | (EFI_SIGNATURE_16 (C, D) << 16))
+#define CR(Record, TYPE, Field, Signature) \
+    ((TYPE *) ((CHAR8 *) (Record) - offsetof (TYPE, Field)))
+
+typedef struct {
+    UINT32  Data1;
+    UINT16  Data2;
+    UINT16  Data3;
+    UINT8   Data4[8];
+} EFI_GUID;
+
+typedef struct {
+    UINT16  Year;
+    UINT8   Month;
+    UINT8   Day;
+    UINT8   Hour;
+    UINT8   Minute;
+    UINT8   Second;
+    UINT8   Pad1;
+    UINT32  Nanosecond;
+    INT16   TimeZone;
+    UINT8   Daylight;
+    UINT8   Pad2;
+} EFI_TIME;
+
+typedef enum {
+    AllHandles,
+    ByRegisterNotify,
+    ByProtocol
+} EFI_LOCATE_SEARCH_TYPE;
+
+// Protocols the EFI host structures embed or point to ... Never called here
+typedef struct { UINT64 Revision; } EFI_FILE_IO_INTERFACE;
+typedef struct { UINT64 Revision; } EFI_FILE;
+typedef struct { UINT64 Revision; } EFI_DISK_IO;
+
+typedef struct {
+    UINT32  MediaId;
+} EFI_BLOCK_IO_MEDIA;
+
+typedef struct {
+    UINT64               Revision;
+    EFI_BLOCK_IO_MEDIA  *Media;
+} EFI_BLOCK_IO;
+
+typedef struct {
+    EFI_STATUS (*LocateHandleBuffer) (
+        EFI_LOCATE_SEARCH_TYPE SearchType, EFI_GUID *Protocol, VOID *SearchKey,
+        UINTN *NoHandles, EFI_HANDLE **Buffer
+    );
+    EFI_STATUS (*HandleProtocol) (EFI_HANDLE Handle, EFI_GUID *Protocol, VOID **Interface);
+} EFI_BOOT_SERVICES;
+
+extern EFI_BOOT_SERVICES  *gBS;
+
+#endif
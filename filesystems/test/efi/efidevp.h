@@ -0,0 +1 @@
+/* Device paths are not used by the host tests */
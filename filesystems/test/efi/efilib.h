@@ -0,0 +1,29 @@
+/*
+ * filesystems/test/efi/efilib.h
+ * Minimal stand-in for the GNU-EFI library header. The test programs
+ * implement these with libc.
+ *
+ * This program is licensed under the terms of the GNU GPL, version 3,
+ * or (at your option) any later version.
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _FSW_TEST_EFILIB_H_
+#define _FSW_TEST_EFILIB_H_
+
+#include "efi.h"
+
+VOID * AllocatePool (IN UINTN Size);
+VOID * AllocateZeroPool (IN UINTN Size);
+VOID   FreePool (IN VOID *Buffer);
+VOID   CopyMem (OUT VOID *Dest, IN CONST VOID *Src, IN UINTN Size);
+VOID   SetMem (OUT VOID *Buffer, IN UINTN Size, IN UINT8 Value);
+VOID   ZeroMem (OUT VOID *Buffer, IN UINTN Size);
+INTN   CompareMem (IN CONST VOID *Dest, IN CONST VOID *Src, IN UINTN Size);
+UINTN  Print (IN CONST CHAR16 *Format, ...);
+UINT64 DivU64x32 (IN UINT64 Dividend, IN UINTN Divisor, OUT UINTN *Remainder OPTIONAL);
+UINT64 RShiftU64 (IN UINT64 Operand, IN UINTN Count);
+UINT64 LShiftU64 (IN UINT64 Operand, IN UINTN Count);
+
+#endif
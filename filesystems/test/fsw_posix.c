@@ -53,6 +53,7 @@ void fsw_posix_change_blocksize(struct fsw_volume *vol,
                               fsw_u32 old_phys_blocksize, fsw_u32 old_log_blocksize,
                               fsw_u32 new_phys_blocksize, fsw_u32 new_log_blocksize);
 fsw_status_t fsw_posix_read_block(struct fsw_volume *vol, fsw_u32 phys_bno, void *buffer);
+fsw_status_t fsw_posix_read_blocks(struct fsw_volume *vol, fsw_u64 phys_bno, fsw_u32 count, void *buffer);
 
 /**
  * Dispatch table for our FSW host driver.
@@ -62,7 +63,8 @@ struct fsw_host_table   fsw_posix_host_table = {
     FSW_STRING_TYPE_ISO88591,
 
     fsw_posix_change_blocksize,
-    fsw_posix_read_block
+    fsw_posix_read_block,
+    fsw_posix_read_blocks
 };
 
 extern struct fsw_fstype_table   FSW_FSTYPE_TABLE_NAME(FSTYPE);
@@ -382,6 +384,31 @@ fsw_status_t fsw_posix_read_block(struct fsw_volume *vol, fsw_u32 phys_bno, void
     return FSW_SUCCESS;
 }
 
+/**
+ * FSW interface function to read a run of contiguous data blocks straight into
+ * the caller's buffer.
+ */
+
+fsw_status_t fsw_posix_read_blocks(struct fsw_volume *vol, fsw_u64 phys_bno, fsw_u32 count, void *buffer)
+{
+    struct fsw_posix_volume *pvol = (struct fsw_posix_volume *)vol->host_data;
+    off_t           block_offset, seek_result;
+    ssize_t         read_result;
+
+    FSW_MSG_DEBUGV((FSW_MSGSTR("fsw_posix_read_blocks: %d  x%d  (%d)\n"), (int)phys_bno, count, vol->phys_blocksize));
+
+    // read from disk
+    block_offset = (off_t)phys_bno * vol->phys_blocksize;
+    seek_result = lseek(pvol->fd, block_offset, SEEK_SET);
+    if (seek_result != block_offset)
+        return FSW_IO_ERROR;
+    read_result = read(pvol->fd, buffer, (size_t)count * vol->phys_blocksize);
+    if (read_result != (ssize_t)count * vol->phys_blocksize)
+        return FSW_IO_ERROR;
+
+    return FSW_SUCCESS;
+}
+
 
 /**
  * Time mapping callback for the fsw_dnode_stat call. This function converts
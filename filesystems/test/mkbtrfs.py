@@ -0,0 +1,159 @@
+#!/usr/bin/env python3
+#
+# filesystems/test/mkbtrfs.py
+# Writes a minimal single device btrfs image for btrfsbench, plus the
+# expected content of its one file. Needs Python 3 only.
+#
+# The image holds just what fsw_btrfs.c reads: a superblock whose bootstrap
+# mapping covers the whole image with one SINGLE chunk (logical address ==
+# physical offset), a chunk tree, a root tree with the top level FS tree, and
+# an FS tree with the root directory and /data.bin. The file is stored as
+# 128K zlib compressed extents, the largest that btrfs writes.
+#
+# Usage: mkbtrfs.py <image> <expected file content>
+#
+# This program is licensed under the terms of the GNU GPL, version 3,
+# or (at your option) any later version.
+# You should have received a copy of the GNU General Public License
+# along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+import random
+import struct
+import sys
+import zlib
+
+NODE_SIZE    = 4096
+SECTOR_SIZE  = 4096
+EXTENT_SIZE  = 128 * 1024
+FILE_SIZE    = 8 * EXTENT_SIZE
+FILE_NAME    = b"data.bin"
+
+SUPERBLOCK   = 0x10000
+CHUNK_TREE   = 0x20000
+ROOT_TREE    = 0x21000
+FS_TREE      = 0x22000
+DATA_START   = 0x30000
+
+INODE_ITEM   = 0x01
+DIR_ITEM     = 0x54
+EXTENT_DATA  = 0x6c
+ROOT_ITEM    = 0x84
+CHUNK_ITEM   = 0xe4
+
+ROOT_DIR_ID  = 0x100
+FILE_ID      = 0x101
+FSID         = bytes(range(1, 17))
+
+
+def crc32c(crc, data):
+    crc ^= 0xffffffff
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = (crc >> 1) ^ (0x82f63b78 if crc & 1 else 0)
+    return crc ^ 0xffffffff
+
+
+def name_hash(name):
+    return ~crc32c(1, name) & 0xffffffff
+
+
+def key(object_id, item_type, offset):
+    return struct.pack("<QBQ", object_id, item_type, offset)
+
+
+def chunk_item(size):
+    # size, owner, stripe_length, type (data, system and metadata), then
+    # io_align, io_width and sector_size, one stripe and no substripes
+    item = struct.pack("<QQQQ12sHH", size, 2, 0x10000, 0x7, b"\0" * 12, 1, 0)
+    stripe = struct.pack("<QQ16s", 1, 0, b"\0" * 16)
+    return item + stripe
+
+
+def inode_item(size, mode):
+    # gen, transid, size, nbytes, block_group, nlink, uid, gid, mode, rdev,
+    # flags, sequence and reserved words, then four timestamps
+    item = struct.pack("<QQQQQIIIIQQQ32s", 1, 1, size, size, 0, 1, 0, 0, mode, 0, 0, 0, b"\0" * 32)
+    return item + struct.pack("<qI", 1700000000, 0) * 4
+
+
+def leaf(bytenr, owner, items):
+    header_size = 0x65
+    body = bytearray(NODE_SIZE - header_size)
+    data_end = len(body)
+    for index, (item_key, data) in enumerate(sorted(items)):
+        data_end -= len(data)
+        body[data_end:data_end + len(data)] = data
+        body[index * 25:(index + 1) * 25] = item_key + struct.pack("<II", data_end, len(data))
+    header = struct.pack("<32s16sQQ16sQQIB", b"\0" * 32, FSID, bytenr, 1, b"\0" * 16, 1, owner, len(items), 0)
+    assert len(header) == header_size
+    return header + bytes(body)
+
+
+def file_content():
+    # Text-like and compressible, but not trivially so
+    rng = random.Random(2023)
+    words = [bytes(rng.choice(b"abcdefghijklmnopqrstuvwxyz") for _ in range(rng.randint(2, 9)))
+             for _ in range(400)]
+    out = bytearray()
+    line = 0
+    while len(out) < FILE_SIZE:
+        out += b"%06d " % line + b" ".join(rng.choice(words) for _ in range(rng.randint(4, 14))) + b"\n"
+        line += 1
+    return bytes(out[:FILE_SIZE])
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit("Usage: mkbtrfs.py <image> <expected file content>")
+
+    content = file_content()
+    data = bytearray()
+    fs_items = [
+        (key(ROOT_DIR_ID, INODE_ITEM, 0), inode_item(0, 0o40755)),
+        (key(FILE_ID, INODE_ITEM, 0), inode_item(FILE_SIZE, 0o100644)),
+    ]
+    dir_item = key(FILE_ID, INODE_ITEM, 0) + struct.pack("<QHHB", 1, 0, len(FILE_NAME), 1) + FILE_NAME
+    fs_items.append((key(ROOT_DIR_ID, DIR_ITEM, name_hash(FILE_NAME)), dir_item))
+
+    for offset in range(0, FILE_SIZE, EXTENT_SIZE):
+        compressed = zlib.compress(content[offset:offset + EXTENT_SIZE], 6)
+        laddr = DATA_START + len(data)
+        data += compressed + b"\0" * (-len(compressed) % SECTOR_SIZE)
+        # generation, ram_bytes, zlib, no encryption or encoding, regular,
+        # then disk_bytenr, disk_num_bytes, offset and num_bytes
+        extent = struct.pack("<QQBBHBQQQQ", 1, EXTENT_SIZE, 1, 0, 0, 1,
+                             laddr, len(compressed), 0, EXTENT_SIZE)
+        fs_items.append((key(FILE_ID, EXTENT_DATA, offset), extent))
+
+    image_size = DATA_START + len(data)
+    image_size += -image_size % 0x10000
+    chunk_key = key(0x100, CHUNK_ITEM, 0)
+    chunk = chunk_item(image_size)
+
+    # The root item points at its tree 0xb0 bytes in
+    root_item = b"\0" * 0xb0 + struct.pack("<QQ", FS_TREE, ROOT_DIR_ID) + b"\0" * 0x100
+
+    image = bytearray(image_size)
+    image[CHUNK_TREE:CHUNK_TREE + NODE_SIZE] = leaf(CHUNK_TREE, 3, [(chunk_key, chunk)])
+    image[ROOT_TREE:ROOT_TREE + NODE_SIZE] = leaf(ROOT_TREE, 1, [(key(5, ROOT_ITEM, 0), root_item)])
+    image[FS_TREE:FS_TREE + NODE_SIZE] = leaf(FS_TREE, 5, fs_items)
+    image[DATA_START:DATA_START + len(data)] = data
+
+    device = struct.pack("<QQ", 1, image_size) + b"\0" * (0x62 - 0x10)
+    superblock = struct.pack("<32s16s16s8sQQQ16sQQQQII49s", b"\0" * 32, FSID, b"\0" * 16, b"_BHRfS_M",
+                             1, ROOT_TREE, CHUNK_TREE, b"\0" * 16, image_size, image_size, 6, 1,
+                             SECTOR_SIZE, NODE_SIZE, b"\0" * 0x31)
+    label = b"fswtest".ljust(0x100, b"\0")
+    bootstrap = (chunk_key + chunk).ljust(0x800, b"\0")
+    superblock += device + label + b"\0" * 0x100 + bootstrap
+    image[SUPERBLOCK:SUPERBLOCK + len(superblock)] = superblock
+
+    with open(sys.argv[1], "wb") as f:
+        f.write(image)
+    with open(sys.argv[2], "wb") as f:
+        f.write(content)
+
+
+if __name__ == "__main__":
+    main()
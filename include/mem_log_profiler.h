@@ -0,0 +1,62 @@
+/*
+ * include/mem_log_profiler.h
+ * Boot profiler span ring shared by MemLogLib and the FSW drivers
+ *
+ * Copyright (c) 2022 Dayo Akanji (sf.net/u/dakanji/profile)
+ *
+ * Distributed under the terms of the GNU General Public License (GPL)
+ * version 3 (GPLv3), a copy of which must be distributed with this
+ * source code or binaries made from it.
+ *
+ */
+
+#ifndef __MEM_LOG_PROFILER_H__
+#define __MEM_LOG_PROFILER_H__
+
+//
+// Profiler span ring size
+// Oldest spans are overwritten once this many have been recorded
+//
+#define MEM_LOG_SPAN_RING_SIZE  4096
+
+//
+// Span handle returned when a span could not be recorded
+// Closing this handle is harmless
+//
+#define MEM_LOG_SPAN_NONE       ((UINTN) -1)
+
+typedef struct {
+    /// Span name ... Must outlive the profile.
+    const CHAR8      *Name;
+    /// TSC ticks when the span was opened.
+    UINT64            TscBegin;
+    /// TSC ticks when the span was closed or 0 while open.
+    UINT64            TscEnd;
+    /// Number of spans open when this one was opened.
+    UINTN             Depth;
+} MEM_LOG_SPAN;
+
+//
+// Published on the RefindPlus image handle on DBG builds so that
+// separately built drivers can record spans into the same ring.
+// This is data only, in pool memory, so a driver never calls back
+// into an image that may since have exited.
+//
+// Span handles are running counts. The slot of handle 'n' is
+// 'n % MEM_LOG_SPAN_RING_SIZE' and a handle is stale once
+// 'SpanCount - n > MEM_LOG_SPAN_RING_SIZE'.
+//
+#define MEM_LOG_PROFILE_PROTOCOL_GUID \
+    { 0x56A1246C, 0x8691, 0x4266, \
+        { 0x84, 0xB7, 0x11, 0x25, 0xB9, 0x87, 0xE8, 0xC4 } }
+
+typedef struct {
+    /// MEM_LOG_SPAN_RING_SIZE entries.
+    MEM_LOG_SPAN     *Spans;
+    /// Spans opened so far ... Also the handle of the next span.
+    UINTN             SpanCount;
+    /// Spans currently open.
+    UINTN             SpanDepth;
+} MEM_LOG_PROFILE;
+
+#endif // __MEM_LOG_PROFILER_H__
@@ -76,15 +76,18 @@
 
 #define MAX_FILE_SIZE (1024*1024*1024)
 
-// Multiplier for pseudo-floating-point operations in egScaleImage().
-// A value of 4096 should keep us within limits on 32-bit systems, but I've
-// seen some minor artifacts at this level, so give it a bit more precision
-// on 64-bit systems.
-#if defined(EFIX64) | defined(EFIAARCH64)
-#   define FP_MULTIPLIER (UINTN) 65536
-#else
-#   define FP_MULTIPLIER (UINTN) 4096
-#endif
+// Fixed point filter weights for egScaleImage() add up to 256. Blue and red,
+// then green and alpha, can then share each multiply in two 16-bit lanes, as
+// a lane reaches 255 * 256 + 128 at most and cannot carry into its neighbour.
+#define SCALE_WEIGHT_BITS  8
+#define SCALE_WEIGHT_ONE   (1 << SCALE_WEIGHT_BITS)
+#define SCALE_LANE_ROUND   0x00800080
+
+typedef struct {
+    UINTN    Taps;       // Source samples per output sample
+    UINTN   *Start;      // First source sample for each output sample
+    UINT16  *Weights;    // Taps weights for each output sample
+} EG_SCALE_FILTER;
 
 #ifndef __MAKEWITH_GNUEFI
 #   define LibLocateHandle gBS->LocateHandleBuffer
@@ -93,6 +96,7 @@
 
 #if REFIT_DEBUG > 0
 extern BOOLEAN   DefaultBanner;
+extern UINT64    GetCurrentUS (VOID);
 CHAR16          *OffsetNext = L"\n                   ";
 #endif
 
@@ -111,7 +115,8 @@ EG_IMAGE * egCreateImage (
     if (NewImage == NULL) {
         return NULL;
     }
-    NewImage->PixelData = (EG_PIXEL *) AllocatePool (Width * Height * sizeof (EG_PIXEL));
+    NewImage->ShareCount = NULL;
+    NewImage->PixelData  = (EG_PIXEL *) AllocatePool (Width * Height * sizeof (EG_PIXEL));
 
     if (NewImage->PixelData == NULL) {
         MY_FREE_IMAGE(NewImage);
@@ -160,6 +165,68 @@ EG_IMAGE * egCopyImage (
     return NewImage;
 }
 
+// Returns a new image that shares PixelData with Image instead of copying it.
+// Each holder releases its image with MY_FREE_IMAGE as usual and the pixels
+// are freed along with the last one. Functions that draw into an image call
+// egUnshareImage first, so a shared image is copied only when written to.
+EG_IMAGE * egShareImage (
+    IN EG_IMAGE *Image
+) {
+    EG_IMAGE  *NewImage;
+
+    if (Image == NULL) {
+        return NULL;
+    }
+
+    if (Image->ShareCount == NULL) {
+        Image->ShareCount = AllocatePool (sizeof (UINTN));
+        if (Image->ShareCount == NULL) {
+            return egCopyImage (Image);
+        }
+        *(Image->ShareCount) = 1;
+    }
+
+    NewImage = AllocateCopyPool (sizeof (EG_IMAGE), Image);
+    if (NewImage == NULL) {
+        return NULL;
+    }
+    *(Image->ShareCount) += 1;
+
+    return NewImage;
+} // EG_IMAGE * egShareImage()
+
+// Gives Image its own copy of any shared PixelData before it is modified.
+// Returns FALSE if the copy could not be made, in which case the image
+// must be left untouched.
+BOOLEAN egUnshareImage (
+    IN OUT EG_IMAGE *Image
+) {
+    EG_PIXEL  *PixelData;
+
+    if (Image == NULL || Image->ShareCount == NULL) {
+        return TRUE;
+    }
+
+    if (*(Image->ShareCount) > 1) {
+        PixelData = AllocateCopyPool (
+            Image->Width * Image->Height * sizeof (EG_PIXEL),
+            Image->PixelData
+        );
+        if (PixelData == NULL) {
+            return FALSE;
+        }
+
+        *(Image->ShareCount) -= 1;
+        Image->PixelData = PixelData;
+    }
+    else {
+        MY_FREE_POOL(Image->ShareCount);
+    }
+    Image->ShareCount = NULL;
+
+    return TRUE;
+} // BOOLEAN egUnshareImage()
+
 // Returns a smaller image composed of the specified crop area from the larger area.
 // If the specified area is larger than is in the original, returns NULL.
 EG_IMAGE * egCropImage (
@@ -190,28 +257,162 @@ EG_IMAGE * egCropImage (
     return NewImage;
 } // EG_IMAGE * egCropImage()
 
-// The following function implements a bilinear image scaling algorithm, based on
-// code presented at http://tech-algorithm.com/articles/bilinear-image-scaling/.
+// Filter tables for egScaleImage. Each output sample along an axis is a
+// weighted sum of Taps consecutive source samples from Start onwards, with
+// fixed point weights that add up to exactly SCALE_WEIGHT_ONE.
+static
+BOOLEAN egBuildScaleFilter (
+    OUT EG_SCALE_FILTER *Filter,
+    IN  UINTN            SrcSize,
+    IN  UINTN            DstSize
+) {
+    UINT16  *Weight;
+    UINTN    i, k;
+    UINTN    First, Frac;
+    UINTN    Lo, Hi, PixLo, PixHi;
+    UINTN    Sum, Heaviest;
+    BOOLEAN  AreaMode;
+
+    AreaMode = (SrcSize >= DstSize * 2);
+    if (SrcSize == DstSize) {
+        Filter->Taps = 1;
+    }
+    else if (AreaMode) {
+        // Each output sample covers SrcSize / DstSize source samples, which
+        // straddle one extra sample unless the ratio is a whole number
+        Filter->Taps = SrcSize / DstSize;
+        if ((SrcSize % DstSize) != 0) Filter->Taps += 2;
+    }
+    else {
+        Filter->Taps = 2;
+    }
+    if (Filter->Taps > SrcSize) Filter->Taps = SrcSize;
+
+    Filter->Start   = AllocatePool (DstSize * sizeof (UINTN));
+    Filter->Weights = AllocateZeroPool (DstSize * Filter->Taps * sizeof (UINT16));
+    if (Filter->Start == NULL || Filter->Weights == NULL) return FALSE;
+
+    for (i = 0; i < DstSize; i++) {
+        Weight = Filter->Weights + i * Filter->Taps;
+
+        if (SrcSize == DstSize) {
+            Filter->Start[i] = i;
+            Weight[0]        = SCALE_WEIGHT_ONE;
+
+            continue;
+        }
+
+        if (AreaMode) {
+            // Work in units of 1/DstSize source samples, so that output
+            // sample i spans [Lo, Hi) and source sample s spans
+            // [s * DstSize, (s + 1) * DstSize)
+            Lo    = i * SrcSize;
+            Hi    = Lo + SrcSize;
+            First = Lo / DstSize;
+            if (First + Filter->Taps > SrcSize) First = SrcSize - Filter->Taps;
+
+            for (k = 0; k < Filter->Taps; k++) {
+                PixLo = (First + k) * DstSize;
+                PixHi = PixLo + DstSize;
+                if (PixLo < Lo) PixLo = Lo;
+                if (PixHi > Hi) PixHi = Hi;
+                if (PixHi > PixLo) {
+                    Weight[k] = (UINT16) (((PixHi - PixLo) * SCALE_WEIGHT_ONE) / SrcSize);
+                }
+            }
+        }
+        else {
+            // Same sample positions as the earlier single pass bilinear
+            // scaler: output sample i maps to i * (SrcSize - 1) / DstSize
+            First = (i * (SrcSize - 1)) / DstSize;
+            Frac  = (((i * (SrcSize - 1)) % DstSize) * SCALE_WEIGHT_ONE) / DstSize;
+            if (First + Filter->Taps > SrcSize) First = SrcSize - Filter->Taps;
+
+            k = ((i * (SrcSize - 1)) / DstSize) - First;
+            Weight[k] = (UINT16) (SCALE_WEIGHT_ONE - Frac);
+            if (Frac != 0 && k + 1 < Filter->Taps) Weight[k + 1] = (UINT16) Frac;
+        }
+
+        Filter->Start[i] = First;
+
+        // Hand any rounding shortfall to the heaviest tap
+        Sum = Heaviest = 0;
+        for (k = 0; k < Filter->Taps; k++) {
+            Sum += Weight[k];
+            if (Weight[k] > Weight[Heaviest]) Heaviest = k;
+        }
+        Weight[Heaviest] += (UINT16) (SCALE_WEIGHT_ONE - Sum);
+    } // for i
+
+    return TRUE;
+} // static BOOLEAN egBuildScaleFilter()
+
+// Scales one source row horizontally into DstWidth pixels.
+static
+VOID egScaleRow (
+    IN  UINT32          *Src,
+    OUT UINT32          *Dst,
+    IN  EG_SCALE_FILTER *Filter,
+    IN  UINTN            DstWidth
+) {
+    UINT32    *Pixel;
+    UINT16    *Weight;
+    UINT32     SumRB, SumGA;
+    UINT32     w;
+    UINTN      j, k;
+
+    Weight = Filter->Weights;
+    for (j = 0; j < DstWidth; j++, Weight += Filter->Taps) {
+        Pixel = Src + Filter->Start[j];
+
+        if (Filter->Taps == 2) {
+            // Common bilinear case
+            SumRB = (Pixel[0]        & 0x00FF00FF) * Weight[0] +
+                    (Pixel[1]        & 0x00FF00FF) * Weight[1];
+            SumGA = ((Pixel[0] >> 8) & 0x00FF00FF) * Weight[0] +
+                    ((Pixel[1] >> 8) & 0x00FF00FF) * Weight[1];
+        }
+        else {
+            SumRB = SumGA = 0;
+            for (k = 0; k < Filter->Taps; k++) {
+                w      = Weight[k];
+                SumRB += (Pixel[k]        & 0x00FF00FF) * w;
+                SumGA += ((Pixel[k] >> 8) & 0x00FF00FF) * w;
+            }
+        }
+
+        Dst[j] = (((SumRB + SCALE_LANE_ROUND) >> 8) & 0x00FF00FF) |
+                  ((SumGA + SCALE_LANE_ROUND)       & 0xFF00FF00);
+    }
+} // static VOID egScaleRow()
+
 // Resize an image; returns pointer to resized image if successful, NULL otherwise.
 // Calling function is responsible for freeing allocated memory.
-// NOTE: x_ratio, y_ratio, x_diff, and y_diff should really be float values;
-// however, I've found that my 32-bit Mac Mini has a buggy EFI (or buggy CPU?), which
-// causes this function to hang on float-to-UINT8 conversions on some (but not all!)
-// float values. Therefore, this function uses integer arithmetic but multiplies
-// all values by FP_MULTIPLIER to achieve something resembling the sort of precision
-// needed for good results.
+// The image is scaled in two separable passes: each source row is first scaled
+// horizontally into a small ring of intermediate rows, which are then combined
+// vertically. Per axis filter tables are built once up front. Enlargements and
+// mild reductions use bilinear weights; reductions by a factor of two or more
+// average the source area covered by each output pixel instead, to avoid the
+// aliasing that point sampling four pixels gives.
+// NOTE: All arithmetic is integer based, as some EFI implementations (such as
+// on a 32-bit Mac Mini) hang on float-to-UINT8 conversions for some values.
 EG_IMAGE * egScaleImage (
     IN EG_IMAGE  *Image,
     IN UINTN      NewWidth,
     IN UINTN      NewHeight
 ) {
-    EG_IMAGE  *NewImage = NULL;
-    EG_PIXEL   a, b, c, d;
-    UINTN      i, j;
-    UINTN      x, y, Index;
-    UINTN      Offset = 0;
-    UINTN      x_diff, y_diff;
-    UINTN      x_ratio, y_ratio;
+    EG_IMAGE         *NewImage = NULL;
+    EG_SCALE_FILTER   FilterX;
+    EG_SCALE_FILTER   FilterY;
+    UINT32           *RowRing  = NULL;
+    UINT32          **Rows     = NULL;
+    UINT32           *Dest;
+    UINT16           *Weight;
+    UINTN            *RowOf    = NULL;
+    UINTN             i, j, k;
+    UINTN             SrcRow, Slot;
+    UINT32            SumRB, SumGA;
+    UINT32            w;
 
     #if REFIT_DEBUG > 0
     ALT_LOG(1, LOG_LINE_NORMAL, L"Scaling Image to %d x %d", NewWidth, NewHeight);
@@ -238,49 +439,83 @@ EG_IMAGE * egScaleImage (
         return NULL;
     }
 
-    x_ratio = ((Image->Width - 1) * FP_MULTIPLIER) / NewWidth;
-    y_ratio = ((Image->Height - 1) * FP_MULTIPLIER) / NewHeight;
-
-    for (i = 0; i < NewHeight; i++) {
-        for (j = 0; j < NewWidth; j++) {
-            x = (j * (Image->Width - 1)) / NewWidth;
-            y = (i * (Image->Height - 1)) / NewHeight;
-            x_diff = (x_ratio * j) - x * FP_MULTIPLIER;
-            y_diff = (y_ratio * i) - y * FP_MULTIPLIER;
-            Index = ((y * Image->Width) + x);
-            a = Image->PixelData[Index];
-            b = Image->PixelData[Index + 1];
-            c = Image->PixelData[Index + Image->Width];
-            d = Image->PixelData[Index + Image->Width + 1];
-
-            // blue element
-            NewImage->PixelData[Offset].b = ((a.b) * (FP_MULTIPLIER - x_diff) * (FP_MULTIPLIER - y_diff) +
-                (b.b) * (x_diff) * (FP_MULTIPLIER - y_diff) +
-                (c.b) * (y_diff) * (FP_MULTIPLIER - x_diff) +
-                (d.b) * (x_diff * y_diff)) / (FP_MULTIPLIER * FP_MULTIPLIER);
-
-            // green element
-            NewImage->PixelData[Offset].g = ((a.g) * (FP_MULTIPLIER - x_diff) * (FP_MULTIPLIER - y_diff) +
-                (b.g) * (x_diff) * (FP_MULTIPLIER - y_diff) +
-                (c.g) * (y_diff) * (FP_MULTIPLIER - x_diff) +
-                (d.g) * (x_diff * y_diff)) / (FP_MULTIPLIER * FP_MULTIPLIER);
-
-            // red element
-            NewImage->PixelData[Offset].r = ((a.r) * (FP_MULTIPLIER - x_diff) * (FP_MULTIPLIER - y_diff) +
-                (b.r) * (x_diff) * (FP_MULTIPLIER - y_diff) +
-                (c.r) * (y_diff) * (FP_MULTIPLIER - x_diff) +
-                (d.r) * (x_diff * y_diff)) / (FP_MULTIPLIER * FP_MULTIPLIER);
-
-            // alpha element
-            NewImage->PixelData[Offset++].a = ((a.a) * (FP_MULTIPLIER - x_diff) * (FP_MULTIPLIER - y_diff) +
-                (b.a) * (x_diff) * (FP_MULTIPLIER - y_diff) +
-                (c.a) * (y_diff) * (FP_MULTIPLIER - x_diff) +
-                (d.a) * (x_diff * y_diff)) / (FP_MULTIPLIER * FP_MULTIPLIER);
-        } // for (j...)
-    } // for (i...)
+    ZeroMem (&FilterX, sizeof (EG_SCALE_FILTER));
+    ZeroMem (&FilterY, sizeof (EG_SCALE_FILTER));
+
+    if (egBuildScaleFilter (&FilterX, Image->Width,  NewWidth) &&
+        egBuildScaleFilter (&FilterY, Image->Height, NewHeight)
+    ) {
+        RowRing = AllocatePool (FilterY.Taps * NewWidth * sizeof (UINT32));
+        Rows    = AllocatePool (FilterY.Taps * sizeof (UINT32 *));
+        RowOf   = AllocatePool (FilterY.Taps * sizeof (UINTN));
+    }
+
+    if (RowRing == NULL || Rows == NULL || RowOf == NULL) {
+        #if REFIT_DEBUG > 0
+        ALT_LOG(1, LOG_LINE_NORMAL, L"In egScaleImage ... Could Not Allocate Scaling Buffers!!");
+        #endif
+
+        MY_FREE_IMAGE(NewImage);
+    }
+    else {
+        for (k = 0; k < FilterY.Taps; k++) {
+            RowOf[k] = (UINTN) -1;
+        }
+
+        Dest = (UINT32 *) NewImage->PixelData;
+        for (i = 0; i < NewHeight; i++, Dest += NewWidth) {
+            Weight = FilterY.Weights + i * FilterY.Taps;
+
+            // Source rows in a window are distinct modulo Taps and windows
+            // only move down, so each source row is scaled just once
+            for (k = 0; k < FilterY.Taps; k++) {
+                SrcRow  = FilterY.Start[i] + k;
+                Slot    = SrcRow % FilterY.Taps;
+                Rows[k] = RowRing + Slot * NewWidth;
+                if (RowOf[Slot] != SrcRow) {
+                    egScaleRow (
+                        (UINT32 *) (Image->PixelData + SrcRow * Image->Width),
+                        Rows[k], &FilterX, NewWidth
+                    );
+                    RowOf[Slot] = SrcRow;
+                }
+            }
+
+            for (j = 0; j < NewWidth; j++) {
+                if (FilterY.Taps == 2) {
+                    // Common bilinear case
+                    SumRB = (Rows[0][j]        & 0x00FF00FF) * Weight[0] +
+                            (Rows[1][j]        & 0x00FF00FF) * Weight[1];
+                    SumGA = ((Rows[0][j] >> 8) & 0x00FF00FF) * Weight[0] +
+                            ((Rows[1][j] >> 8) & 0x00FF00FF) * Weight[1];
+                }
+                else {
+                    SumRB = SumGA = 0;
+                    for (k = 0; k < FilterY.Taps; k++) {
+                        w      = Weight[k];
+                        SumRB += (Rows[k][j]        & 0x00FF00FF) * w;
+                        SumGA += ((Rows[k][j] >> 8) & 0x00FF00FF) * w;
+                    }
+                }
+
+                Dest[j] = (((SumRB + SCALE_LANE_ROUND) >> 8) & 0x00FF00FF) |
+                           ((SumGA + SCALE_LANE_ROUND)       & 0xFF00FF00);
+            } // for j
+        } // for i
+    } // if/else RowRing == NULL
+
+    MY_FREE_POOL(FilterX.Start);
+    MY_FREE_POOL(FilterX.Weights);
+    MY_FREE_POOL(FilterY.Start);
+    MY_FREE_POOL(FilterY.Weights);
+    MY_FREE_POOL(RowRing);
+    MY_FREE_POOL(Rows);
+    MY_FREE_POOL(RowOf);
 
     #if REFIT_DEBUG > 0
-    ALT_LOG(1, LOG_LINE_NORMAL, L"Scaling Image Completed");
+    if (NewImage != NULL) {
+        ALT_LOG(1, LOG_LINE_NORMAL, L"Scaling Image Completed");
+    }
     #endif
 
     return NewImage;
@@ -458,8 +693,41 @@ EFI_STATUS egSaveFile (
 // Loading images from files and embedded data
 //
 
-// Decode the specified image data. The IconSize parameter is relevant only
-// for ICNS, for which it selects which ICNS sub-image is decoded.
+// Image decoders, selected by the signature at the start of the file. Each
+// decoder also checks the signature itself, so a file that matches none of
+// them would have been rejected by all of them. To support another format,
+// add its decoder and signature here.
+typedef struct {
+    CHAR16          *Name;
+    EG_DECODE_FUNC   Decode;
+    UINT8            Signature[8];
+    UINTN            SignatureSize;
+#if REFIT_DEBUG > 0
+    UINTN            Count;
+    UINTN            Failures;
+    UINT64           Bytes;
+    UINT64           Microseconds;
+#endif
+} EG_DECODER;
+
+static
+EG_DECODER egDecoders[] = {
+    { L"PNG",  egDecodePNG,  { 0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A }, 8 },
+    { L"JPEG", egDecodeJPEG, { 0xFF, 0xD8 },                                   2 },
+    { L"BMP",  egDecodeBMP,  { 'B', 'M' },                                     2 },
+    { L"ICNS", egDecodeICNS, { 'i', 'c', 'n', 's' },                           4 }
+};
+
+#define EG_DECODER_COUNT (sizeof (egDecoders) / sizeof (egDecoders[0]))
+
+#if REFIT_DEBUG > 0
+static
+UINTN egUnknownImageCount = 0;
+#endif
+
+// Decode the specified image data. The IconSize parameter selects which ICNS
+// sub-image is decoded and lets JPEG images be downscaled while decoding; zero
+// means that the image is wanted at its full size.
 // Returns a pointer to the resulting EG_IMAGE or NULL if decoding failed.
 static
 EG_IMAGE * egDecodeAny (
@@ -468,14 +736,83 @@ EG_IMAGE * egDecodeAny (
     IN UINTN     IconSize,
     IN BOOLEAN   WantAlpha
 ) {
-    EG_IMAGE       *NewImage = egDecodePNG  (FileData, FileDataLength, IconSize, WantAlpha);
-    if (!NewImage)  NewImage = egDecodeJPEG (FileData, FileDataLength, IconSize, WantAlpha);
-    if (!NewImage)  NewImage = egDecodeBMP  (FileData, FileDataLength, IconSize, WantAlpha);
-    if (!NewImage)  NewImage = egDecodeICNS (FileData, FileDataLength, IconSize, WantAlpha);
+    EG_IMAGE    *NewImage;
+    EG_DECODER  *Decoder;
+    UINTN        i;
+
+    #if REFIT_DEBUG > 0
+    UINT64       StartUS;
+    #endif
+
+    if (FileData == NULL) {
+        return NULL;
+    }
+
+    Decoder = NULL;
+    for (i = 0; i < EG_DECODER_COUNT; i++) {
+        if (FileDataLength >= egDecoders[i].SignatureSize &&
+            CompareMem (FileData, egDecoders[i].Signature, egDecoders[i].SignatureSize) == 0
+        ) {
+            Decoder = &egDecoders[i];
+            break;
+        }
+    }
+
+    if (Decoder == NULL) {
+        #if REFIT_DEBUG > 0
+        egUnknownImageCount++;
+        ALT_LOG(1, LOG_LINE_NORMAL, L"In egDecodeAny ... Unrecognised Image Format!!");
+        #endif
+
+        return NULL;
+    }
+
+    #if REFIT_DEBUG > 0
+    StartUS = GetCurrentUS();
+    #endif
+
+    NewImage = Decoder->Decode (FileData, FileDataLength, IconSize, WantAlpha);
+
+    #if REFIT_DEBUG > 0
+    Decoder->Count++;
+    Decoder->Bytes        += FileDataLength;
+    Decoder->Microseconds += GetCurrentUS() - StartUS;
+    if (NewImage == NULL) {
+        Decoder->Failures++;
+    }
+    #endif
 
     return NewImage;
 } // static EG_IMAGE * egDecodeAny ()
 
+// Writes per-format decode counts, input sizes and times to the log
+VOID egLogDecoderStats (VOID) {
+    #if REFIT_DEBUG > 0
+    UINTN i;
+
+    for (i = 0; i < EG_DECODER_COUNT; i++) {
+        if (egDecoders[i].Count == 0) {
+            continue;
+        }
+
+        ALT_LOG(1, LOG_THREE_STAR_MID,
+            L"Image Decoder %-4s ... %d File%s (%d Failed), %ld Bytes, %ld us",
+            egDecoders[i].Name,
+            egDecoders[i].Count, (egDecoders[i].Count == 1) ? L"" : L"s",
+            egDecoders[i].Failures,
+            egDecoders[i].Bytes, egDecoders[i].Microseconds
+        );
+    }
+
+    if (egUnknownImageCount > 0) {
+        ALT_LOG(1, LOG_THREE_STAR_MID,
+            L"Image Decoder ---- ... %d File%s in Unrecognised Formats",
+            egUnknownImageCount, (egUnknownImageCount == 1) ? L"" : L"s"
+        );
+    }
+    #endif
+} // VOID egLogDecoderStats()
+
 EG_IMAGE * egLoadImage (
     IN EFI_FILE *BaseDir,
     IN CHAR16   *FileName,
@@ -509,14 +846,97 @@ EG_IMAGE * egLoadImage (
         return NULL;
     }
 
-    // Decode it
-    // '128' can be any arbitrary value
-    NewImage = egDecodeAny (FileData, FileDataLength, 128, WantAlpha);
+    // Decode it at full size
+    NewImage = egDecodeAny (FileData, FileDataLength, 0, WantAlpha);
     MY_FREE_POOL(FileData);
 
     return NewImage;
 } // EG_IMAGE * egLoadImage()
 
+//
+// Decoded icon cache
+//
+
+// Icons loaded from SelfDir are decoded and scaled once per path and size,
+// then handed out with egShareImage(). Entries that resolve to the same icon
+// file share one copy of its pixels.
+
+typedef struct _icon_cache_entry {
+    struct _icon_cache_entry  *Next;
+    CHAR16                    *Path;
+    UINTN                      IconSize;
+    BOOLEAN                    WantAlpha;
+    EG_IMAGE                  *Image;
+} ICON_CACHE_ENTRY;
+
+static
+ICON_CACHE_ENTRY *IconCache = NULL;
+
+static
+ICON_CACHE_ENTRY * egFindCachedIcon (
+    IN CHAR16  *Path,
+    IN UINTN    IconSize,
+    IN BOOLEAN  WantAlpha
+) {
+    ICON_CACHE_ENTRY *Entry;
+
+    for (Entry = IconCache; Entry != NULL; Entry = Entry->Next) {
+        if (Entry->IconSize  == IconSize  &&
+            Entry->WantAlpha == WantAlpha &&
+            MyStriCmp (Entry->Path, Path)
+        ) {
+            break;
+        }
+    }
+
+    return Entry;
+} // static ICON_CACHE_ENTRY * egFindCachedIcon()
+
+static
+VOID egAddCachedIcon (
+    IN CHAR16    *Path,
+    IN UINTN      IconSize,
+    IN BOOLEAN    WantAlpha,
+    IN EG_IMAGE  *Image
+) {
+    ICON_CACHE_ENTRY *Entry;
+
+    Entry = AllocateZeroPool (sizeof (ICON_CACHE_ENTRY));
+    if (Entry == NULL) {
+        return;
+    }
+
+    Entry->Path      = StrDuplicate (Path);
+    Entry->IconSize  = IconSize;
+    Entry->WantAlpha = WantAlpha;
+    Entry->Image     = egShareImage (Image);
+    if (Entry->Path == NULL || Entry->Image == NULL) {
+        MY_FREE_POOL(Entry->Path);
+        MY_FREE_IMAGE(Entry->Image);
+        MY_FREE_POOL(Entry);
+
+        return;
+    }
+
+    Entry->Next = IconCache;
+    IconCache   = Entry;
+} // static VOID egAddCachedIcon()
+
+// Drops the cache's references to decoded icons. Images already handed out
+// remain valid until their holders free them.
+VOID egFreeIconCache (VOID) {
+    ICON_CACHE_ENTRY *Entry;
+
+    while (IconCache != NULL) {
+        Entry     = IconCache;
+        IconCache = Entry->Next;
+
+        MY_FREE_POOL(Entry->Path);
+        MY_FREE_IMAGE(Entry->Image);
+        MY_FREE_POOL(Entry);
+    }
+} // VOID egFreeIconCache()
+
 // Load an icon from (BaseDir)/Path, extracting the icon of size IconSize x IconSize.
 // Returns a pointer to the image data, or NULL if the icon could not be loaded.
 EG_IMAGE * egLoadIcon (
@@ -524,11 +944,12 @@ EG_IMAGE * egLoadIcon (
     IN CHAR16   *Path,
     IN UINTN     IconSize
 ) {
-    EFI_STATUS      Status;
-    UINTN           FileDataLength = 0;
-    UINT8          *FileData;
-    EG_IMAGE       *NewImage;
-    EG_IMAGE       *Image;
+    EFI_STATUS         Status;
+    UINTN              FileDataLength = 0;
+    UINT8             *FileData;
+    EG_IMAGE          *NewImage;
+    EG_IMAGE          *Image;
+    ICON_CACHE_ENTRY  *CachedIcon;
 
     if ((BaseDir == NULL) || (Path == NULL)) {
         #if REFIT_DEBUG > 0
@@ -557,8 +978,22 @@ EG_IMAGE * egLoadIcon (
         return NULL;
     }
 
+    if (BaseDir == SelfDir) {
+        CachedIcon = egFindCachedIcon (Path, IconSize, TRUE);
+        if (CachedIcon != NULL) {
+            #if REFIT_DEBUG > 0
+            ALT_LOG(1, LOG_THREE_STAR_MID, L"Using Cached Icon:- '%s'", Path);
+            #endif
+
+            // Early Return
+            return egShareImage (CachedIcon->Image);
+        }
+    }
+
     // Try to load file if able to get to image
+    PROF_BEGIN(SpanIconRead, "egLoadIcon Read");
     Status = egLoadFile (BaseDir, Path, &FileData, &FileDataLength);
+    PROF_END(SpanIconRead);
     if (EFI_ERROR(Status)) {
         #if REFIT_DEBUG > 0
         ALT_LOG(1, LOG_LINE_NORMAL,
@@ -572,8 +1007,10 @@ EG_IMAGE * egLoadIcon (
     }
 
     // Decode it
+    PROF_BEGIN(SpanIconDecode, "egLoadIcon Decode");
     Image = egDecodeAny (FileData, FileDataLength, IconSize, TRUE);
     MY_FREE_POOL(FileData);
+    PROF_END(SpanIconDecode);
 
     // Return null if unable to decode
     if (Image == NULL) {
@@ -603,7 +1040,9 @@ EG_IMAGE * egLoadIcon (
             w = IconSize;
             h = IconSize;
         }
+        PROF_BEGIN(SpanIconScale, "egLoadIcon Scale");
         NewImage = egScaleImage (Image, w, h);
+        PROF_END(SpanIconScale);
 
         // Use scaled image if available
         if (NewImage) {
@@ -626,6 +1065,10 @@ EG_IMAGE * egLoadIcon (
         }
     }
 
+    if (BaseDir == SelfDir) {
+        egAddCachedIcon (Path, IconSize, TRUE, Image);
+    }
+
     return Image;
 } // EG_IMAGE *egLoadIcon()
 
@@ -685,6 +1128,257 @@ EG_IMAGE * egLoadIconAnyType (
     return Image;
 } // EG_IMAGE *egLoadIconAnyType()
 
+//
+// Icon directory index
+//
+
+// Each icons directory is listed once and its icon files are kept in a small
+// hash table keyed on the case-insensitive base name. egFindIcon() then only
+// opens files that are known to exist, rather than probing every extension in
+// ICON_EXTENSIONS for every candidate name.
+
+#define ICON_INDEX_BUCKETS  (64)
+#define ICON_INDEX_MAX_EXT  (16)
+
+typedef struct _icon_index_entry {
+    struct _icon_index_entry  *Next;
+    UINT32                     Hash;
+    UINTN                      BaseLength;  // Characters before the extension
+    UINTN                      ExtIndex;    // Position of the extension in ICON_EXTENSIONS
+    CHAR16                    *FileName;    // On-disk name, stored after the entry
+} ICON_INDEX_ENTRY;
+
+typedef struct {
+    CHAR16            *DirName;   // Directory the index was built from, or NULL
+    BOOLEAN            Complete;  // FALSE if the listing could not be fully read
+    UINTN              EntryCount;
+    ICON_INDEX_ENTRY  *Buckets[ICON_INDEX_BUCKETS];
+} ICON_INDEX;
+
+// Slot 0 is for GlobalConfig.IconsDir and slot 1 is for DEFAULT_ICONS_DIR
+static
+ICON_INDEX IconIndex[2];
+
+static
+CHAR16 IconIndexLower (
+    IN CHAR16 Char
+) {
+    return (Char >= L'A' && Char <= L'Z') ? (Char - L'A' + L'a') : Char;
+} // static CHAR16 IconIndexLower()
+
+// Case-insensitive FNV-1a hash of the first Length characters of Name
+static
+UINT32 IconIndexHash (
+    IN CHAR16 *Name,
+    IN UINTN   Length
+) {
+    UINTN   i;
+    UINT32  Hash = 2166136261U;
+
+    for (i = 0; i < Length; i++) {
+        Hash = (Hash ^ IconIndexLower (Name[i])) * 16777619U;
+    }
+
+    return Hash;
+} // static UINT32 IconIndexHash()
+
+static
+BOOLEAN IconIndexNameMatch (
+    IN CHAR16 *Name1,
+    IN CHAR16 *Name2,
+    IN UINTN   Length
+) {
+    UINTN i;
+
+    for (i = 0; i < Length; i++) {
+        if (IconIndexLower (Name1[i]) != IconIndexLower (Name2[i])) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+} // static BOOLEAN IconIndexNameMatch()
+
+static
+VOID egFreeIconIndexSlot (
+    IN OUT ICON_INDEX *Index
+) {
+    UINTN              i;
+    ICON_INDEX_ENTRY  *Entry;
+
+    for (i = 0; i < ICON_INDEX_BUCKETS; i++) {
+        while (Index->Buckets[i] != NULL) {
+            Entry             = Index->Buckets[i];
+            Index->Buckets[i] = Entry->Next;
+            MY_FREE_POOL(Entry);
+        }
+    }
+
+    MY_FREE_POOL(Index->DirName);
+    Index->Complete   = FALSE;
+    Index->EntryCount = 0;
+} // static VOID egFreeIconIndexSlot()
+
+// Releases the icon directory indexes. They are rebuilt on the next call to
+// egFindIcon(), so this is called whenever SelfDir is closed.
+VOID egFreeIconIndex (VOID) {
+    egFreeIconIndexSlot (&IconIndex[0]);
+    egFreeIconIndexSlot (&IconIndex[1]);
+} // VOID egFreeIconIndex()
+
+// Lists DirName, relative to SelfDir, and records every file with an
+// extension in ICON_EXTENSIONS. Entries sharing a bucket are kept in
+// ICON_EXTENSIONS order so lookups try extensions in the usual preference.
+static
+VOID egBuildIconIndex (
+    IN OUT ICON_INDEX *Index,
+    IN     CHAR16     *DirName
+) {
+    EFI_STATUS          Status;
+    REFIT_DIR_ITER      DirIter;
+    EFI_FILE_INFO      *DirEntry;
+    ICON_INDEX_ENTRY   *Entry;
+    ICON_INDEX_ENTRY  **Link;
+    CHAR16             *Extensions[ICON_INDEX_MAX_EXT];
+    UINTN               ExtCount;
+    UINTN               ExtIndex;
+    UINTN               Length;
+    UINTN               Dot;
+    UINTN               i;
+
+    egFreeIconIndexSlot (Index);
+
+    Index->DirName = StrDuplicate (DirName);
+    if (Index->DirName == NULL) {
+        // Early Return ... Callers fall back on probing
+        return;
+    }
+
+    ExtCount = 0;
+    while (ExtCount < ICON_INDEX_MAX_EXT &&
+        (Extensions[ExtCount] = FindCommaDelimited (ICON_EXTENSIONS, ExtCount)) != NULL
+    ) {
+        ExtCount++;
+    }
+
+    Index->Complete = TRUE;
+    DirIterOpen (SelfDir, DirName, &DirIter);
+    while (DirIterNext (&DirIter, 2, NULL, &DirEntry)) {
+        Length = StrLen (DirEntry->FileName);
+        Dot    = Length;
+        while (Dot > 0 && DirEntry->FileName[Dot - 1] != L'.') {
+            Dot--;
+        }
+
+        ExtIndex = ExtCount;
+        if (Dot > 1) {
+            for (ExtIndex = 0; ExtIndex < ExtCount; ExtIndex++) {
+                if (MyStriCmp (&DirEntry->FileName[Dot], Extensions[ExtIndex])) {
+                    break;
+                }
+            }
+        }
+
+        if (ExtIndex < ExtCount) {
+            Entry = AllocatePool (sizeof (ICON_INDEX_ENTRY) + (Length + 1) * sizeof (CHAR16));
+            if (Entry == NULL) {
+                Index->Complete = FALSE;
+                MY_FREE_POOL(DirEntry);
+
+                break;
+            }
+
+            Entry->FileName   = (CHAR16 *) (Entry + 1);
+            Entry->BaseLength = Dot - 1;
+            Entry->ExtIndex   = ExtIndex;
+            Entry->Hash       = IconIndexHash (DirEntry->FileName, Entry->BaseLength);
+            CopyMem (Entry->FileName, DirEntry->FileName, (Length + 1) * sizeof (CHAR16));
+
+            Link = &Index->Buckets[Entry->Hash % ICON_INDEX_BUCKETS];
+            while (*Link != NULL && (*Link)->ExtIndex <= ExtIndex) {
+                Link = &(*Link)->Next;
+            }
+            Entry->Next = *Link;
+            *Link       = Entry;
+
+            Index->EntryCount++;
+        }
+
+        MY_FREE_POOL(DirEntry);
+    } // while
+
+    Status = DirIterClose (&DirIter);
+    if (EFI_ERROR(Status) && Status != EFI_NOT_FOUND) {
+        // A missing directory simply holds no icons
+        Index->Complete = FALSE;
+    }
+
+    for (i = 0; i < ExtCount; i++) {
+        MY_FREE_POOL(Extensions[i]);
+    }
+
+    #if REFIT_DEBUG > 0
+    ALT_LOG(1, LOG_THREE_STAR_MID,
+        L"Indexed %d Icon File%s in '%s' ... %s",
+        Index->EntryCount, (Index->EntryCount == 1) ? L"" : L"s",
+        DirName, (Index->Complete) ? L"Complete" : L"Incomplete (Will Probe)"
+    );
+    #endif
+} // static VOID egBuildIconIndex()
+
+// Returns an icon with base name BaseName from the directory DirName (relative
+// to SelfDir), using the index for that directory. Falls back on
+// egLoadIconAnyType() if the directory could not be fully indexed.
+static
+EG_IMAGE * egFindIconInDir (
+    IN OUT ICON_INDEX *Index,
+    IN     CHAR16     *DirName,
+    IN     CHAR16     *BaseName,
+    IN     UINTN       IconSize
+) {
+    EG_IMAGE          *Image = NULL;
+    ICON_INDEX_ENTRY  *Entry;
+    CHAR16            *FileName;
+    UINTN              Length;
+    UINT32             Hash;
+
+    if (Index->DirName == NULL || !MyStriCmp (Index->DirName, DirName)) {
+        egBuildIconIndex (Index, DirName);
+    }
+
+    if (Index->DirName == NULL || !Index->Complete) {
+        // Early Return
+        return egLoadIconAnyType (SelfDir, DirName, BaseName, IconSize);
+    }
+
+    Length = StrLen (BaseName);
+    Hash   = IconIndexHash (BaseName, Length);
+    for (Entry = Index->Buckets[Hash % ICON_INDEX_BUCKETS];
+        Image == NULL && Entry != NULL;
+        Entry = Entry->Next
+    ) {
+        if (Entry->Hash       != Hash   ||
+            Entry->BaseLength != Length ||
+            !IconIndexNameMatch (Entry->FileName, BaseName, Length)
+        ) {
+            continue;
+        }
+
+        #if REFIT_DEBUG > 0
+        ALT_LOG(1, LOG_THREE_STAR_MID,
+            L"Loading Indexed Icon:- '%s\\%s'",
+            DirName, Entry->FileName
+        );
+        #endif
+
+        FileName = PoolPrint (L"%s\\%s", DirName, Entry->FileName);
+        Image    = egLoadIcon (SelfDir, FileName, IconSize);
+        MY_FREE_POOL(FileName);
+    } // for
+
+    return Image;
+} // static EG_IMAGE * egFindIconInDir()
+
 // Returns an icon with any extension in ICON_EXTENSIONS from either the directory
 // specified by GlobalConfig.IconsDir or DEFAULT_ICONS_DIR. The input BaseName
 // should be the icon name without an extension. For instance, if BaseName is
@@ -692,23 +1386,31 @@ EG_IMAGE * egLoadIconAnyType (
 // ICON_EXTENSIONS is "icns,png", this function will return myicons/os_linux.icns,
 // myicons/os_linux.png, icons/os_linux.icns, or icons/os_linux.png, in that
 // order of preference. Returns NULL if no such icon can be found. All file
-// references are relative to SelfDir.
+// references are relative to SelfDir. Each directory is listed once and
+// only files present in that listing are opened.
 EG_IMAGE * egFindIcon (
     IN CHAR16 *BaseName,
     IN UINTN   IconSize
 ) {
     EG_IMAGE *Image = NULL;
 
+    if (!AllowGraphicsMode || SelfDir == NULL || BaseName == NULL) {
+        // Early Return
+        return NULL;
+    }
+
     if (GlobalConfig.IconsDir != NULL) {
-        Image = egLoadIconAnyType (
-            SelfDir, GlobalConfig.IconsDir,
+        Image = egFindIconInDir (
+            &IconIndex[0], GlobalConfig.IconsDir,
             BaseName, IconSize
         );
     }
 
-    if (Image == NULL) {
-        Image = egLoadIconAnyType (
-            SelfDir, DEFAULT_ICONS_DIR,
+    if (Image == NULL &&
+        (GlobalConfig.IconsDir == NULL || !MyStriCmp (GlobalConfig.IconsDir, DEFAULT_ICONS_DIR))
+    ) {
+        Image = egFindIconInDir (
+            &IconIndex[1], DEFAULT_ICONS_DIR,
             BaseName, IconSize
         );
     }
@@ -975,7 +1677,7 @@ VOID egFillImage (
     EG_PIXEL    FillColor;
     EG_PIXEL   *PixelPtr;
 
-    if (CompImage && Color) {
+    if (CompImage && Color && egUnshareImage (CompImage)) {
         FillColor = *Color;
         if (!CompImage->HasAlpha) {
             FillColor.a = 0;
@@ -1004,7 +1706,7 @@ VOID egFillImageArea (
     if (CompImage && Color) {
         egRestrictImageArea (CompImage, AreaPosX, AreaPosY, &AreaWidth, &AreaHeight);
 
-        if (AreaWidth > 0) {
+        if (AreaWidth > 0 && egUnshareImage (CompImage)) {
             FillColor = *Color;
             if (!CompImage->HasAlpha) {
                 FillColor.a = 0;
@@ -1030,18 +1732,17 @@ VOID egRawCopy (
     IN UINTN         CompLineOffset,
     IN UINTN         TopLineOffset
 ) {
-    UINTN       x, y;
-    EG_PIXEL   *TopPtr, *CompPtr;
+    UINTN y;
 
-    if (CompBasePtr && TopBasePtr) {
-        for (y = 0; y < Height; y++) {
-            TopPtr  = TopBasePtr;
-            CompPtr = CompBasePtr;
+    if (CompBasePtr && TopBasePtr && Width > 0) {
+        if (CompLineOffset == Width && TopLineOffset == Width) {
+            // Both areas are contiguous ... Copy in one go
+            CopyMem (CompBasePtr, TopBasePtr, Width * Height * sizeof (EG_PIXEL));
+            return;
+        }
 
-            for (x = 0; x < Width; x++) {
-                *CompPtr = *TopPtr;
-                TopPtr++, CompPtr++;
-            }
+        for (y = 0; y < Height; y++) {
+            CopyMem (CompBasePtr, TopBasePtr, Width * sizeof (EG_PIXEL));
 
             TopBasePtr  += TopLineOffset;
             CompBasePtr += CompLineOffset;
@@ -1049,6 +1750,16 @@ VOID egRawCopy (
     }
 } // VOID egRawCopy()
 
+// Blends the colour channels of TopBasePtr over CompBasePtr using the alpha
+// channel of TopBasePtr. The alpha channel of CompBasePtr is left untouched.
+//
+// Each pixel is handled as a UINT32 with blue and red packed into two 16-bit
+// lanes and green in a third, so three channels need two multiply pairs
+// rather than three. Products cannot carry between lanes since
+// c * (255 - a) + t * a + 0x80 < 0x10000, and the result is bit for bit that
+// of the per channel '(Temp + (Temp >> 8)) >> 8' rounding. Fully transparent
+// and fully opaque pixels, which make up most of icons and font cells, are
+// resolved without any multiplication.
 VOID egRawCompose (
     IN OUT EG_PIXEL *CompBasePtr,
     IN EG_PIXEL     *TopBasePtr,
@@ -1058,28 +1769,39 @@ VOID egRawCompose (
     IN UINTN         TopLineOffset
 ) {
     UINTN        x, y;
-    EG_PIXEL    *TopPtr, *CompPtr;
-    UINTN        Alpha;
-    UINTN        RevAlpha;
-    UINTN        Temp;
+    UINT32      *TopPtr, *CompPtr;
+    UINT32       Top, Comp;
+    UINT32       Alpha;
+    UINT32       RevAlpha;
+    UINT32       TempRB, TempG;
 
     if (CompBasePtr && TopBasePtr) {
         for (y = 0; y < Height; y++) {
-            TopPtr  = TopBasePtr;
-            CompPtr = CompBasePtr;
+            TopPtr  = (UINT32 *) TopBasePtr;
+            CompPtr = (UINT32 *) CompBasePtr;
+
+            for (x = 0; x < Width; x++, TopPtr++, CompPtr++) {
+                Top   = *TopPtr;
+                Alpha = Top >> 24;
+
+                if (Alpha == 0) {
+                    continue;
+                }
+
+                Comp = *CompPtr;
+                if (Alpha == 255) {
+                    *CompPtr = (Comp & 0xFF000000) | (Top & 0x00FFFFFF);
+                    continue;
+                }
 
-            for (x = 0; x < Width; x++) {
-                Alpha    = TopPtr->a;
                 RevAlpha = 255 - Alpha;
 
-                Temp       = (UINTN) CompPtr->b * RevAlpha + (UINTN) TopPtr->b * Alpha + 0x80;
-                CompPtr->b = (Temp + (Temp >> 8)) >> 8;
-                Temp       = (UINTN) CompPtr->g * RevAlpha + (UINTN) TopPtr->g * Alpha + 0x80;
-                CompPtr->g = (Temp + (Temp >> 8)) >> 8;
-                Temp       = (UINTN) CompPtr->r * RevAlpha + (UINTN) TopPtr->r * Alpha + 0x80;
-                CompPtr->r = (Temp + (Temp >> 8)) >> 8;
+                TempRB = (Comp & 0x00FF00FF) * RevAlpha + (Top & 0x00FF00FF) * Alpha + 0x00800080;
+                TempRB = ((TempRB + ((TempRB >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+                TempG  = ((Comp >> 8) & 0xFF) * RevAlpha + ((Top >> 8) & 0xFF) * Alpha + 0x80;
+                TempG  = ((TempG + (TempG >> 8)) >> 8) & 0xFF;
 
-                TopPtr++, CompPtr++;
+                *CompPtr = (Comp & 0xFF000000) | TempRB | (TempG << 8);
             }
 
             TopBasePtr  += TopLineOffset;
@@ -1104,7 +1826,7 @@ VOID egComposeImage (
         egRestrictImageArea (CompImage, PosX, PosY, &CompWidth, &CompHeight);
 
         // compose
-        if (CompWidth > 0) {
+        if (CompWidth > 0 && egUnshareImage (CompImage)) {
             if (TopImage->HasAlpha) {
                 egRawCompose (
                     CompImage->PixelData + PosY * CompImage->Width + PosX,
@@ -62,6 +62,7 @@ typedef struct {
     UINTN     Height;
     BOOLEAN   HasAlpha;
     EG_PIXEL *PixelData;
+    UINTN    *ShareCount;  // Images sharing PixelData, or NULL if not shared
 } EG_IMAGE;
 
 #define EG_EIPIXELMODE_GRAY         (0)
@@ -102,11 +103,17 @@ VOID egSetGraphicsModeEnabled (IN BOOLEAN Enable);
 VOID egInitScreen (VOID);
 VOID egScreenShot (VOID);
 VOID egLoadFont (IN CHAR16 *Filename);
+VOID egFreeIconIndex (VOID);
+VOID egFreeIconCache (VOID);
+VOID egLogDecoderStats (VOID);
 VOID egClearScreen (IN EG_PIXEL *Color);
 VOID egFillImage (IN OUT EG_IMAGE *CompImage, IN EG_PIXEL *Color);
 VOID egGetScreenSize (OUT UINTN *ScreenWidth, OUT UINTN *ScreenHeight);
 VOID egMeasureText (IN CHAR16 *Text, OUT UINTN *Width, OUT UINTN *Height);
 VOID egDrawImage (IN EG_IMAGE *Image, IN UINTN ScreenPosX, IN UINTN ScreenPosY);
+VOID egBeginScreenBatch (VOID);
+VOID egEndScreenBatch (VOID);
+VOID egFreeBackBuffer (VOID);
 VOID egDisplayMessage (
     CHAR16    *Text,
     EG_PIXEL  *BGColor,
@@ -155,13 +162,22 @@ VOID egDrawImageArea(
 
 
 BOOLEAN egHasGraphicsMode (VOID);
+BOOLEAN egUnshareImage (IN OUT EG_IMAGE *Image);
 BOOLEAN egIsGraphicsModeEnabled (VOID);
 BOOLEAN egSetTextMode (UINT32 RequestedMode);
 BOOLEAN egGetResFromMode (UINTN *ModeWidth, UINTN *Height);
 BOOLEAN egInitUGADraw (BOOLEAN LogOutput);
+BOOLEAN egDrawImageOnBase (
+    IN EG_IMAGE *BaseImage,
+    IN EG_IMAGE *Image      OPTIONAL,
+    IN EG_IMAGE *BadgeImage OPTIONAL,
+    IN UINTN     XPos,
+    IN UINTN     YPos
+);
 
 EG_IMAGE * egCopyScreen (VOID);
 EG_IMAGE * egCopyImage (IN EG_IMAGE *Image);
+EG_IMAGE * egShareImage (IN EG_IMAGE *Image);
 EG_IMAGE * egFindIcon (IN CHAR16 *BaseName, IN UINTN IconSize);
 EG_IMAGE * egScaleImage (EG_IMAGE *Image, UINTN NewWidth, UINTN NewHeight);
 EG_IMAGE * egCopyScreenArea (UINTN XPos, UINTN YPos, UINTN Width, UINTN Height);
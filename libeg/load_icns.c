@@ -35,13 +35,70 @@
  */
 
 #include "libegint.h"
+#include "../BootMaster/global.h"
+#include "../BootMaster/rp_funcs.h"
 
-#define MAX_ICNS_SIZES 4
+// Block tags are stored as big-endian four character codes
+#define ICNS_TAG(a, b, c, d) \
+    (((UINT32) (a) << 24) | ((UINT32) (b) << 16) | ((UINT32) (c) << 8) | (UINT32) (d))
+
+// What a block holds
+#define ICNS_KIND_RGB   0   // 24-bit RGB, RLE compressed planes or interleaved
+#define ICNS_KIND_MASK  1   // 8-bit alpha mask for the RGB member of the same size
+#define ICNS_KIND_PNG   2   // PNG (or JPEG 2000, which is not supported) stream
+
+// Pixel sizes that an icon family can hold
+#define ICNS_SIZE_COUNT 8
+static
+UINTN IcnsSizes[ICNS_SIZE_COUNT] = { 16, 32, 48, 64, 128, 256, 512, 1024 };
+
+typedef struct {
+    UINT32  Tag;
+    UINTN   SizeIndex;   // Index into IcnsSizes
+    UINTN   Kind;
+    UINTN   Skip;        // Header bytes ahead of the data
+} ICNS_BLOCK_TYPE;
+
+static
+ICNS_BLOCK_TYPE IcnsBlockTypes[] = {
+    { ICNS_TAG('i', 's', '3', '2'), 0, ICNS_KIND_RGB,  0 },
+    { ICNS_TAG('s', '8', 'm', 'k'), 0, ICNS_KIND_MASK, 0 },
+    { ICNS_TAG('i', 'c', 'p', '4'), 0, ICNS_KIND_PNG,  0 },
+    { ICNS_TAG('i', 'l', '3', '2'), 1, ICNS_KIND_RGB,  0 },
+    { ICNS_TAG('l', '8', 'm', 'k'), 1, ICNS_KIND_MASK, 0 },
+    { ICNS_TAG('i', 'c', 'p', '5'), 1, ICNS_KIND_PNG,  0 },
+    { ICNS_TAG('i', 'c', '1', '1'), 1, ICNS_KIND_PNG,  0 },   // 16x16@2x
+    { ICNS_TAG('i', 'h', '3', '2'), 2, ICNS_KIND_RGB,  0 },
+    { ICNS_TAG('h', '8', 'm', 'k'), 2, ICNS_KIND_MASK, 0 },
+    { ICNS_TAG('i', 'c', 'p', '6'), 3, ICNS_KIND_PNG,  0 },
+    { ICNS_TAG('i', 'c', '1', '2'), 3, ICNS_KIND_PNG,  0 },   // 32x32@2x
+    { ICNS_TAG('i', 't', '3', '2'), 4, ICNS_KIND_RGB,  4 },
+    { ICNS_TAG('t', '8', 'm', 'k'), 4, ICNS_KIND_MASK, 0 },
+    { ICNS_TAG('i', 'c', '0', '7'), 4, ICNS_KIND_PNG,  0 },
+    { ICNS_TAG('i', 'c', '0', '8'), 5, ICNS_KIND_PNG,  0 },
+    { ICNS_TAG('i', 'c', '1', '3'), 5, ICNS_KIND_PNG,  0 },   // 128x128@2x
+    { ICNS_TAG('i', 'c', '0', '9'), 6, ICNS_KIND_PNG,  0 },
+    { ICNS_TAG('i', 'c', '1', '4'), 6, ICNS_KIND_PNG,  0 },   // 256x256@2x
+    { ICNS_TAG('i', 'c', '1', '0'), 7, ICNS_KIND_PNG,  0 }    // 512x512@2x
+};
+
+#define ICNS_BLOCK_TYPE_COUNT (sizeof (IcnsBlockTypes) / sizeof (IcnsBlockTypes[0]))
+
+// The members found for one pixel size
+typedef struct {
+    UINT8  *Data[3];     // Indexed by ICNS_KIND_*
+    UINTN   Length[3];
+} ICNS_MEMBER;
+
+static
+UINT8 IcnsPngSignature[8] = { 0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A };
 
 //
 // Decompress .icns RLE data
 //
 
+// Expands one RLE plane into the EG_PIXEL channel at PixelData.
+// Used for the embedded images; .icns files go through egUnpackIcnsRLE().
 VOID egDecompressIcnsRLE (
     IN OUT UINT8 **CompData,
     IN OUT UINTN  *CompLen,
@@ -85,19 +142,226 @@ VOID egDecompressIcnsRLE (
         pp_left -= len;
     }
 
+    #if REFIT_DEBUG > 0
     if (pp_left > 0) {
-        Print (L" egDecompressIcnsRLE: still need %d bytes of pixel data\n", pp_left);
+        ALT_LOG(1, LOG_LINE_NORMAL,
+            L"In egDecompressIcnsRLE ... Short by %d Bytes of Pixel Data!!",
+            pp_left
+        );
     }
+    #endif
 
     // record what's left of the compressed data stream
     *CompData = cp;
     *CompLen = (UINTN)(cp_end - cp);
-}
+} // VOID egDecompressIcnsRLE()
+
+// Expands one RLE plane into PixelCount contiguous bytes at Plane.
+// A short stream leaves the rest of the plane zeroed.
+// Returns TRUE if the plane was complete.
+static
+BOOLEAN egUnpackIcnsRLE (
+    IN OUT UINT8 **CompData,
+    IN OUT UINTN  *CompLen,
+    OUT    UINT8  *Plane,
+    IN     UINTN   PixelCount
+) {
+    UINT8 *cp;
+    UINT8 *cp_end;
+    UINT8 *pp;
+    UINTN  Done;
+    UINTN  len, i;
+    UINT8  value;
+
+    cp     = *CompData;
+    cp_end =  cp + *CompLen;
+    pp     =  Plane;
+    Done   =  0;
+
+    while (cp + 1 < cp_end && Done < PixelCount) {
+        len = *cp++;
+        if (len & 0x80) {   // compressed data: repeat next byte
+            len -= 125;
+            if (len > PixelCount - Done) {
+                break;
+            }
+            value = *cp++;
+            for (i = 0; i < len; i++) {
+                pp[i] = value;
+            }
+        }
+        else {              // uncompressed data: copy bytes
+            len++;
+            if (len > PixelCount - Done || len > (UINTN) (cp_end - cp)) {
+                break;
+            }
+            for (i = 0; i < len; i++) {
+                pp[i] = cp[i];
+            }
+            cp += len;
+        }
+        pp   += len;
+        Done += len;
+    }
+
+    if (Done < PixelCount) {
+        SetMem (Plane + Done, PixelCount - Done, 0);
+    }
+
+    *CompData = cp;
+    *CompLen  = (UINTN) (cp_end - cp);
+
+    return (Done == PixelCount);
+} // static BOOLEAN egUnpackIcnsRLE()
+
+// Builds the EG_PIXEL buffer from separate colour planes in one pass.
+// Alpha comes from the mask plane or, without one, is set to AlphaValue.
+static
+VOID egInterleaveIcnsPlanes (
+    OUT EG_PIXEL  *PixelData,
+    IN  UINT8     *Red,
+    IN  UINT8     *Green,
+    IN  UINT8     *Blue,
+    IN  UINT8     *Mask OPTIONAL,
+    IN  UINT8      AlphaValue,
+    IN  UINTN      PixelCount
+) {
+    UINT32  *Dst;
+    UINT32   Alpha;
+    UINTN    i;
+
+    // EG_PIXEL is laid out as b, g, r, a
+    Dst = (UINT32 *) PixelData;
+    if (Mask != NULL) {
+        for (i = 0; i < PixelCount; i++) {
+            Dst[i] = (UINT32) Blue[i] | ((UINT32) Green[i] << 8) |
+                ((UINT32) Red[i] << 16) | ((UINT32) Mask[i] << 24);
+        }
+    }
+    else {
+        Alpha = (UINT32) AlphaValue << 24;
+        for (i = 0; i < PixelCount; i++) {
+            Dst[i] = (UINT32) Blue[i] | ((UINT32) Green[i] << 8) |
+                ((UINT32) Red[i] << 16) | Alpha;
+        }
+    }
+} // static VOID egInterleaveIcnsPlanes()
 
 //
 // Load Apple .icns icons
 //
 
+// Decodes the legacy 24-bit member of an icon family, with its mask if any
+static
+EG_IMAGE * egDecodeIcnsRGB (
+    IN ICNS_MEMBER *Member,
+    IN UINTN        Size,
+    IN BOOLEAN      WantAlpha
+) {
+    EG_IMAGE  *NewImage;
+    UINT8     *Planes;
+    UINT8     *Mask;
+    UINT8     *CompData;
+    UINT8     *SrcPtr;
+    UINTN      CompLen;
+    UINTN      PixelCount;
+    UINTN      i;
+    BOOLEAN    Complete;
+
+    NewImage = egCreateImage (Size, Size, WantAlpha);
+    if (NewImage == NULL) {
+        return NULL;
+    }
+    PixelCount = Size * Size;
+
+    Mask = NULL;
+    if (WantAlpha && Member->Length[ICNS_KIND_MASK] >= PixelCount) {
+        Mask = Member->Data[ICNS_KIND_MASK];
+    }
+
+    CompData = Member->Data[ICNS_KIND_RGB];
+    CompLen  = Member->Length[ICNS_KIND_RGB];
+    if (CompLen >= PixelCount * 3) {
+        // pixel data is uncompressed, RGB interleaved
+        SrcPtr = CompData;
+        for (i = 0; i < PixelCount; i++, SrcPtr += 3) {
+            NewImage->PixelData[i].r = SrcPtr[0];
+            NewImage->PixelData[i].g = SrcPtr[1];
+            NewImage->PixelData[i].b = SrcPtr[2];
+            NewImage->PixelData[i].a = Mask ? Mask[i] : (WantAlpha ? 255 : 0);
+        }
+
+        return NewImage;
+    }
+
+    // pixel data is compressed, RGB planar
+    Planes = AllocatePool (PixelCount * 3);
+    if (Planes == NULL) {
+        MY_FREE_IMAGE(NewImage);
+        return NULL;
+    }
+
+    Complete  = egUnpackIcnsRLE (&CompData, &CompLen, Planes,                  PixelCount);
+    Complete &= egUnpackIcnsRLE (&CompData, &CompLen, Planes + PixelCount,     PixelCount);
+    Complete &= egUnpackIcnsRLE (&CompData, &CompLen, Planes + PixelCount * 2, PixelCount);
+
+    if (!Complete) {
+        #if REFIT_DEBUG > 0
+        ALT_LOG(1, LOG_LINE_NORMAL,
+            L"In egDecodeIcnsRGB ... %dx%d RLE Data is Truncated!!",
+            Size, Size
+        );
+        #endif
+
+        // Let the caller try another member
+        MY_FREE_POOL(Planes);
+        MY_FREE_IMAGE(NewImage);
+        return NULL;
+    }
+
+    // Alpha defaults to 'Opaque' if it was required but is unavailable or to
+    // 'Zero' if it was not required ('Zero' just clears the unused bytes)
+    egInterleaveIcnsPlanes (
+        NewImage->PixelData,
+        Planes, Planes + PixelCount, Planes + PixelCount * 2,
+        Mask, WantAlpha ? 255 : 0, PixelCount
+    );
+    MY_FREE_POOL(Planes);
+
+    return NewImage;
+} // static EG_IMAGE * egDecodeIcnsRGB()
+
+// Picks the member that best fits IconSize: the smallest one that is at least
+// that size or, failing that, the largest one. An IconSize of zero asks for
+// the largest. Returns the index into IcnsSizes or ICNS_SIZE_COUNT if none.
+static
+UINTN egPickIcnsMember (
+    IN ICNS_MEMBER *Members,
+    IN UINTN        IconSize
+) {
+    UINTN  i;
+    UINTN  Best;
+
+    Best = ICNS_SIZE_COUNT;
+    for (i = 0; i < ICNS_SIZE_COUNT; i++) {
+        if (Members[i].Data[ICNS_KIND_RGB] == NULL &&
+            Members[i].Data[ICNS_KIND_PNG] == NULL
+        ) {
+            continue;
+        }
+
+        if (Best == ICNS_SIZE_COUNT ||
+            IconSize == 0 ||
+            IcnsSizes[Best] < IconSize
+        ) {
+            // Sizes ascend, so this one is larger than the current pick
+            Best = i;
+        }
+    }
+
+    return Best;
+} // static UINTN egPickIcnsMember()
+
 EG_IMAGE * egDecodeICNS (
     IN UINT8   *FileData,
     IN UINTN    FileDataLength,
@@ -105,14 +369,13 @@ EG_IMAGE * egDecodeICNS (
     IN BOOLEAN  WantAlpha
 ) {
     EG_IMAGE            *NewImage;
-    UINT32               BlockLen, DataLen, MaskLen;
-    UINTN                CompLen;
-    UINTN                i, PixelCount;
-    UINTN                SizeToTry = 0;
-    UINTN                SizesToTry[MAX_ICNS_SIZES + 1] = {IconSize, 128, 48, 32, 16};
-    UINT8               *Ptr, *SrcPtr, *DataPtr, *MaskPtr;
-    UINT8               *CompData, *BufferEnd;
-    EG_PIXEL            *DestPtr;
+    ICNS_MEMBER          Members[ICNS_SIZE_COUNT];
+    ICNS_MEMBER         *Member;
+    ICNS_BLOCK_TYPE     *Type;
+    UINT32               BlockLen, Tag;
+    UINTN                i, Pick;
+    UINT8               *Ptr, *BufferEnd;
+    BOOLEAN              PreferPng;
 
     if (FileDataLength < 8 || FileData   == NULL ||
         FileData[0] != 'i' || FileData[1] != 'c' ||
@@ -122,157 +385,87 @@ EG_IMAGE * egDecodeICNS (
         return NULL;
     }
 
-    DataLen = 0;
-    MaskLen = 0;
-    DataPtr = NULL;
-    MaskPtr = NULL;
-
-    do {
-        Ptr       = FileData + 8;
-        IconSize  = SizesToTry[SizeToTry];
-        BufferEnd = FileData + FileDataLength;
-
-        // iterate over tagged blocks in the file
-        while (Ptr + 8 <= BufferEnd) {
-            BlockLen = ((UINT32)Ptr[4] << 24) + ((UINT32)Ptr[5] << 16) + ((UINT32)Ptr[6] << 8) + (UINT32)Ptr[7];
-            if (Ptr + BlockLen > BufferEnd) {
-                // block continues beyond end of file
-                break;
-            }
+    // Index every member of the family in one pass over the tagged blocks
+    ZeroMem (Members, sizeof (Members));
+    Ptr       = FileData + 8;
+    BufferEnd = FileData + FileDataLength;
+    while (Ptr + 8 <= BufferEnd) {
+        Tag      = ICNS_TAG(Ptr[0], Ptr[1], Ptr[2], Ptr[3]);
+        BlockLen = ((UINT32)Ptr[4] << 24) + ((UINT32)Ptr[5] << 16) + ((UINT32)Ptr[6] << 8) + (UINT32)Ptr[7];
+        if (BlockLen < 8 || BlockLen > (UINTN) (BufferEnd - Ptr)) {
+            // block is malformed or continues beyond end of file
+            break;
+        }
 
-            // extract the appropriate blocks for each pixel size
-            if (IconSize == 128) {
-                if (Ptr[0] == 'i' &&
-                    Ptr[1] == 't' &&
-                    Ptr[2] == '3' &&
-                    Ptr[3] == '2'
-                ) {
-                    if (Ptr[8]  == 0 &&
-                        Ptr[9]  == 0 &&
-                        Ptr[10] == 0 &&
-                        Ptr[11] == 0
-                    ) {
-                        DataPtr =      Ptr + 12;
-                        DataLen = BlockLen - 12;
-                    }
-                }
-                else if (Ptr[0] == 't' &&
-                        Ptr[1]  == '8' &&
-                        Ptr[2]  == 'm' &&
-                        Ptr[3]  == 'k'
-                ) {
-                    MaskPtr =      Ptr + 8;
-                    MaskLen = BlockLen - 8;
-                }
+        for (i = 0; i < ICNS_BLOCK_TYPE_COUNT; i++) {
+            Type = &IcnsBlockTypes[i];
+            if (Type->Tag != Tag || BlockLen < 8 + Type->Skip) {
+                continue;
             }
-            else if (IconSize == 48) {
-                if (Ptr[0] == 'i' &&
-                    Ptr[1] == 'h' &&
-                    Ptr[2] == '3' &&
-                    Ptr[3] == '2'
-                ) {
-                    DataPtr =      Ptr + 8;
-                    DataLen = BlockLen - 8;
-                }
-                else if (Ptr[0] == 'h' &&
-                        Ptr[1]  == '8' &&
-                        Ptr[2]  == 'm' &&
-                        Ptr[3]  == 'k'
-                ) {
-                    MaskPtr =      Ptr + 8;
-                    MaskLen = BlockLen - 8;
-                }
+
+            Member = &Members[Type->SizeIndex];
+            if (Member->Data[Type->Kind] != NULL) {
+                // keep the first of duplicate members
+                break;
             }
-            else if (IconSize == 32) {
-                if (Ptr[0] == 'i' &&
-                    Ptr[1] == 'l' &&
-                    Ptr[2] == '3' &&
-                    Ptr[3] == '2'
-                ) {
-                    DataPtr =      Ptr + 8;
-                    DataLen = BlockLen - 8;
-                }
-                else if (Ptr[0] == 'l' &&
-                        Ptr[1]  == '8' &&
-                        Ptr[2]  == 'm' &&
-                        Ptr[3]  == 'k'
-                ) {
-                    MaskPtr =      Ptr + 8;
-                    MaskLen = BlockLen - 8;
-                }
+
+            if (Type->Kind == ICNS_KIND_PNG &&
+                (BlockLen < 8 + sizeof (IcnsPngSignature) ||
+                CompareMem (Ptr + 8, IcnsPngSignature, sizeof (IcnsPngSignature)) != 0)
+            ) {
+                // JPEG 2000 payload
+                break;
             }
-            else if (IconSize == 16) {
-                if (Ptr[0] == 'i' &&
-                    Ptr[1] == 's' &&
-                    Ptr[2] == '3' &&
-                    Ptr[3] == '2'
-                ) {
-                    DataPtr =      Ptr + 8;
-                    DataLen = BlockLen - 8;
-                }
-                else if (Ptr[0] == 's' &&
-                        Ptr[1]  == '8' &&
-                        Ptr[2]  == 'm' &&
-                        Ptr[3]  == 'k'
-                ) {
-                    MaskPtr =      Ptr + 8;
-                    MaskLen = BlockLen - 8;
-                }
+
+            if (Type->Skip > 0 &&
+                (Ptr[8] != 0 || Ptr[9] != 0 || Ptr[10] != 0 || Ptr[11] != 0)
+            ) {
+                // unexpected it32 header
+                break;
             }
-            Ptr += BlockLen;
+
+            Member->Data[Type->Kind]   = Ptr + 8 + Type->Skip;
+            Member->Length[Type->Kind] = BlockLen - 8 - Type->Skip;
+            break;
         }
-    } while ((DataPtr == NULL) && (SizeToTry++ < MAX_ICNS_SIZES));
 
-    if (DataPtr == NULL) {
-        // no image found
-        return NULL;
+        Ptr += BlockLen;
     }
 
-    // allocate image structure and buffer
-    NewImage = egCreateImage (IconSize, IconSize, WantAlpha);
-    if (NewImage == NULL) {
-        return NULL;
-    }
-    PixelCount = IconSize * IconSize;
-
-    if (DataLen < PixelCount * 3) {
-        // pixel data is compressed, RGB planar
-        CompData = DataPtr;
-        CompLen  = DataLen;
-        egDecompressIcnsRLE (&CompData, &CompLen, PLPTR(NewImage, r), PixelCount);
-        egDecompressIcnsRLE (&CompData, &CompLen, PLPTR(NewImage, g), PixelCount);
-        egDecompressIcnsRLE (&CompData, &CompLen, PLPTR(NewImage, b), PixelCount);
-        // possible assertion: CompLen == 0
-        if (CompLen > 0) {
-            Print (L" egLoadICNSIcon: %d bytes of compressed data left\n", CompLen);
+    // Decode the best fitting member only, falling back to the next best
+    // one if it turns out to be unusable
+    for (;;) {
+        Pick = egPickIcnsMember (Members, IconSize);
+        if (Pick == ICNS_SIZE_COUNT) {
+            // no image found
+            return NULL;
         }
-    }
-    else {
-        // pixel data is uncompressed, RGB interleaved
-        SrcPtr  = DataPtr;
-        DestPtr = NewImage->PixelData;
-        for (i = 0; i < PixelCount; i++, DestPtr++) {
-            DestPtr->r = *SrcPtr++;
-            DestPtr->g = *SrcPtr++;
-            DestPtr->b = *SrcPtr++;
-        }
-    }
+        Member = &Members[Pick];
 
-    // Handle Alpha
-    if (WantAlpha && MaskPtr != NULL && MaskLen >= PixelCount) {
-        // Add Alpha Mask if Available, Valid and Required
-        egInsertPlane (MaskPtr, PLPTR(NewImage, a), PixelCount);
-    }
-    else {
-        // Alpha is Unavailable or Not Required
-        // Default to 'Opaque' if Alpha was Required but Unavailable or to 'Zero' if it was Not Required
-        // NB: 'Zero' clears unused bytes and is not the opposite of opaque in this case
-        egSetPlane (PLPTR(NewImage, a), WantAlpha ? 255 : 0, PixelCount);
-    }
+        // The RGB member is cheaper to decode, but the PNG one carries its
+        // own alpha channel, so prefer that if the mask is missing
+        PreferPng = (Member->Data[ICNS_KIND_PNG] != NULL) && (
+            Member->Data[ICNS_KIND_RGB] == NULL ||
+            (WantAlpha && Member->Data[ICNS_KIND_MASK] == NULL)
+        );
 
-    // FUTURE: scale to originally requested size if we had to load another size
+        if (PreferPng) {
+            NewImage = egDecodePNG (
+                Member->Data[ICNS_KIND_PNG], Member->Length[ICNS_KIND_PNG],
+                IcnsSizes[Pick], WantAlpha
+            );
+            Member->Data[ICNS_KIND_PNG] = NULL;
+        }
+        else {
+            NewImage = egDecodeIcnsRGB (Member, IcnsSizes[Pick], WantAlpha);
+            Member->Data[ICNS_KIND_RGB] = NULL;
+        }
 
-    return NewImage;
+        if (NewImage != NULL) {
+            // Any scaling to IconSize is left to the caller
+            return NewImage;
+        }
+    }
 } // EG_IMAGE * egDecodeICNS()
 
 /* EOF */
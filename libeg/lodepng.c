@@ -318,10 +318,12 @@ typedef struct ucvector {
   unsigned char* data;
   size_t size; /*used size*/
   size_t allocsize; /*allocated size*/
+  unsigned fixed; /*RefindPlus: if 1, data is caller owned and never reallocated*/
 } ucvector;
 
 /*returns 1 if success, 0 if failure ==> nothing done*/
 static unsigned ucvector_resize(ucvector* p, size_t size) {
+  if(size > p->allocsize && p->fixed) return 0; /*error: does not fit in the caller's buffer*/
   if(size > p->allocsize) {
     size_t newsize = (size > p->allocsize * 2u) ? size : ((size * 3u) >> 1u);
     /* OC: UEFI ReallocatePool compatibility. */
@@ -347,6 +349,7 @@ static void ucvector_cleanup(void* p) {
 static void ucvector_init(ucvector* p) {
   p->data = NULL;
   p->size = p->allocsize = 0;
+  p->fixed = 0;
 }
 #endif /*LODEPNG_COMPILE_PNG*/
 
@@ -356,6 +359,7 @@ init_buffer to take over a buffer and size, it is not needed to use cleanup*/
 static void ucvector_init_buffer(ucvector* p, unsigned char* buffer, size_t size) {
   p->data = buffer;
   p->allocsize = p->size = size;
+  p->fixed = 0;
 }
 #endif /*LODEPNG_COMPILE_ZLIB*/
 
@@ -1505,7 +1509,10 @@ unsigned lodepng_inflate(unsigned char** out, size_t* outsize,
                          const LodePNGDecompressSettings* settings) {
   unsigned error;
   ucvector v;
+  /*RefindPlus: *outsize is the capacity of *out, and output starts at its beginning*/
   ucvector_init_buffer(&v, *out, *outsize);
+  v.size = 0;
+  v.fixed = settings->fixed_output;
   error = lodepng_inflatev(&v, in, insize, settings);
   *out = v.data;
   *outsize = v.size;
@@ -2404,13 +2411,14 @@ const LodePNGCompressSettings lodepng_default_compress_settings = {2, 1, DEFAULT
 void lodepng_decompress_settings_init(LodePNGDecompressSettings* settings) {
   settings->ignore_adler32 = 0;
   settings->ignore_nlen = 0;
+  settings->fixed_output = 0;
 
   settings->custom_zlib = 0;
   settings->custom_inflate = 0;
   settings->custom_context = 0;
 }
 
-const LodePNGDecompressSettings lodepng_default_decompress_settings = {0, 0, 0, 0, 0};
+const LodePNGDecompressSettings lodepng_default_decompress_settings = {0, 0, 0, 0, 0, 0};
 
 #endif /*LODEPNG_COMPILE_DECODER*/
 
@@ -4802,16 +4810,13 @@ unsigned lodepng_inspect_chunk(LodePNGState* state, size_t pos,
 }
 
 /*read a PNG, the result will be in the same color type as the PNG (hence "generic")*/
-static void decodeGeneric(unsigned char** out, unsigned* w, unsigned* h,
-                          LodePNGState* state,
-                          const unsigned char* in, size_t insize) {
+/*reads the chunks that follow the header, appending the data of all IDAT chunks to idat.
+state->info_png must already have been filled in by lodepng_inspect.*/
+static void decodeChunks(ucvector* idat, LodePNGState* state,
+                         const unsigned char* in, size_t insize) {
   unsigned char IEND = 0;
   const unsigned char* chunk;
   size_t i;
-  ucvector idat; /*the data from idat chunks*/
-  unsigned char* scanlines = 0;
-  size_t scanlines_size = 0, expected_size = 0;
-  size_t outsize = 0;
 
   /*for unknown chunk order*/
   unsigned unknown = 0;
@@ -4819,19 +4824,6 @@ static void decodeGeneric(unsigned char** out, unsigned* w, unsigned* h,
   unsigned critical_pos = 1; /*1 = after IHDR, 2 = after PLTE, 3 = after IDAT*/
 #endif /*LODEPNG_COMPILE_ANCILLARY_CHUNKS*/
 
-
-  /* safe output values in case error happens */
-  *out = 0;
-  *w = *h = 0;
-
-  state->error = lodepng_inspect(w, h, state, in, insize); /*reads header and resets other parameters in state->info_png*/
-  if(state->error) return;
-
-  if(lodepng_pixel_overflow(*w, *h, &state->info_png.color, &state->info_raw)) {
-    CERROR_RETURN(state->error, 92); /*overflow possible due to amount of pixels*/
-  }
-
-  ucvector_init(&idat);
   chunk = &in[33]; /*first byte of the first chunk after the header*/
 
   /*loop through the chunks, ignoring unknown chunks and stopping at IEND chunk.
@@ -4864,11 +4856,11 @@ static void decodeGeneric(unsigned char** out, unsigned* w, unsigned* h,
 
     /*IDAT chunk, containing compressed image data*/
     if(lodepng_chunk_type_equals(chunk, "IDAT")) {
-      size_t oldsize = idat.size;
+      size_t oldsize = idat->size;
       size_t newsize;
       if(lodepng_addofl(oldsize, chunkLength, &newsize)) CERROR_BREAK(state->error, 95);
-      if(!ucvector_resize(&idat, newsize)) CERROR_BREAK(state->error, 83 /*alloc fail*/);
-      for(i = 0; i != chunkLength; ++i) idat.data[oldsize + i] = data[i];
+      if(!ucvector_resize(idat, newsize)) CERROR_BREAK(state->error, 83 /*alloc fail*/);
+      for(i = 0; i != chunkLength; ++i) idat->data[oldsize + i] = data[i];
 #ifdef LODEPNG_COMPILE_ANCILLARY_CHUNKS
       critical_pos = 3;
 #endif /*LODEPNG_COMPILE_ANCILLARY_CHUNKS*/
@@ -4956,6 +4948,29 @@ static void decodeGeneric(unsigned char** out, unsigned* w, unsigned* h,
   if(state->info_png.color.colortype == LCT_PALETTE && !state->info_png.color.palette) {
     state->error = 106; /* error: PNG file must have PLTE chunk if color type is palette */
   }
+}
+
+static void decodeGeneric(unsigned char** out, unsigned* w, unsigned* h,
+                          LodePNGState* state,
+                          const unsigned char* in, size_t insize) {
+  ucvector idat; /*the data from idat chunks*/
+  unsigned char* scanlines = 0;
+  size_t scanlines_size = 0, expected_size = 0;
+  size_t outsize = 0;
+
+  /* safe output values in case error happens */
+  *out = 0;
+  *w = *h = 0;
+
+  state->error = lodepng_inspect(w, h, state, in, insize); /*reads header and resets other parameters in state->info_png*/
+  if(state->error) return;
+
+  if(lodepng_pixel_overflow(*w, *h, &state->info_png.color, &state->info_raw)) {
+    CERROR_RETURN(state->error, 92); /*overflow possible due to amount of pixels*/
+  }
+
+  ucvector_init(&idat);
+  decodeChunks(&idat, state, in, insize);
 
   /*predict output size, to allocate exact size for output buffer to avoid more dynamic allocation.
   If the decompressed size does not match the prediction, the image must be corrupt.*/
@@ -4975,13 +4990,11 @@ static void decodeGeneric(unsigned char** out, unsigned* w, unsigned* h,
     expected_size += lodepng_get_raw_size_idat((*w + 0), (*h + 0) >> 1, bpp);
   }
   if(!state->error) {
-    /* This allocated data will be realloced by zlib_decompress, initially at
-    smaller size again. But the fact that it is already allocated at full size
-    here speeds the multiple reallocs up. TODO: make zlib_decompress support
-    receiving already allocated buffer with expected size instead. */
+    /* Allocated at the expected size and handed to zlib_decompress as its
+    capacity, so valid images are inflated without any reallocation. */
     scanlines = (unsigned char*)lodepng_refit_malloc(expected_size);
     if(!scanlines) state->error = 83; /*alloc fail*/
-    scanlines_size = 0;
+    scanlines_size = expected_size;
   }
   if(!state->error) {
     state->error = zlib_decompress(&scanlines, &scanlines_size, idat.data,
@@ -5042,6 +5055,99 @@ unsigned lodepng_decode(unsigned char** out, unsigned* w, unsigned* h,
   return state->error;
 }
 
+size_t lodepng_get_bgra_buffer_size(unsigned w, unsigned h, const LodePNGColorMode* color) {
+  size_t image_size, idat_size;
+  if(lodepng_mulofl((size_t)w, (size_t)h, &image_size)) return 0;
+  if(lodepng_mulofl(image_size, 4u, &image_size)) return 0;
+  if(lodepng_pixel_overflow(w, h, color, color)) return 0;
+  idat_size = lodepng_get_raw_size_idat(w, h, lodepng_get_bpp(color));
+  return LODEPNG_MAX(image_size, idat_size);
+}
+
+/*
+The filtered scanlines are inflated into the tail end of out, then each one is
+unfiltered into a small row buffer and converted into its final place at the
+front of out. A converted row never reaches the start of the next filtered row,
+because the output row stride is no larger than the space left for the filtered
+rows, so the whole decode needs about one image worth of memory.
+*/
+unsigned lodepng_decode_bgra(unsigned char* out, size_t outsize,
+                             unsigned w, unsigned h,
+                             LodePNGState* state,
+                             const unsigned char* in, size_t insize,
+                             unsigned keep_alpha) {
+  ucvector idat;
+  LodePNGDecompressSettings zlibsettings;
+  LodePNGColorMode rgba;
+  unsigned char* scanlines = 0;
+  unsigned char* rows = 0;
+  unsigned char* prevline = 0;
+  unsigned char* recon;
+  unsigned char* pixel;
+  unsigned char swap;
+  size_t scanlines_size, expected_size, linebytes, bytewidth, x;
+  unsigned bpp, y;
+
+  if(state->info_png.interlace_method != 0) return 110; /*error: interlaced images take the generic path*/
+  bpp = lodepng_get_bpp(&state->info_png.color);
+  if(bpp == 0) return 31; /*error: invalid colortype*/
+  if(w == 0 || h == 0) return 93; /*error: zero width or height*/
+
+  if(outsize == 0 || outsize < lodepng_get_bgra_buffer_size(w, h, &state->info_png.color)) {
+    return 111; /*error: output buffer too small*/
+  }
+
+  expected_size = lodepng_get_raw_size_idat(w, h, bpp);
+  linebytes = expected_size / h - 1u;
+  bytewidth = (bpp + 7u) / 8u;
+
+  ucvector_init(&idat);
+  decodeChunks(&idat, state, in, insize);
+
+  if(!state->error) {
+    rows = (unsigned char*)lodepng_refit_malloc(linebytes * 2u);
+    if(!rows) state->error = 83; /*alloc fail*/
+  }
+  if(!state->error) {
+    scanlines = out + (outsize - expected_size);
+    scanlines_size = expected_size;
+    zlibsettings = state->decoder.zlibsettings;
+    zlibsettings.fixed_output = 1;
+    state->error = zlib_decompress(&scanlines, &scanlines_size, idat.data, idat.size, &zlibsettings);
+    if(!state->error && scanlines_size != expected_size) state->error = 91; /*decompressed size does not match prediction*/
+  }
+  ucvector_cleanup(&idat);
+
+  lodepng_color_mode_init(&rgba);
+  rgba.colortype = LCT_RGBA;
+  rgba.bitdepth = 8;
+
+  for(y = 0; y < h && !state->error; ++y) {
+    const unsigned char* line = scanlines + (size_t)y * (linebytes + 1u);
+
+    recon = rows + (y & 1u) * linebytes;
+    state->error = unfilterScanline(recon, line + 1, prevline, bytewidth, line[0], linebytes);
+    if(state->error) break;
+    prevline = recon;
+
+    pixel = out + (size_t)y * w * 4u;
+    state->error = lodepng_convert(pixel, recon, &rgba, &state->info_png.color, w, 1);
+    if(state->error) break;
+
+    for(x = 0; x != w; ++x, pixel += 4) {
+      swap = pixel[0];
+      pixel[0] = pixel[2];
+      pixel[2] = swap;
+      if(!keep_alpha) pixel[3] = 0;
+    }
+  }
+
+  lodepng_color_mode_cleanup(&rgba);
+  lodepng_refit_free(rows);
+
+  return state->error;
+}
+
 unsigned lodepng_decode_memory(unsigned char** out, unsigned* w, unsigned* h, const unsigned char* in,
                                size_t insize, LodePNGColorType colortype, unsigned bitdepth) {
   unsigned error;
@@ -6303,6 +6409,8 @@ const char* lodepng_error_text(unsigned code) {
     case 106: return "PNG file must have PLTE chunk if color type is palette";
     case 107: return "color convert from palette mode requested without setting the palette data in it";
     case 108: return "tried to add more than 256 values to a palette";
+    case 110: return "interlaced image given to lodepng_decode_bgra";
+    case 111: return "output buffer too small for lodepng_decode_bgra";
   }
   return "unknown error code";
 }
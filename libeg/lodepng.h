@@ -305,6 +305,10 @@ struct LodePNGDecompressSettings {
   /* Check LodePNGDecoderSettings for more ignorable errors such as ignore_crc */
   unsigned ignore_adler32; /*if 1, continue and do not give an error message if the Adler32 checksum is corrupted*/
   unsigned ignore_nlen; /*ignore complement of len checksum in uncompressed blocks*/
+  /*RefindPlus: if 1, *out is a caller owned buffer of *outsize bytes that is never
+  reallocated, and output that does not fit gives error 83. custom_zlib and
+  custom_inflate must honour this too.*/
+  unsigned fixed_output;
 
   /*use custom zlib decoder instead of built in one (default: null)*/
   unsigned (*custom_zlib)(unsigned char**, size_t*,
@@ -807,6 +811,25 @@ information is placed in the info_png field of the LodePNGState.
 unsigned lodepng_inspect(unsigned* w, unsigned* h,
                          LodePNGState* state,
                          const unsigned char* in, size_t insize);
+
+/*
+RefindPlus: returns the size of the buffer lodepng_decode_bgra needs for an image
+of w by h pixels in the given PNG color mode, or 0 if that would overflow.
+*/
+size_t lodepng_get_bgra_buffer_size(unsigned w, unsigned h, const LodePNGColorMode* color);
+
+/*
+RefindPlus: decodes a non-interlaced PNG straight into 8-bit BGRA pixels in out,
+which must be a caller owned buffer of outsize bytes, at least the size given by
+lodepng_get_bgra_buffer_size. out is neither reallocated nor freed. The state must
+have been filled in by lodepng_inspect on the same data. If keep_alpha is 0, the
+alpha bytes are set to 0. Returns error 110 for interlaced images.
+*/
+unsigned lodepng_decode_bgra(unsigned char* out, size_t outsize,
+                             unsigned w, unsigned h,
+                             LodePNGState* state,
+                             const unsigned char* in, size_t insize,
+                             unsigned keep_alpha);
 #endif /*LODEPNG_COMPILE_DECODER*/
 
 /*
@@ -110,6 +110,10 @@ typedef struct _lode_color {
    UINT8 alpha;
 } lode_color;
 
+// Non-interlaced images, which is nearly all of them, are decoded by
+// lodepng_decode_bgra() straight into the pixel buffer of the new image, so
+// that a full screen background needs about one image worth of memory. Other
+// images take the generic LodePNG path through an intermediate RGBA buffer.
 EG_IMAGE * egDecodePNG (
     IN UINT8   *FileData,
     IN UINTN    FileDataLength,
@@ -120,8 +124,49 @@ EG_IMAGE * egDecodePNG (
    unsigned Error, Width, Height;
    EG_PIXEL *PixelData;
    lode_color *LodeData;
+   LodePNGState State;
+   size_t BufferSize;
    UINTN i;
 
+   lodepng_state_init (&State);
+   Error = lodepng_inspect (
+       &Width, &Height, &State,
+       (unsigned char *) FileData, (size_t) FileDataLength
+   );
+   if (!Error && State.info_png.interlace_method == 0) {
+      BufferSize = lodepng_get_bgra_buffer_size (Width, Height, &State.info_png.color);
+      if (BufferSize != 0) {
+         NewImage = egCreateImage (Width, Height, WantAlpha);
+      }
+      if (NewImage != NULL && BufferSize > (size_t) Width * Height * sizeof (EG_PIXEL)) {
+         // Filtered scanlines can be a little larger than the image itself
+         MY_FREE_POOL(NewImage->PixelData);
+         NewImage->PixelData = AllocatePool (BufferSize);
+         if (NewImage->PixelData == NULL) {
+            MY_FREE_IMAGE(NewImage);
+         }
+      }
+      if (NewImage != NULL) {
+         Error = lodepng_decode_bgra (
+             (unsigned char *) NewImage->PixelData, BufferSize,
+             Width, Height, &State,
+             (unsigned char *) FileData, (size_t) FileDataLength,
+             WantAlpha ? 1 : 0
+         );
+         if (Error) {
+            MY_FREE_IMAGE(NewImage);
+         }
+      }
+      lodepng_state_cleanup (&State);
+
+      return NewImage;
+   }
+   lodepng_state_cleanup (&State);
+
+   if (Error) {
+      return NULL;
+   }
+
    Error = lodepng_decode_memory (
        (unsigned char **) &PixelData,
         &Width,
@@ -138,10 +183,12 @@ EG_IMAGE * egDecodePNG (
    // allocate image structure and buffer
    NewImage = egCreateImage (Width, Height, WantAlpha);
    if (NewImage == NULL) {
+       lodepng_refit_free (PixelData);
        return NULL;
    }
    if (NewImage->Width != Width || NewImage->Height != Height) {
        // Should never happen; just being paranoid.
+       lodepng_refit_free (PixelData);
        MY_FREE_IMAGE(NewImage);
        return NULL;
    }
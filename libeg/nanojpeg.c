@@ -35,8 +35,7 @@
 // RGB images as output. It does not parse JFIF or Exif headers; all JPEG files
 // are assumed to be either grayscale or YCbCr. CMYK or other color spaces are
 // not supported. All YCbCr subsampling schemes with power-of-two ratios are
-// supported, as are restart intervals. Progressive or lossless JPEG is not
-// supported.
+// supported, as are restart intervals. Lossless JPEG is not supported.
 // Summed up, NanoJPEG should be able to decode all images from digital cameras
 // and most common forms of other non-progressive JPEG images.
 // The decoder is not optimized for speed, it is optimized for simplicity and
@@ -49,6 +48,12 @@
 // should not emit any warnings. It uses only (at least) 32-bit integer
 // arithmetic and is supposed to be endianness independent and 64-bit clean.
 // However, it is not thread-safe.
+//
+// Modified: Progressive (SOF2) images are decoded as well. Their coefficients
+// are collected across all scans and transformed once the EOI marker is
+// reached. Images can also be downscaled by 1/2, 1/4 or 1/8 while decoding
+// (see njDecodeScaled()), in which case only the low-frequency part of each
+// block is transformed.
 
 
 // COMPILE-TIME CONFIGURATION
@@ -144,12 +149,22 @@ int njInit(void);
 // Return value: The error code in case of failure, or NJ_OK (zero) on success.
 nj_result_t njDecode(const void* jpeg, const int size);
 
+// njDecodeScaled: Decode a JPEG image at a reduced size.
+// Like njDecode(), but the image is downscaled by the largest of 1/2, 1/4 or
+// 1/8 that still leaves its larger side at least minsize pixels. The scaling
+// is done in the DCT domain, so it costs less than decoding at full size.
+// A minsize of zero decodes at full size.
+// Return value: The error code in case of failure, or NJ_OK (zero) on success.
+nj_result_t njDecodeScaled(const void* jpeg, const int size, const int minsize);
+
 // njGetWidth: Return the width (in pixels) of the most recently decoded
-// image. If njDecode() failed, the result of njGetWidth() is undefined.
+// image, after any downscaling. If njDecode() failed, the result of
+// njGetWidth() is undefined.
 int njGetWidth(void);
 
 // njGetHeight: Return the height (in pixels) of the most recently decoded
-// image. If njDecode() failed, the result of njGetHeight() is undefined.
+// image, after any downscaling. If njDecode() failed, the result of
+// njGetHeight() is undefined.
 int njGetHeight(void);
 
 // njIsColor: Return 1 if the most recently decoded image is a color image
@@ -173,8 +188,9 @@ int njGetImageSize(void);
 
 // njDone: Uninitialize NanoJPEG.
 // Resets NanoJPEG's internal state and frees all memory that has been
-// allocated at run-time by NanoJPEG. It is still possible to decode another
-// image after a njDone() call.
+// allocated at run-time by NanoJPEG, including the image returned by
+// njGetImage(). It is still possible to decode another image after a
+// njDone() call.
 void njDone(void);
 
 #endif//_NANOJPEG_H
@@ -314,7 +330,10 @@ typedef struct _nj_cmp {
     int qtsel;
     int actabsel, dctabsel;
     int dcpred;
+    // Modified: Block grid and coefficients of progressive images.
+    int bwidth, bheight;
     unsigned char *pixels;
+    short *coefs;
 } nj_component_t;
 
 // Modified structure: Change vlctab[4][65536] to *vlctab[4] so as to minimize
@@ -333,11 +352,17 @@ typedef struct _nj_ctx {
     nj_component_t comp[3];
     int qtused, qtavail;
     unsigned char qtab[4][64];
+    int qaan[4][64];
     nj_vlc_code_t *vlctab[4];
     int buf, bufbits;
     int block[64];
     int rstinterval;
     unsigned char *rgb;
+    // Modified: Downscaling and progressive scan state.
+    int minsize, scale;
+    int progressive, eos;
+    int ss, se, ah, al;
+    int eobrun;
 } nj_context_t;
 
 static nj_context_t nj;
@@ -351,105 +376,151 @@ NJ_FORCE_INLINE unsigned char njClip(const int x) {
     return (x < 0) ? 0 : ((x > 0xFF) ? 0xFF : (unsigned char) x);
 }
 
-#define W1 2841
-#define W2 2676
-#define W3 2408
-#define W5 1609
-#define W6 1108
-#define W7 565
+// Modified: The full size IDCT is the integer AAN (Arai, Agui and Nakajima)
+// IDCT of libjpeg's jidctfst.c. Its scale factors are folded into the
+// dequantization table (nj.qaan), which leaves 5 multiplies per 8-point pass
+// in place of 11. Coefficients keep AAN_PASS_BITS fraction bits until the
+// column pass writes out pixels.
+#define AAN_PASS_BITS 2
+#define AAN_C1 277  // 256 * 1.082392200
+#define AAN_C2 362  // 256 * 1.414213562
+#define AAN_C3 473  // 256 * 1.847759065
+#define AAN_C4 669  // 256 * 2.613125930
+#define AAN_MUL(v, c) (((v) * (c)) >> 8)
+
+// 16384 * cos(k * pi / 16) * sqrt(2) products for row u, column v
+// (1 for k = 0), in natural order
+static const unsigned short njAANScale[64] = {
+    16384, 22725, 21407, 19266, 16384, 12873,  8867,  4520,
+    22725, 31521, 29692, 26722, 22725, 17855, 12299,  6270,
+    21407, 29692, 27969, 25172, 21407, 16819, 11585,  5906,
+    19266, 26722, 25172, 22654, 19266, 15137, 10426,  5315,
+    16384, 22725, 21407, 19266, 16384, 12873,  8867,  4520,
+    12873, 17855, 16819, 15137, 12873, 10114,  6967,  3552,
+     8867, 12299, 11585, 10426,  8867,  6967,  4799,  2446,
+     4520,  6270,  5906,  5315,  4520,  3552,  2446,  1247
+};
 
 NJ_INLINE void njRowIDCT(int* blk) {
-    int x0, x1, x2, x3, x4, x5, x6, x7, x8;
-    if (!((x1 = blk[4] << 11)
-        | (x2 = blk[6])
-        | (x3 = blk[2])
-        | (x4 = blk[1])
-        | (x5 = blk[7])
-        | (x6 = blk[5])
-        | (x7 = blk[3])))
-    {
-        blk[0] = blk[1] = blk[2] = blk[3] = blk[4] = blk[5] = blk[6] = blk[7] = blk[0] << 3;
+    int x0, x1, x2, x3, x4, x5, x6, x7, x10, x11, x12, x13, z5, z10, z11, z12, z13;
+    if (!(blk[1] | blk[2] | blk[3] | blk[4] | blk[5] | blk[6] | blk[7])) {
+        blk[1] = blk[2] = blk[3] = blk[4] = blk[5] = blk[6] = blk[7] = blk[0];
         return;
     }
-    x0 = (blk[0] << 11) + 128;
-    x8 = W7 * (x4 + x5);
-    x4 = x8 + (W1 - W7) * x4;
-    x5 = x8 - (W1 + W7) * x5;
-    x8 = W3 * (x6 + x7);
-    x6 = x8 - (W3 - W5) * x6;
-    x7 = x8 - (W3 + W5) * x7;
-    x8 = x0 + x1;
-    x0 -= x1;
-    x1 = W6 * (x3 + x2);
-    x2 = x1 - (W2 + W6) * x2;
-    x3 = x1 + (W2 - W6) * x3;
-    x1 = x4 + x6;
-    x4 -= x6;
-    x6 = x5 + x7;
-    x5 -= x7;
-    x7 = x8 + x3;
-    x8 -= x3;
-    x3 = x0 + x2;
-    x0 -= x2;
-    x2 = (181 * (x4 + x5) + 128) >> 8;
-    x4 = (181 * (x4 - x5) + 128) >> 8;
-    blk[0] = (x7 + x1) >> 8;
-    blk[1] = (x3 + x2) >> 8;
-    blk[2] = (x0 + x4) >> 8;
-    blk[3] = (x8 + x6) >> 8;
-    blk[4] = (x8 - x6) >> 8;
-    blk[5] = (x0 - x4) >> 8;
-    blk[6] = (x3 - x2) >> 8;
-    blk[7] = (x7 - x1) >> 8;
+    x10 = blk[0] + blk[4];
+    x11 = blk[0] - blk[4];
+    x13 = blk[2] + blk[6];
+    x12 = AAN_MUL(blk[2] - blk[6], AAN_C2) - x13;
+    x0 = x10 + x13;
+    x3 = x10 - x13;
+    x1 = x11 + x12;
+    x2 = x11 - x12;
+    z13 = blk[5] + blk[3];
+    z10 = blk[5] - blk[3];
+    z11 = blk[1] + blk[7];
+    z12 = blk[1] - blk[7];
+    x7 = z11 + z13;
+    x11 = AAN_MUL(z11 - z13, AAN_C2);
+    z5 = AAN_MUL(z10 + z12, AAN_C3);
+    x10 = AAN_MUL(z12, AAN_C1) - z5;
+    x12 = z5 - AAN_MUL(z10, AAN_C4);
+    x6 = x12 - x7;
+    x5 = x11 - x6;
+    x4 = x10 + x5;
+    blk[0] = x0 + x7;
+    blk[7] = x0 - x7;
+    blk[1] = x1 + x6;
+    blk[6] = x1 - x6;
+    blk[2] = x2 + x5;
+    blk[5] = x2 - x5;
+    blk[4] = x3 + x4;
+    blk[3] = x3 - x4;
 }
 
 NJ_INLINE void njColIDCT(const int* blk, unsigned char *out, int stride) {
-    int x0, x1, x2, x3, x4, x5, x6, x7, x8;
-    if (!((x1 = blk[8*4] << 8)
-        | (x2 = blk[8*6])
-        | (x3 = blk[8*2])
-        | (x4 = blk[8*1])
-        | (x5 = blk[8*7])
-        | (x6 = blk[8*5])
-        | (x7 = blk[8*3])))
-    {
-        x1 = njClip(((blk[0] + 32) >> 6) + 128);
-        for (x0 = 8;  x0;  --x0) {
-            *out = (unsigned char) x1;
+    int x0, x1, x2, x3, x4, x5, x6, x7, x10, x11, x12, x13, z5, z10, z11, z12, z13;
+    // Level shift and rounding ride on the DC term into every output
+    const int dc = blk[0] + (128 << (AAN_PASS_BITS + 3)) + (1 << (AAN_PASS_BITS + 2));
+    if (!(blk[8*1] | blk[8*2] | blk[8*3] | blk[8*4] | blk[8*5] | blk[8*6] | blk[8*7])) {
+        x0 = njClip(dc >> (AAN_PASS_BITS + 3));
+        for (x1 = 8;  x1;  --x1) {
+            *out = (unsigned char) x0;
             out += stride;
         }
         return;
     }
-    x0 = (blk[0] << 8) + 8192;
-    x8 = W7 * (x4 + x5) + 4;
-    x4 = (x8 + (W1 - W7) * x4) >> 3;
-    x5 = (x8 - (W1 + W7) * x5) >> 3;
-    x8 = W3 * (x6 + x7) + 4;
-    x6 = (x8 - (W3 - W5) * x6) >> 3;
-    x7 = (x8 - (W3 + W5) * x7) >> 3;
-    x8 = x0 + x1;
-    x0 -= x1;
-    x1 = W6 * (x3 + x2) + 4;
-    x2 = (x1 - (W2 + W6) * x2) >> 3;
-    x3 = (x1 + (W2 - W6) * x3) >> 3;
-    x1 = x4 + x6;
-    x4 -= x6;
-    x6 = x5 + x7;
-    x5 -= x7;
-    x7 = x8 + x3;
-    x8 -= x3;
-    x3 = x0 + x2;
-    x0 -= x2;
-    x2 = (181 * (x4 + x5) + 128) >> 8;
-    x4 = (181 * (x4 - x5) + 128) >> 8;
-    *out = njClip(((x7 + x1) >> 14) + 128);  out += stride;
-    *out = njClip(((x3 + x2) >> 14) + 128);  out += stride;
-    *out = njClip(((x0 + x4) >> 14) + 128);  out += stride;
-    *out = njClip(((x8 + x6) >> 14) + 128);  out += stride;
-    *out = njClip(((x8 - x6) >> 14) + 128);  out += stride;
-    *out = njClip(((x0 - x4) >> 14) + 128);  out += stride;
-    *out = njClip(((x3 - x2) >> 14) + 128);  out += stride;
-    *out = njClip(((x7 - x1) >> 14) + 128);
+    x10 = dc + blk[8*4];
+    x11 = dc - blk[8*4];
+    x13 = blk[8*2] + blk[8*6];
+    x12 = AAN_MUL(blk[8*2] - blk[8*6], AAN_C2) - x13;
+    x0 = x10 + x13;
+    x3 = x10 - x13;
+    x1 = x11 + x12;
+    x2 = x11 - x12;
+    z13 = blk[8*5] + blk[8*3];
+    z10 = blk[8*5] - blk[8*3];
+    z11 = blk[8*1] + blk[8*7];
+    z12 = blk[8*1] - blk[8*7];
+    x7 = z11 + z13;
+    x11 = AAN_MUL(z11 - z13, AAN_C2);
+    z5 = AAN_MUL(z10 + z12, AAN_C3);
+    x10 = AAN_MUL(z12, AAN_C1) - z5;
+    x12 = z5 - AAN_MUL(z10, AAN_C4);
+    x6 = x12 - x7;
+    x5 = x11 - x6;
+    x4 = x10 + x5;
+    *out = njClip((x0 + x7) >> (AAN_PASS_BITS + 3));  out += stride;
+    *out = njClip((x1 + x6) >> (AAN_PASS_BITS + 3));  out += stride;
+    *out = njClip((x2 + x5) >> (AAN_PASS_BITS + 3));  out += stride;
+    *out = njClip((x3 - x4) >> (AAN_PASS_BITS + 3));  out += stride;
+    *out = njClip((x3 + x4) >> (AAN_PASS_BITS + 3));  out += stride;
+    *out = njClip((x2 - x5) >> (AAN_PASS_BITS + 3));  out += stride;
+    *out = njClip((x1 - x6) >> (AAN_PASS_BITS + 3));  out += stride;
+    *out = njClip((x0 - x7) >> (AAN_PASS_BITS + 3));
+}
+
+// Modified: Reduced IDCTs for downscaled decoding. Sampling the 8-point IDCT
+// at the centres of 2x2 (or 4x4) pixel groups leaves the 4-point (or 2-point)
+// IDCT of the lowest 4 (or 2) coefficients, so that is all that gets computed.
+// Constants are 1024 * cos(k * pi / 8); the row pass keeps 4 fraction bits.
+#define V1 946
+#define V2 724
+#define V3 392
+
+NJ_INLINE void njRowIDCT4(int* blk) {
+    const int e0 = V2 * (blk[0] + blk[2]) + 64;
+    const int e1 = V2 * (blk[0] - blk[2]) + 64;
+    const int o0 = V1 * blk[1] + V3 * blk[3];
+    const int o1 = V3 * blk[1] - V1 * blk[3];
+    blk[0] = (e0 + o0) >> 7;
+    blk[1] = (e1 + o1) >> 7;
+    blk[2] = (e1 - o1) >> 7;
+    blk[3] = (e0 - o0) >> 7;
+}
+
+NJ_INLINE void njColIDCT4(const int* blk, unsigned char *out, int stride) {
+    const int e0 = V2 * (blk[0] + blk[8*2]) + 16384;
+    const int e1 = V2 * (blk[0] - blk[8*2]) + 16384;
+    const int o0 = V1 * blk[8*1] + V3 * blk[8*3];
+    const int o1 = V3 * blk[8*1] - V1 * blk[8*3];
+    *out = njClip(((e0 + o0) >> 15) + 128);  out += stride;
+    *out = njClip(((e1 + o1) >> 15) + 128);  out += stride;
+    *out = njClip(((e1 - o1) >> 15) + 128);  out += stride;
+    *out = njClip(((e0 - o0) >> 15) + 128);
+}
+
+NJ_INLINE void njRowIDCT2(int* blk) {
+    const int x0 = V2 * blk[0] + 64;
+    const int x1 = V2 * blk[1];
+    blk[0] = (x0 + x1) >> 7;
+    blk[1] = (x0 - x1) >> 7;
+}
+
+NJ_INLINE void njColIDCT2(const int* blk, unsigned char *out, int stride) {
+    const int x0 = V2 * blk[0] + 16384;
+    const int x1 = V2 * blk[8];
+    out[0] = njClip(((x0 + x1) >> 15) + 128);
+    out[stride] = njClip(((x0 - x1) >> 15) + 128);
 }
 
 #define njThrow(e) do { nj.error = e; return; } while (0)
@@ -459,7 +530,7 @@ static int njShowBits(int bits) {
     unsigned char newbyte;
     if (!bits) return 0;
     while (nj.bufbits < bits) {
-        if (nj.size <= 0) {
+        if ((nj.size <= 0) || nj.eos) {
             nj.buf = (nj.buf << 8) | 0xFF;
             nj.bufbits += 8;
             continue;
@@ -476,14 +547,22 @@ static int njShowBits(int bits) {
                     case 0x00:
                     case 0xFF:
                         break;
-                    case 0xD9: nj.size = 0; break;
+                    case 0xD9:
+                        if (!nj.progressive) { nj.size = 0; break; }
+                        // fall through
                     default:
-                        if ((marker & 0xF8) != 0xD0)
-                            nj.error = NJ_SYNTAX_ERROR;
-                        else {
+                        if ((marker & 0xF8) == 0xD0) {
                             nj.buf = (nj.buf << 8) | marker;
                             nj.bufbits += 8;
-                        }
+                        } else if (nj.progressive) {
+                            // Modified: A progressive scan ends at the next
+                            // marker. Leave it for njDecode() and feed padding
+                            // bits (the 0xFF already buffered is one) from here.
+                            nj.pos -= 2;
+                            nj.size += 2;
+                            nj.eos = 1;
+                        } else
+                            nj.error = NJ_SYNTAX_ERROR;
                 }
             } else
                 nj.error = NJ_SYNTAX_ERROR;
@@ -531,11 +610,30 @@ NJ_INLINE void njSkipMarker(void) {
     njSkip(nj.length);
 }
 
+// Modified: Checks whether the image can be decoded at 1 / (1 << scale) of
+// its size, given the size requested by njDecodeScaled() and the chroma
+// upsampler's need for at least three samples per subsampled row/column.
+static int njScaleFits(int scale, int ssxmax, int ssymax) {
+    const int mask = (1 << scale) - 1;
+    int i, w, h;
+    nj_component_t* c;
+    w = (nj.width + mask) >> scale;
+    h = (nj.height + mask) >> scale;
+    if (((w > h) ? w : h) < nj.minsize) return 0;
+    for (i = 0, c = nj.comp;  i < nj.ncomp;  ++i, ++c) {
+        w = (((nj.width * c->ssx + ssxmax - 1) / ssxmax) + mask) >> scale;
+        h = (((nj.height * c->ssy + ssymax - 1) / ssymax) + mask) >> scale;
+        if (((w < 3) && (c->ssx != ssxmax)) || ((h < 3) && (c->ssy != ssymax))) return 0;
+    }
+    return 1;
+}
+
 NJ_INLINE void njDecodeSOF(void) {
-    int i, ssxmax = 0, ssymax = 0;
+    int i, ssxmax = 0, ssymax = 0, mask;
     nj_component_t* c;
     njDecodeLength();
     njCheckError();
+    if (nj.ncomp) njThrow(NJ_SYNTAX_ERROR);  // Modified: only one frame
     if (nj.length < 9) njThrow(NJ_SYNTAX_ERROR);
     if (nj.pos[0] != 8) njThrow(NJ_UNSUPPORTED);
     nj.height = njDecode16(nj.pos+1);
@@ -571,13 +669,29 @@ NJ_INLINE void njDecodeSOF(void) {
     nj.mbsizey = ssymax << 3;
     nj.mbwidth = (nj.width + nj.mbsizex - 1) / nj.mbsizex;
     nj.mbheight = (nj.height + nj.mbsizey - 1) / nj.mbsizey;
+    // Modified: Pick the strongest downscale that still fits.
+    if (nj.minsize > 0)
+        for (nj.scale = 3;  nj.scale;  --nj.scale)
+            if (njScaleFits(nj.scale, ssxmax, ssymax)) break;
+    mask = (1 << nj.scale) - 1;
     for (i = 0, c = nj.comp;  i < nj.ncomp;  ++i, ++c) {
         c->width = (nj.width * c->ssx + ssxmax - 1) / ssxmax;
         c->height = (nj.height * c->ssy + ssymax - 1) / ssymax;
-        c->stride = nj.mbwidth * c->ssx << 3;
+        c->bwidth = (c->width + 7) >> 3;
+        c->bheight = (c->height + 7) >> 3;
+        c->width = (c->width + mask) >> nj.scale;
+        c->height = (c->height + mask) >> nj.scale;
+        c->stride = nj.mbwidth * c->ssx << (3 - nj.scale);
         if (((c->width < 3) && (c->ssx != ssxmax)) || ((c->height < 3) && (c->ssy != ssymax))) njThrow(NJ_UNSUPPORTED);
-        if (!(c->pixels = (unsigned char*) njAllocMem(c->stride * nj.mbheight * c->ssy << 3))) njThrow(NJ_OUT_OF_MEM);
+        if (!(c->pixels = (unsigned char*) njAllocMem(c->stride * nj.mbheight * c->ssy << (3 - nj.scale)))) njThrow(NJ_OUT_OF_MEM);
+        if (nj.progressive) {
+            const int blocks = nj.mbwidth * c->ssx * nj.mbheight * c->ssy;
+            if (!(c->coefs = (short*) njAllocMem(blocks * sizeof (short) * 64))) njThrow(NJ_OUT_OF_MEM);
+            njFillMem(c->coefs, 0, blocks * sizeof (short) * 64);
+        }
     }
+    nj.width = (nj.width + mask) >> nj.scale;
+    nj.height = (nj.height + mask) >> nj.scale;
     if (nj.ncomp == 3) {
         nj.rgb = (unsigned char*) njAllocMem(nj.width * nj.height * nj.ncomp);
         if (!nj.rgb) njThrow(NJ_OUT_OF_MEM);
@@ -629,6 +743,7 @@ NJ_INLINE void njDecodeDHT(void) {
 NJ_INLINE void njDecodeDQT(void) {
     int i;
     unsigned char *t;
+    int *q;
     njDecodeLength();
     njCheckError();
     while (nj.length >= 65) {
@@ -636,8 +751,11 @@ NJ_INLINE void njDecodeDQT(void) {
         if (i & 0xFC) njThrow(NJ_SYNTAX_ERROR);
         nj.qtavail |= 1 << i;
         t = &nj.qtab[i][0];
-        for (i = 0;  i < 64;  ++i)
+        q = &nj.qaan[i][0];
+        for (i = 0;  i < 64;  ++i) {
             t[i] = nj.pos[i + 1];
+            q[i] = (t[i] * njAANScale[(int) njZZ[i]] + (1 << (13 - AAN_PASS_BITS))) >> (14 - AAN_PASS_BITS);
+        }
         njSkip(65);
     }
     if (nj.length) njThrow(NJ_SYNTAX_ERROR);
@@ -666,66 +784,271 @@ static int njGetVLC(nj_vlc_code_t* vlc, unsigned char* code) {
     return value;
 }
 
+// Modified: Transforms the dequantized coefficients in nj.block into an
+// (8 >> nj.scale)-pixel square at out.
+NJ_INLINE void njOutputBlock(const nj_component_t* c, unsigned char* out) {
+    int coef;
+    switch (nj.scale) {
+        case 0:
+            for (coef = 0;  coef < 64;  coef += 8)
+                njRowIDCT(&nj.block[coef]);
+            for (coef = 0;  coef < 8;  ++coef)
+                njColIDCT(&nj.block[coef], &out[coef], c->stride);
+            break;
+        case 1:
+            for (coef = 0;  coef < 32;  coef += 8)
+                njRowIDCT4(&nj.block[coef]);
+            for (coef = 0;  coef < 4;  ++coef)
+                njColIDCT4(&nj.block[coef], &out[coef], c->stride);
+            break;
+        case 2:
+            njRowIDCT2(&nj.block[0]);
+            njRowIDCT2(&nj.block[8]);
+            njColIDCT2(&nj.block[0], &out[0], c->stride);
+            njColIDCT2(&nj.block[1], &out[1], c->stride);
+            break;
+        default:
+            *out = njClip(((nj.block[0] + 4) >> 3) + 128);
+    }
+}
+
 NJ_INLINE void njDecodeBlock(nj_component_t* c, unsigned char* out) {
     unsigned char code = 0;
     int value, coef = 0;
+    const unsigned char* q = &nj.qtab[c->qtsel][0];
+    const int* qa = &nj.qaan[c->qtsel][0];
     njFillMem(nj.block, 0, sizeof (nj.block));
     c->dcpred += njGetVLC(&nj.vlctab[c->dctabsel][0], NULL);
-    nj.block[0] = (c->dcpred) * nj.qtab[c->qtsel][0];
+    nj.block[0] = (c->dcpred) * (nj.scale ? q[0] : qa[0]);
     do {
         value = njGetVLC(&nj.vlctab[c->actabsel][0], &code);
         if (!code) break;  // EOB
         if (!(code & 0x0F) && (code != 0xF0)) njThrow(NJ_SYNTAX_ERROR);
         coef += (code >> 4) + 1;
         if (coef > 63) njThrow(NJ_SYNTAX_ERROR);
-        nj.block[(int) njZZ[coef]] = value * nj.qtab[c->qtsel][coef];
+        nj.block[(int) njZZ[coef]] = value * (nj.scale ? q[coef] : qa[coef]);
     } while (coef < 63);
-    for (coef = 0;  coef < 64;  coef += 8)
-        njRowIDCT(&nj.block[coef]);
-    for (coef = 0;  coef < 8;  ++coef)
-        njColIDCT(&nj.block[coef], &out[coef], c->stride);
+    njOutputBlock(c, out);
+}
+
+// Modified: Progressive block decoders (ITU T.81 G.1.2). These only update the
+// coefficients, which are stored unquantized in natural order; DC scans may
+// be interleaved, AC scans always cover a single component.
+NJ_INLINE void njDecodeDCFirst(nj_component_t* c, short* blk) {
+    c->dcpred += njGetVLC(&nj.vlctab[c->dctabsel][0], NULL);
+    blk[0] = (short) (c->dcpred * (1 << nj.al));
+}
+
+NJ_INLINE void njDecodeDCRefine(short* blk) {
+    if (njGetBits(1)) blk[0] |= (short) (1 << nj.al);
+}
+
+static void njDecodeACFirst(nj_component_t* c, short* blk) {
+    unsigned char code;
+    int value, run, k;
+    if (nj.eobrun) {
+        --nj.eobrun;
+        return;
+    }
+    for (k = nj.ss;  k <= nj.se;  ++k) {
+        code = 0;
+        value = njGetVLC(&nj.vlctab[c->actabsel][0], &code);
+        run = code >> 4;
+        if (code & 15) {
+            k += run;
+            if (k > nj.se) njThrow(NJ_SYNTAX_ERROR);
+            blk[(int) njZZ[k]] = (short) (value * (1 << nj.al));
+        } else if (run == 15)
+            k += 15;
+        else {
+            nj.eobrun = (1 << run) - 1;
+            if (run) nj.eobrun += njGetBits(run);
+            break;
+        }
+    }
+}
+
+// Adds one correction bit to a coefficient that is already non-zero.
+NJ_INLINE void njRefineCoef(short* coef) {
+    if (njGetBits(1) && !(*coef & (1 << nj.al)))
+        *coef += (short) ((*coef >= 0) ? (1 << nj.al) : -(1 << nj.al));
+}
+
+static void njDecodeACRefine(nj_component_t* c, short* blk) {
+    unsigned char code;
+    int value, run, k = nj.ss;
+    if (!nj.eobrun) {
+        for (;  k <= nj.se;  ++k) {
+            code = 0;
+            value = njGetVLC(&nj.vlctab[c->actabsel][0], &code);
+            njCheckError();
+            run = code >> 4;
+            if (code & 15) {
+                if ((code & 15) != 1) njThrow(NJ_SYNTAX_ERROR);
+                value = (value > 0) ? (1 << nj.al) : -(1 << nj.al);
+            } else if (run != 15) {
+                nj.eobrun = 1 << run;
+                if (run) nj.eobrun += njGetBits(run);
+                break;
+            }
+            // Skip run zero coefficients, refining non-zero ones on the way.
+            for (;  k <= nj.se;  ++k) {
+                short* coef = &blk[(int) njZZ[k]];
+                if (*coef)
+                    njRefineCoef(coef);
+                else if (--run < 0)
+                    break;
+            }
+            if (value) {
+                if (k > nj.se) njThrow(NJ_SYNTAX_ERROR);
+                blk[(int) njZZ[k]] = (short) value;
+            }
+        }
+    }
+    if (nj.eobrun) {
+        for (;  k <= nj.se;  ++k)
+            if (blk[(int) njZZ[k]])
+                njRefineCoef(&blk[(int) njZZ[k]]);
+        --nj.eobrun;
+    }
+}
+
+NJ_INLINE void njDecodeCoefs(nj_component_t* c, int bx, int by) {
+    short* blk = &c->coefs[(by * nj.mbwidth * c->ssx + bx) << 6];
+    if (!nj.ss) {
+        if (!nj.ah) njDecodeDCFirst(c, blk);
+        else njDecodeDCRefine(blk);
+    } else {
+        if (!nj.ah) njDecodeACFirst(c, blk);
+        else njDecodeACRefine(c, blk);
+    }
+}
+
+// Modified: Reads a restart marker and resets the prediction state.
+static void njRestart(int* nextrst) {
+    int i;
+    njByteAlign();
+    i = njGetBits(16);
+    if (((i & 0xFFF8) != 0xFFD0) || ((i & 7) != *nextrst)) njThrow(NJ_SYNTAX_ERROR);
+    *nextrst = (*nextrst + 1) & 7;
+    for (i = 0;  i < 3;  ++i)
+        nj.comp[i].dcpred = 0;
+    nj.eobrun = 0;
 }
 
 NJ_INLINE void njDecodeScan(void) {
-    int i, mbx, mby, sbx, sby;
+    int i, ns, mbx, mby, sbx, sby;
     int rstcount = nj.rstinterval, nextrst = 0;
     nj_component_t* c;
+    nj_component_t* sc[3];
     njDecodeLength();
     njCheckError();
-    if (nj.length < (4 + 2 * nj.ncomp)) njThrow(NJ_SYNTAX_ERROR);
-    if (nj.pos[0] != nj.ncomp) njThrow(NJ_UNSUPPORTED);
+    if (nj.length < 1) njThrow(NJ_SYNTAX_ERROR);
+    ns = nj.pos[0];
+    if (nj.length < (4 + 2 * ns)) njThrow(NJ_SYNTAX_ERROR);
+    // Modified: Progressive scans may cover any subset of the components.
+    if (nj.progressive ? ((ns < 1) || (ns > nj.ncomp)) : (ns != nj.ncomp)) njThrow(NJ_UNSUPPORTED);
     njSkip(1);
-    for (i = 0, c = nj.comp;  i < nj.ncomp;  ++i, ++c) {
-        if (nj.pos[0] != c->cid) njThrow(NJ_SYNTAX_ERROR);
+    for (i = 0;  i < ns;  ++i) {
+        for (c = nj.comp;  (c < &nj.comp[nj.ncomp]) && (c->cid != nj.pos[0]);  ++c);
+        if (c == &nj.comp[nj.ncomp]) njThrow(NJ_SYNTAX_ERROR);
         if (nj.pos[1] & 0xEE) njThrow(NJ_SYNTAX_ERROR);
         c->dctabsel = nj.pos[1] >> 4;
         c->actabsel = (nj.pos[1] & 1) | 2;
+        sc[i] = c;
         njSkip(2);
     }
-    if (nj.pos[0] || (nj.pos[1] != 63) || nj.pos[2]) njThrow(NJ_UNSUPPORTED);
+    nj.ss = nj.pos[0];
+    nj.se = nj.pos[1];
+    nj.ah = nj.pos[2] >> 4;
+    nj.al = nj.pos[2] & 15;
+    if (!nj.progressive) {
+        if (nj.ss || (nj.se != 63) || nj.pos[2]) njThrow(NJ_UNSUPPORTED);
+    } else if ((nj.ss > nj.se) || (nj.se > 63) || (!nj.ss && nj.se) || (nj.ss && (ns != 1)) || (nj.ah > 13) || (nj.al > 13))
+        njThrow(NJ_SYNTAX_ERROR);
     njSkip(nj.length);
-    for (mbx = mby = 0;;) {
-        for (i = 0, c = nj.comp;  i < nj.ncomp;  ++i, ++c)
-            for (sby = 0;  sby < c->ssy;  ++sby)
-                for (sbx = 0;  sbx < c->ssx;  ++sbx) {
-                    njDecodeBlock(c, &c->pixels[((mby * c->ssy + sby) * c->stride + mbx * c->ssx + sbx) << 3]);
+    if (!nj.progressive) {
+        for (mbx = mby = 0;;) {
+            for (i = 0;  i < ns;  ++i)
+                for (c = sc[i], sby = 0;  sby < c->ssy;  ++sby)
+                    for (sbx = 0;  sbx < c->ssx;  ++sbx) {
+                        njDecodeBlock(c, &c->pixels[((mby * c->ssy + sby) * c->stride + mbx * c->ssx + sbx) << (3 - nj.scale)]);
+                        njCheckError();
+                    }
+            if (++mbx >= nj.mbwidth) {
+                mbx = 0;
+                if (++mby >= nj.mbheight) break;
+            }
+            if (nj.rstinterval && !(--rstcount)) {
+                njRestart(&nextrst);
+                njCheckError();
+                rstcount = nj.rstinterval;
+            }
+        }
+        nj.error = __NJ_FINISHED;
+        return;
+    }
+    // Modified: A progressive scan only updates the stored coefficients. A
+    // single-component scan walks that component's own block grid rather
+    // than the MCUs.
+    for (i = 0;  i < 3;  ++i)
+        nj.comp[i].dcpred = 0;
+    nj.eobrun = 0;
+    if (ns == 1) {
+        c = sc[0];
+        for (mby = 0;  mby < c->bheight;  ++mby)
+            for (mbx = 0;  mbx < c->bwidth;  ++mbx) {
+                if (nj.rstinterval && !(rstcount--)) {
+                    njRestart(&nextrst);
                     njCheckError();
+                    rstcount = nj.rstinterval - 1;
                 }
-        if (++mbx >= nj.mbwidth) {
-            mbx = 0;
-            if (++mby >= nj.mbheight) break;
-        }
-        if (nj.rstinterval && !(--rstcount)) {
-            njByteAlign();
-            i = njGetBits(16);
-            if (((i & 0xFFF8) != 0xFFD0) || ((i & 7) != nextrst)) njThrow(NJ_SYNTAX_ERROR);
-            nextrst = (nextrst + 1) & 7;
-            rstcount = nj.rstinterval;
-            for (i = 0;  i < 3;  ++i)
-                nj.comp[i].dcpred = 0;
-        }
+                njDecodeCoefs(c, mbx, mby);
+                njCheckError();
+            }
+    } else {
+        for (mby = 0;  mby < nj.mbheight;  ++mby)
+            for (mbx = 0;  mbx < nj.mbwidth;  ++mbx) {
+                if (nj.rstinterval && !(rstcount--)) {
+                    njRestart(&nextrst);
+                    njCheckError();
+                    rstcount = nj.rstinterval - 1;
+                }
+                for (i = 0;  i < ns;  ++i)
+                    for (c = sc[i], sby = 0;  sby < c->ssy;  ++sby)
+                        for (sbx = 0;  sbx < c->ssx;  ++sbx) {
+                            njDecodeCoefs(c, mbx * c->ssx + sbx, mby * c->ssy + sby);
+                            njCheckError();
+                        }
+            }
+    }
+    // Skip whatever is left of the entropy-coded data up to the next marker.
+    nj.bufbits = 0;
+    nj.eos = 0;
+    while ((nj.size >= 2) && ((nj.pos[0] != 0xFF) || !nj.pos[1] || (nj.pos[1] == 0xFF) || ((nj.pos[1] & 0xF8) == 0xD0)))
+        njSkip(1);
+}
+
+// Modified: Dequantizes and transforms the coefficients of a progressive
+// image once all of its scans have been read.
+NJ_INLINE void njFinishProgressive(void) {
+    int i, k, bx, by;
+    const short* blk;
+    nj_component_t* c;
+    for (i = 0, c = nj.comp;  i < nj.ncomp;  ++i, ++c) {
+        const unsigned char* q = &nj.qtab[c->qtsel][0];
+        const int* qa = &nj.qaan[c->qtsel][0];
+        blk = c->coefs;
+        for (by = 0;  by < nj.mbheight * c->ssy;  ++by)
+            for (bx = 0;  bx < nj.mbwidth * c->ssx;  ++bx) {
+                for (k = 0;  k < 64;  ++k)
+                    nj.block[(int) njZZ[k]] = blk[(int) njZZ[k]] * (nj.scale ? q[k] : qa[k]);
+                njOutputBlock(c, &c->pixels[(by * c->stride + bx) << (3 - nj.scale)]);
+                blk += 64;
+            }
+        njFreeMem((void*) c->coefs);
+        c->coefs = NULL;
     }
-    nj.error = __NJ_FINISHED;
 }
 
 #if NJ_CHROMA_FILTER
@@ -760,11 +1083,13 @@ NJ_INLINE void njUpsampleH(nj_component_t* c) {
             lout[(x << 1) + 3] = CF(CF4A * lin[x] + CF4B * lin[x + 1] + CF4C * lin[x + 2] + CF4D * lin[x + 3]);
             lout[(x << 1) + 4] = CF(CF4D * lin[x] + CF4C * lin[x + 1] + CF4B * lin[x + 2] + CF4A * lin[x + 3]);
         }
-        lin += c->stride;
+        // Modified: Take the right edge from the last real sample rather
+        // than from the end of the (padded) stride.
         lout += c->width << 1;
-        lout[-3] = CF(CF3A * lin[-1] + CF3B * lin[-2] + CF3C * lin[-3]);
-        lout[-2] = CF(CF3X * lin[-1] + CF3Y * lin[-2] + CF3Z * lin[-3]);
-        lout[-1] = CF(CF2A * lin[-1] + CF2B * lin[-2]);
+        lout[-3] = CF(CF3A * lin[xmax + 2] + CF3B * lin[xmax + 1] + CF3C * lin[xmax]);
+        lout[-2] = CF(CF3X * lin[xmax + 2] + CF3Y * lin[xmax + 1] + CF3Z * lin[xmax]);
+        lout[-1] = CF(CF2A * lin[xmax + 2] + CF2B * lin[xmax + 1]);
+        lin += c->stride;
     }
     c->width <<= 1;
     c->stride = c->width;
@@ -876,15 +1201,34 @@ NJ_INLINE void njConvert(void) {
     }
 }
 
+// Modified: Frees the buffers of the previous image and clears the decoder
+// state, but keeps the VLC tables allocated by njInit().
+static void njReset(void) {
+    int i;
+    nj_vlc_code_t *vlctab[4];
+    for (i = 0;  i < 3;  ++i) {
+        if (nj.comp[i].pixels) njFreeMem((void*) nj.comp[i].pixels);
+        if (nj.comp[i].coefs) njFreeMem((void*) nj.comp[i].coefs);
+    }
+    if (nj.rgb) njFreeMem((void*) nj.rgb);
+    for (i = 0;  i < 4;  ++i)
+        vlctab[i] = nj.vlctab[i];
+    njFillMem(&nj, 0, sizeof (nj_context_t));
+    for (i = 0;  i < 4;  ++i)
+        nj.vlctab[i] = vlctab[i];
+}
+
 // Modified njInit(); uses dynamic assignment of nj.vlctab[i] variable, to
 // avoid a 3x increase in binary size caused by the original static (stack)
-// definition.
+// definition. The tables are only allocated if they are not already there,
+// so calling njInit() again does not leak them.
 // Returns 1 on success, 0 on failure. DO NOT USE SUBSEQUENT FUNCTIONS IF
 // njInit() FAILS!
 int njInit(void) {
     int i, retval = 1;
-    njFillMem(&nj, 0, sizeof (nj_context_t));
+    njReset();
     for (i = 0; i < 4; i++) {
+        if (nj.vlctab[i]) continue;
         nj.vlctab[i] = njAllocMem(sizeof (nj_vlc_code_t) * 65536);
         if (nj.vlctab[i])
             njFillMem(nj.vlctab[i], 0, sizeof (nj_vlc_code_t) * 65536);
@@ -893,7 +1237,7 @@ int njInit(void) {
     } // for
     if (retval == 0) {
         for (i = 0; i < 4; i++) {
-            njFreeMem(nj.vlctab[i]);
+            if (nj.vlctab[i]) njFreeMem(nj.vlctab[i]);
             nj.vlctab[i] = NULL;
         } // for
     } // if
@@ -902,34 +1246,53 @@ int njInit(void) {
 
 // Modified njDone(); uses dynamic assignment of nj.vlctab[i] variable, to
 // avoid a 3x increase in binary size caused by the original static (stack)
-// definition.
+// definition. The tables are released too; njDecode() sets them up again.
 void njDone(void) {
     int i;
-    for (i = 0;  i < 3;  ++i)
-        if (nj.comp[i].pixels) njFreeMem((void*) nj.comp[i].pixels);
-    if (nj.rgb) njFreeMem((void*) nj.rgb);
-    for (i = 0; i < 4; i++)
-        njFreeMem(nj.vlctab[i]);
-    njInit();
+    njReset();
+    for (i = 0; i < 4; i++) {
+        if (nj.vlctab[i]) njFreeMem(nj.vlctab[i]);
+        nj.vlctab[i] = NULL;
+    }
 }
 
 nj_result_t njDecode(const void* jpeg, const int size) {
-    njDone();
+    return njDecodeScaled(jpeg, size, 0);
+}
+
+nj_result_t njDecodeScaled(const void* jpeg, const int size, const int minsize) {
+    if (!njInit()) return NJ_OUT_OF_MEM;
+    nj.minsize = minsize;
     nj.pos = (const unsigned char*) jpeg;
     nj.size = size & 0x7FFFFFFF;
     if (nj.size < 2) return NJ_NO_JPEG;
     if ((nj.pos[0] ^ 0xFF) | (nj.pos[1] ^ 0xD8)) return NJ_NO_JPEG;
     njSkip(2);
     while (!nj.error) {
-        if ((nj.size < 2) || (nj.pos[0] != 0xFF)) return NJ_SYNTAX_ERROR;
+        if ((nj.size < 2) || (nj.pos[0] != 0xFF)) {
+            // Modified: Show what there is of a truncated progressive image.
+            if (nj.progressive && (nj.size < 2)) {
+                nj.error = __NJ_FINISHED;
+                break;
+            }
+            return NJ_SYNTAX_ERROR;
+        }
         njSkip(2);
         switch (nj.pos[-1]) {
-            case 0xC0: njDecodeSOF();  break;
+            case 0xC0:
+            case 0xC1: njDecodeSOF();  break;
+            case 0xC2: nj.progressive = 1;  njDecodeSOF();  break;
             case 0xC4: njDecodeDHT();  break;
             case 0xDB: njDecodeDQT();  break;
             case 0xDD: njDecodeDRI();  break;
             case 0xDA: njDecodeScan(); break;
             case 0xFE: njSkipMarker(); break;
+            case 0xD9:
+                // Modified: EOI ends a progressive image; a baseline image
+                // is complete after its scan and never gets here.
+                if (!nj.progressive) return NJ_SYNTAX_ERROR;
+                nj.error = __NJ_FINISHED;
+                break;
             default:
                 if ((nj.pos[-1] & 0xF0) == 0xE0)
                     njSkipMarker();
@@ -939,6 +1302,7 @@ nj_result_t njDecode(const void* jpeg, const int size) {
     }
     if (nj.error != __NJ_FINISHED) return nj.error;
     nj.error = NJ_OK;
+    if (nj.progressive) njFinishProgressive();
     njConvert();
     return nj.error;
 }
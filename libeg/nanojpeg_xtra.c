@@ -37,50 +37,47 @@
 #define _NJ_INCLUDE_HEADER_ONLY
 #include "nanojpeg.c"
 
-typedef struct _jpeg_color {
-   UINT8 red;
-   UINT8 green;
-   UINT8 blue;
-} jpeg_color;
-
 // Decode JPEG data into something libeg can use. This function is a wrapper around
-// various NanoJPEG functions.
+// various NanoJPEG functions. A non-zero IconSize lets NanoJPEG downscale the image
+// by up to 1/8 while decoding, as long as its larger side stays at least IconSize;
+// the caller's scaler takes care of the rest.
 EG_IMAGE * egDecodeJPEG(IN UINT8 *FileData, IN UINTN FileDataLength, IN UINTN IconSize, IN BOOLEAN WantAlpha) {
-    EG_IMAGE *NewImage = NULL;
-    unsigned Width, Height;
-    jpeg_color *JpegData;
+    EG_IMAGE *NewImage;
+    UINTN Width, Height, Channels;
+    UINT8 *JpegData;
     UINTN i;
     nj_result_t Result;
 
-    if (njInit()) {
-        Result = njDecode((VOID *) FileData, FileDataLength);
-        if (Result != NJ_OK)
-            return NULL;
-
-        Width = njGetWidth();
-        Height = njGetHeight();
+    Result = njDecodeScaled((VOID *) FileData, (int) FileDataLength, (IconSize > 0xFFFF) ? 0xFFFF : (int) IconSize);
+    if (Result != NJ_OK) {
+        njDone();
+        return NULL;
+    }
 
-        // allocate image structure and buffer
-        NewImage = egCreateImage(Width, Height, WantAlpha);
-        if ((NewImage == NULL) || (NewImage->Width != Width) || (NewImage->Height != Height))
-            return NULL;
+    Width = njGetWidth();
+    Height = njGetHeight();
+    Channels = njIsColor() ? 3 : 1;
 
-        JpegData = (jpeg_color *) njGetImage();
+    // allocate image structure and buffer
+    NewImage = egCreateImage(Width, Height, WantAlpha);
+    if (NewImage != NULL) {
+        JpegData = (UINT8 *) njGetImage();
 
         // Annoyingly, EFI and NanoJPEG use different ordering of RGB values in
-        // their pixel data representations, so we must adjust them.
-        for (i = 0; i < (NewImage->Height * NewImage->Width); i++) {
-            NewImage->PixelData[i].r = JpegData[i].red;
-            NewImage->PixelData[i].g = JpegData[i].green;
-            NewImage->PixelData[i].b = JpegData[i].blue;
-            // NB: NanoJPEG does not appear to support alpha/transparency,
-            //     so if requested, set it to be fully opaque.
-            if (WantAlpha)
-                NewImage->PixelData[i].a = 255;
+        // their pixel data representations, so we must adjust them. Grayscale
+        // images have a single channel, which is used for all three.
+        for (i = 0; i < Width * Height; i++, JpegData += Channels) {
+            NewImage->PixelData[i].r = JpegData[0];
+            NewImage->PixelData[i].g = JpegData[Channels / 2];
+            NewImage->PixelData[i].b = JpegData[Channels - 1];
+            // NB: NanoJPEG does not support alpha/transparency, so
+            //     if requested, set it to be fully opaque.
+            NewImage->PixelData[i].a = WantAlpha ? 255 : 0;
         }
-        FreePool(JpegData);
-        njDone();
     }
 
+    // njDone() also frees the buffer returned by njGetImage()
+    njDone();
+
     return NewImage;
 } // EG_IMAGE * egDecodeJPEG()
@@ -1894,6 +1894,303 @@ VOID egSetGraphicsModeEnabled (
 // Drawing to the screen
 //
 
+// While a batch is open, egDrawImage, egDrawImageWithTransparency and
+// egDrawImageOnBase compose into a persistent screen-sized back buffer and
+// record the rectangle they touched, instead of building a temporary image
+// and calling Blt for every draw. Each batched draw rewrites every pixel in
+// its rectangle, so the back buffer never needs to mirror the whole screen.
+// Closing the outermost batch Blts each damaged rectangle once.
+
+#define EG_MAX_DIRTY_RECTS (32)
+
+typedef struct {
+    UINTN  XPos;
+    UINTN  YPos;
+    UINTN  Width;
+    UINTN  Height;
+} EG_RECT;
+
+static
+EG_IMAGE  *egBackBuffer = NULL;
+static
+UINTN      egBatchDepth = 0;
+static
+UINTN      egDirtyCount = 0;
+static
+EG_RECT    egDirtyRects[EG_MAX_DIRTY_RECTS];
+
+static
+VOID egBltArea (
+    IN EG_IMAGE *Image,
+    IN UINTN     AreaPosX,
+    IN UINTN     AreaPosY,
+    IN UINTN     AreaWidth,
+    IN UINTN     AreaHeight,
+    IN UINTN     ScreenPosX,
+    IN UINTN     ScreenPosY
+) {
+    if (GOPDraw != NULL) {
+        REFIT_CALL_10_WRAPPER(
+            GOPDraw->Blt, GOPDraw,
+            (EFI_GRAPHICS_OUTPUT_BLT_PIXEL *) Image->PixelData, EfiBltBufferToVideo,
+            AreaPosX, AreaPosY,
+            ScreenPosX, ScreenPosY,
+            AreaWidth, AreaHeight, Image->Width * 4
+        );
+    }
+    else if (UGADraw != NULL) {
+        REFIT_CALL_10_WRAPPER(
+            UGADraw->Blt, UGADraw,
+            (EFI_UGA_PIXEL *) Image->PixelData, EfiUgaBltBufferToVideo,
+            AreaPosX, AreaPosY,
+            ScreenPosX, ScreenPosY,
+            AreaWidth, AreaHeight, Image->Width * 4
+        );
+    }
+} // static VOID egBltArea()
+
+// Sends the damaged parts of the back buffer to the screen. Also called
+// before anything reads or writes the screen directly, so that direct
+// access stays ordered with batched draws.
+static
+VOID egFlushDirtyRects (VOID) {
+    UINTN i;
+
+    for (i = 0; i < egDirtyCount; i++) {
+        egBltArea (
+            egBackBuffer,
+            egDirtyRects[i].XPos,  egDirtyRects[i].YPos,
+            egDirtyRects[i].Width, egDirtyRects[i].Height,
+            egDirtyRects[i].XPos,  egDirtyRects[i].YPos
+        );
+    }
+    egDirtyCount = 0;
+} // static VOID egFlushDirtyRects()
+
+static
+BOOLEAN egRectContains (
+    IN EG_RECT *Outer,
+    IN EG_RECT *Inner
+) {
+    return (
+        Inner->XPos >= Outer->XPos &&
+        Inner->YPos >= Outer->YPos &&
+        Inner->XPos + Inner->Width  <= Outer->XPos + Outer->Width &&
+        Inner->YPos + Inner->Height <= Outer->YPos + Outer->Height
+    );
+} // static BOOLEAN egRectContains()
+
+// Records a damaged area. Rectangles are not merged into larger ones, as
+// the back buffer is only current inside areas that were actually drawn,
+// but areas already covered by a recorded rectangle are dropped.
+static
+VOID egAddDirtyRect (
+    IN UINTN XPos,
+    IN UINTN YPos,
+    IN UINTN Width,
+    IN UINTN Height
+) {
+    UINTN   i;
+    EG_RECT Rect;
+
+    Rect.XPos   = XPos;
+    Rect.YPos   = YPos;
+    Rect.Width  = Width;
+    Rect.Height = Height;
+
+    i = 0;
+    while (i < egDirtyCount) {
+        if (egRectContains (&egDirtyRects[i], &Rect)) {
+            return;
+        }
+
+        if (egRectContains (&Rect, &egDirtyRects[i])) {
+            egDirtyRects[i] = egDirtyRects[--egDirtyCount];
+            continue;
+        }
+
+        i++;
+    }
+
+    if (egDirtyCount == EG_MAX_DIRTY_RECTS) {
+        egFlushDirtyRects();
+    }
+    egDirtyRects[egDirtyCount++] = Rect;
+} // static VOID egAddDirtyRect()
+
+// Returns TRUE if a batch is open and the given screen area can be drawn
+// into the back buffer, creating or resizing the back buffer as needed.
+static
+BOOLEAN egBatchReady (
+    IN UINTN XPos,
+    IN UINTN YPos,
+    IN UINTN Width,
+    IN UINTN Height
+) {
+    if (egBatchDepth == 0 || !egHasGraphics) {
+        return FALSE;
+    }
+
+    if (XPos > egScreenWidth  || Width  > egScreenWidth  - XPos ||
+        YPos > egScreenHeight || Height > egScreenHeight - YPos
+    ) {
+        return FALSE;
+    }
+
+    if (egBackBuffer != NULL &&
+        (egBackBuffer->Width != egScreenWidth || egBackBuffer->Height != egScreenHeight)
+    ) {
+        egFlushDirtyRects();
+        MY_FREE_IMAGE(egBackBuffer);
+    }
+
+    if (egBackBuffer == NULL) {
+        egBackBuffer = egCreateImage (egScreenWidth, egScreenHeight, FALSE);
+    }
+
+    return (egBackBuffer != NULL);
+} // static BOOLEAN egBatchReady()
+
+// Copies the screen background into an area of the back buffer.
+// Returns FALSE, leaving the back buffer untouched, if the area is not
+// covered by the background.
+static
+BOOLEAN egRestoreBackground (
+    IN UINTN XPos,
+    IN UINTN YPos,
+    IN UINTN Width,
+    IN UINTN Height
+) {
+    UINTN     y;
+    EG_IMAGE *Background = GlobalConfig.ScreenBackground;
+
+    if (Background == NULL ||
+        XPos + Width  > Background->Width ||
+        YPos + Height > Background->Height
+    ) {
+        return FALSE;
+    }
+
+    for (y = 0; y < Height; y++) {
+        CopyMem (
+            egBackBuffer->PixelData + (YPos + y) * egBackBuffer->Width + XPos,
+            Background->PixelData   + (YPos + y) * Background->Width   + XPos,
+            Width * sizeof (EG_PIXEL)
+        );
+    }
+
+    return TRUE;
+} // static BOOLEAN egRestoreBackground()
+
+// Composes Image into the back buffer at (PosX, PosY), clipped to at most
+// MaxWidth x MaxHeight pixels.
+static
+VOID egBackBufferCompose (
+    IN EG_IMAGE *Image,
+    IN UINTN     PosX,
+    IN UINTN     PosY,
+    IN UINTN     MaxWidth,
+    IN UINTN     MaxHeight
+) {
+    UINTN Width  = (Image->Width  < MaxWidth)  ? Image->Width  : MaxWidth;
+    UINTN Height = (Image->Height < MaxHeight) ? Image->Height : MaxHeight;
+
+    egRestrictImageArea (egBackBuffer, PosX, PosY, &Width, &Height);
+    if (Width == 0 || Height == 0) {
+        return;
+    }
+
+    if (Image->HasAlpha) {
+        egRawCompose (
+            egBackBuffer->PixelData + PosY * egBackBuffer->Width + PosX,
+            Image->PixelData,
+            Width, Height,
+            egBackBuffer->Width, Image->Width
+        );
+    }
+    else {
+        egRawCopy (
+            egBackBuffer->PixelData + PosY * egBackBuffer->Width + PosX,
+            Image->PixelData,
+            Width, Height,
+            egBackBuffer->Width, Image->Width
+        );
+    }
+} // static VOID egBackBufferCompose()
+
+// Draws the background, then BaseImage if given, then Image centred in the
+// area with BadgeImage near its lower right corner. The layout matches
+// BltImageCompositeBadge().
+static
+VOID egBackBufferComposeLayers (
+    IN EG_IMAGE *BaseImage  OPTIONAL,
+    IN EG_IMAGE *Image      OPTIONAL,
+    IN EG_IMAGE *BadgeImage OPTIONAL,
+    IN UINTN     XPos,
+    IN UINTN     YPos,
+    IN UINTN     Width,
+    IN UINTN     Height
+) {
+    UINTN CompWidth  = 0;
+    UINTN CompHeight = 0;
+    UINTN OffsetX    = 0;
+    UINTN OffsetY    = 0;
+
+    if (!egRestoreBackground (XPos, YPos, Width, Height)) {
+        return;
+    }
+
+    if (BaseImage != NULL) {
+        egBackBufferCompose (BaseImage, XPos, YPos, Width, Height);
+    }
+
+    if (Image != NULL) {
+        CompWidth  = (Image->Width  < Width)  ? Image->Width  : Width;
+        CompHeight = (Image->Height < Height) ? Image->Height : Height;
+        OffsetX    = (Width  - CompWidth)  >> 1;
+        OffsetY    = (Height - CompHeight) >> 1;
+        egBackBufferCompose (Image, XPos + OffsetX, YPos + OffsetY, CompWidth, CompHeight);
+    }
+
+    if (BadgeImage != NULL &&
+        (BadgeImage->Width  + 8) < CompWidth &&
+        (BadgeImage->Height + 8) < CompHeight
+    ) {
+        OffsetX += CompWidth  - 8 - BadgeImage->Width;
+        OffsetY += CompHeight - 8 - BadgeImage->Height;
+        egBackBufferCompose (
+            BadgeImage,
+            XPos + OffsetX, YPos + OffsetY,
+            BadgeImage->Width, BadgeImage->Height
+        );
+    }
+
+    egAddDirtyRect (XPos, YPos, Width, Height);
+} // static VOID egBackBufferComposeLayers()
+
+// Opens a batch of screen updates. Batches nest; drawing reaches the
+// screen when the outermost batch is closed with egEndScreenBatch().
+VOID egBeginScreenBatch (VOID) {
+    egBatchDepth++;
+} // VOID egBeginScreenBatch()
+
+VOID egEndScreenBatch (VOID) {
+    if (egBatchDepth == 0) {
+        return;
+    }
+
+    egBatchDepth--;
+    if (egBatchDepth == 0) {
+        egFlushDirtyRects();
+    }
+} // VOID egEndScreenBatch()
+
+// Releases the back buffer. Any pending updates are sent to the screen first.
+VOID egFreeBackBuffer (VOID) {
+    egFlushDirtyRects();
+    MY_FREE_IMAGE(egBackBuffer);
+} // VOID egFreeBackBuffer()
+
 VOID egClearScreen (
     IN EG_PIXEL *Color
 ) {
@@ -1935,6 +2232,9 @@ VOID egClearScreen (
     }
     FillColor.Reserved = 0;
 
+    // Pending batched updates would only be painted over
+    egDirtyCount = 0;
+
     BREAD_CRUMB(L"%s:  3", FuncTag);
     if (GOPDraw != NULL) {
         BREAD_CRUMB(L"%s:  3a 1 - (Apply Fill via GOP)", FuncTag);
@@ -1985,6 +2285,35 @@ VOID egDrawImage (
         return;
     }
 
+    if (egBatchReady (ScreenPosX, ScreenPosY, Image->Width, Image->Height)) {
+        if ((GlobalConfig.ScreenBackground == NULL) ||
+            (GlobalConfig.ScreenBackground == Image) ||
+            ((Image->Width == egScreenWidth) && (Image->Height == egScreenHeight))
+        ) {
+            egRawCopy (
+                egBackBuffer->PixelData + ScreenPosY * egBackBuffer->Width + ScreenPosX,
+                Image->PixelData,
+                Image->Width, Image->Height,
+                egBackBuffer->Width, Image->Width
+            );
+        }
+        else {
+            if (!egRestoreBackground (ScreenPosX, ScreenPosY, Image->Width, Image->Height)) {
+                #if REFIT_DEBUG > 0
+                LOG_MSG("Error! Cannot Crop Image in egDrawImage()!\n");
+                #endif
+
+                return;
+            }
+
+            egBackBufferCompose (Image, ScreenPosX, ScreenPosY, Image->Width, Image->Height);
+        }
+
+        egAddDirtyRect (ScreenPosX, ScreenPosY, Image->Width, Image->Height);
+
+        return;
+    }
+
     if ((GlobalConfig.ScreenBackground == NULL) ||
         ((Image->Width == egScreenWidth) && (Image->Height == egScreenHeight))
     ) {
@@ -2013,24 +2342,12 @@ VOID egDrawImage (
        SetImage = TRUE;
     }
 
-    if (GOPDraw != NULL) {
-        REFIT_CALL_10_WRAPPER(
-            GOPDraw->Blt, GOPDraw,
-            (EFI_GRAPHICS_OUTPUT_BLT_PIXEL *) CompImage->PixelData, EfiBltBufferToVideo,
-            0, 0,
-            ScreenPosX, ScreenPosY,
-            CompImage->Width, CompImage->Height, 0
-        );
-    }
-    else if (UGADraw != NULL) {
-        REFIT_CALL_10_WRAPPER(
-            UGADraw->Blt, UGADraw,
-            (EFI_UGA_PIXEL *) CompImage->PixelData, EfiUgaBltBufferToVideo,
-            0, 0,
-            ScreenPosX, ScreenPosY,
-            CompImage->Width, CompImage->Height, 0
-        );
-    }
+    egBltArea (
+        CompImage,
+        0, 0,
+        CompImage->Width, CompImage->Height,
+        ScreenPosX, ScreenPosY
+    );
 
     if (SetImage) {
         MY_FREE_IMAGE(CompImage);
@@ -2050,6 +2367,20 @@ VOID egDrawImageWithTransparency (
 ) {
     EG_IMAGE *Background;
 
+    if (GlobalConfig.ScreenBackground == NULL) {
+        // Early Return
+        return;
+    }
+
+    if (!GlobalConfig.ScreenBackground->HasAlpha &&
+        egBatchReady (XPos, YPos, Width, Height)
+    ) {
+        egBackBufferComposeLayers (NULL, Image, BadgeImage, XPos, YPos, Width, Height);
+
+        // Early Return
+        return;
+    }
+
     Background = egCropImage (
         GlobalConfig.ScreenBackground,
         XPos, YPos,
@@ -2066,6 +2397,33 @@ VOID egDrawImageWithTransparency (
     }
 } // VOID DrawImageWithTransparency()
 
+// Draws BaseImage over the screen background, with Image and BadgeImage
+// placed on top as by egDrawImageWithTransparency(). This is only done
+// inside a screen batch; returns FALSE, having drawn nothing, otherwise.
+BOOLEAN egDrawImageOnBase (
+    IN EG_IMAGE *BaseImage,
+    IN EG_IMAGE *Image      OPTIONAL,
+    IN EG_IMAGE *BadgeImage OPTIONAL,
+    IN UINTN     XPos,
+    IN UINTN     YPos
+) {
+    if (BaseImage == NULL ||
+        GlobalConfig.ScreenBackground == NULL ||
+        GlobalConfig.ScreenBackground->HasAlpha ||
+        !egBatchReady (XPos, YPos, BaseImage->Width, BaseImage->Height)
+    ) {
+        return FALSE;
+    }
+
+    egBackBufferComposeLayers (
+        BaseImage, Image, BadgeImage,
+        XPos, YPos,
+        BaseImage->Width, BaseImage->Height
+    );
+
+    return TRUE;
+} // BOOLEAN egDrawImageOnBase()
+
 VOID egDrawImageArea (
     IN EG_IMAGE *Image,
     IN UINTN     AreaPosX,
@@ -2089,24 +2447,13 @@ VOID egDrawImageArea (
         return;
     }
 
-    if (GOPDraw != NULL) {
-        REFIT_CALL_10_WRAPPER(
-            GOPDraw->Blt, GOPDraw,
-            (EFI_GRAPHICS_OUTPUT_BLT_PIXEL *) Image->PixelData, EfiBltBufferToVideo,
-            AreaPosX, AreaPosY,
-            ScreenPosX, ScreenPosY,
-            AreaWidth, AreaHeight, Image->Width * 4
-        );
-    }
-    else if (UGADraw != NULL) {
-        REFIT_CALL_10_WRAPPER(
-            UGADraw->Blt, UGADraw,
-            (EFI_UGA_PIXEL *) Image->PixelData, EfiUgaBltBufferToVideo,
-            AreaPosX, AreaPosY,
-            ScreenPosX, ScreenPosY,
-            AreaWidth, AreaHeight, Image->Width * 4
-        );
-    }
+    egFlushDirtyRects();
+    egBltArea (
+        Image,
+        AreaPosX, AreaPosY,
+        AreaWidth, AreaHeight,
+        ScreenPosX, ScreenPosY
+    );
 } // VOID egDrawImageArea()
 
 static
@@ -2223,6 +2570,9 @@ EG_IMAGE * egCopyScreenArea (
       return NULL;
    }
 
+   // Make sure batched updates have reached the screen
+   egFlushDirtyRects();
+
    // Get full screen image
    if (GOPDraw != NULL) {
        REFIT_CALL_10_WRAPPER(
@@ -0,0 +1,111 @@
+/*
+ * libeg/test/efi/efi.h
+ * Minimal stand-in for the GNU-EFI header, enough to build libeg/image.c
+ * on the host. Only the types and fields that image.c uses are declared.
+ *
+ * This program is licensed under the terms of the GNU GPL, version 3,
+ * or (at your option) any later version.
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __LIBEG_TEST_EFI_H__
+#define __LIBEG_TEST_EFI_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define IN
+#define OUT
+#define OPTIONAL
+#define CONST const
+#define EFIAPI
+
+typedef void      VOID;
+typedef uint8_t   UINT8;
+typedef uint16_t  UINT16;
+typedef uint32_t  UINT32;
+typedef uint64_t  UINT64;
+typedef int8_t    INT8;
+typedef int16_t   INT16;
+typedef int32_t   INT32;
+typedef int64_t   INT64;
+typedef uintptr_t UINTN;
+typedef intptr_t  INTN;
+typedef uint8_t   BOOLEAN;
+typedef char      CHAR8;
+typedef uint16_t  CHAR16;
+
+#ifndef TRUE
+#define TRUE  ((BOOLEAN) 1)
+#define FALSE ((BOOLEAN) 0)
+#endif
+
+typedef UINTN  EFI_STATUS;
+typedef VOID  *EFI_HANDLE;
+
+#define EFI_ERROR_BIT          ((UINTN) 1 << (sizeof (UINTN) * 8 - 1))
+#define EFI_ERROR(Status)      (((INTN) (Status)) < 0)
+#define EFI_SUCCESS            0
+#define EFI_INVALID_PARAMETER  (EFI_ERROR_BIT | 2)
+#define EFI_UNSUPPORTED        (EFI_ERROR_BIT | 3)
+#define EFI_BUFFER_TOO_SMALL   (EFI_ERROR_BIT | 5)
+#define EFI_OUT_OF_RESOURCES   (EFI_ERROR_BIT | 9)
+#define EFI_NOT_FOUND          (EFI_ERROR_BIT | 14)
+
+typedef struct {
+    UINT32  Data1;
+    UINT16  Data2;
+    UINT16  Data3;
+    UINT8   Data4[8];
+} EFI_GUID;
+
+typedef struct {
+    UINT16  Year;
+    UINT8   Month;
+    UINT8   Day;
+    UINT8   Hour;
+    UINT8   Minute;
+    UINT8   Second;
+    UINT8   Pad1;
+    UINT32  Nanosecond;
+    INT16   TimeZone;
+    UINT8   Daylight;
+    UINT8   Pad2;
+} EFI_TIME;
+
+typedef enum {
+    AllHandles,
+    ByRegisterNotify,
+    ByProtocol
+} EFI_LOCATE_SEARCH_TYPE;
+
+#define EFI_FILE_MODE_READ    0x0000000000000001ULL
+#define EFI_FILE_MODE_WRITE   0x0000000000000002ULL
+#define EFI_FILE_MODE_CREATE  0x8000000000000000ULL
+#define EFI_FILE_DIRECTORY    0x0000000000000010ULL
+
+typedef struct {
+    UINT64    Size;
+    UINT64    FileSize;
+    UINT64    PhysicalSize;
+    EFI_TIME  CreateTime;
+    EFI_TIME  LastAccessTime;
+    EFI_TIME  ModificationTime;
+    UINT64    Attribute;
+    CHAR16    FileName[1];
+} EFI_FILE_INFO;
+
+typedef struct _EFI_FILE  EFI_FILE;
+typedef EFI_FILE         *EFI_FILE_HANDLE;
+
+struct _EFI_FILE {
+    UINT64       Revision;
+    EFI_STATUS (*Open)     (EFI_FILE *File, EFI_FILE **NewHandle, CHAR16 *FileName, UINT64 OpenMode, UINT64 Attributes);
+    EFI_STATUS (*Close)    (EFI_FILE *File);
+    EFI_STATUS (*Delete)   (EFI_FILE *File);
+    EFI_STATUS (*Read)     (EFI_FILE *File, UINTN *BufferSize, VOID *Buffer);
+    EFI_STATUS (*Write)    (EFI_FILE *File, UINTN *BufferSize, VOID *Buffer);
+};
+
+#endif /* __LIBEG_TEST_EFI_H__ */
@@ -0,0 +1,39 @@
+/*
+ * libeg/test/efi/efilib.h
+ * Minimal stand-in for the GNU-EFI library header. The memory functions
+ * are implemented with libc in imagetest.c; the rest are never reached.
+ *
+ * This program is licensed under the terms of the GNU GPL, version 3,
+ * or (at your option) any later version.
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __LIBEG_TEST_EFILIB_H__
+#define __LIBEG_TEST_EFILIB_H__
+
+#include "efi.h"
+
+VOID * AllocatePool (IN UINTN Size);
+VOID * AllocateZeroPool (IN UINTN Size);
+VOID * AllocateCopyPool (IN UINTN Size, IN CONST VOID *Buffer);
+VOID   FreePool (IN VOID *Buffer);
+VOID   CopyMem (OUT VOID *Dest, IN CONST VOID *Src, IN UINTN Size);
+VOID   SetMem (OUT VOID *Buffer, IN UINTN Size, IN UINT8 Value);
+VOID   ZeroMem (OUT VOID *Buffer, IN UINTN Size);
+INTN   CompareMem (IN CONST VOID *Dest, IN CONST VOID *Src, IN UINTN Size);
+UINTN  StrLen (IN CONST CHAR16 *String);
+UINTN  Print (IN CONST CHAR16 *Format, ...);
+CHAR16 * PoolPrint (IN CONST CHAR16 *Format, ...);
+
+EFI_FILE_INFO * LibFileInfo (IN EFI_FILE_HANDLE FHand);
+EFI_FILE_HANDLE LibOpenRoot (IN EFI_HANDLE DeviceHandle);
+EFI_STATUS      LibLocateHandle (
+    IN  EFI_LOCATE_SEARCH_TYPE   SearchType,
+    IN  EFI_GUID                *Protocol OPTIONAL,
+    IN  VOID                    *SearchKey OPTIONAL,
+    OUT UINTN                   *NoHandles,
+    OUT EFI_HANDLE             **Buffer
+);
+
+#endif /* __LIBEG_TEST_EFILIB_H__ */
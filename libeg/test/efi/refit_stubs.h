@@ -0,0 +1,83 @@
+/*
+ * libeg/test/efi/refit_stubs.h
+ * Stands in for the BootMaster headers that libeg/image.c includes, so that
+ * image.c can be built on the host. Included ahead of image.c with -include;
+ * it defines their include guards and declares only what image.c uses.
+ *
+ * This program is licensed under the terms of the GNU GPL, version 3,
+ * or (at your option) any later version.
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __LIBEG_TEST_REFIT_STUBS_H__
+#define __LIBEG_TEST_REFIT_STUBS_H__
+
+#include <efi.h>
+#include <efilib.h>
+
+#define uefi_call_wrapper(f, n, ...) f(__VA_ARGS__)
+
+#include "../../../BootMaster/rp_funcs.h"
+#include "../../libeg.h"
+
+// BootMaster/global.h
+#define __GLOBAL_H_
+
+#define DEFAULT_ICONS_DIR  L"icons"
+#define ESP_GUID_VALUE     {0xC12A7328, 0xF81F, 0x11D2, {0xBA, 0x4B, 0x00, 0xA0, 0xC9, 0x3E, 0xC9, 0x3B}};
+#define MY_OFFSET_OF(st, m) ((UINTN)((char *) &((st *)0x100000)->m - (char *)0x100000))
+
+#define PROF_END(...)
+#define PROF_BEGIN(...)
+#define ALT_LOG(...)
+#define LOG_SEP(...)
+#define BREAD_CRUMB(...)
+#define LOG_INCREMENT(...)
+#define LOG_DECREMENT(...)
+
+typedef struct {
+    BOOLEAN  DirectBoot;
+    CHAR16  *IconsDir;
+} REFIT_CONFIG;
+
+extern REFIT_CONFIG  GlobalConfig;
+extern EFI_FILE     *SelfDir;
+extern UINT64        ReadWriteCreate;
+
+// BootMaster/lib.h
+#define __LIB_H_
+
+typedef struct {
+    EFI_STATUS  LastStatus;
+} REFIT_DIR_ITER;
+
+VOID DirIterOpen (
+    IN  EFI_FILE       *BaseDir,
+    IN  CHAR16         *RelativePath OPTIONAL,
+    OUT REFIT_DIR_ITER *DirIter
+);
+BOOLEAN DirIterNext (
+    IN  OUT REFIT_DIR_ITER  *DirIter,
+    IN      UINTN            FilterMode,
+    IN      CHAR16          *FilePattern OPTIONAL,
+    OUT     EFI_FILE_INFO  **DirEntry
+);
+EFI_STATUS DirIterClose (IN OUT REFIT_DIR_ITER *DirIter);
+
+// BootMaster/screenmgt.h
+#define __SCREEN_H_
+
+extern BOOLEAN  AllowGraphicsMode;
+
+// BootMaster/mystrings.h
+#define __MYSTRINGS_H_
+
+BOOLEAN  MyStriCmp (IN const CHAR16 *String1, IN const CHAR16 *String2);
+CHAR16 * StrDuplicate (IN CONST CHAR16 *Src);
+CHAR16 * FindCommaDelimited (IN CHAR16 *InString, IN UINTN Index);
+
+// libeg/lodepng.h ... Only its decoder is referenced, through egDecodePNG
+#define LODEPNG_H
+
+#endif /* __LIBEG_TEST_REFIT_STUBS_H__ */
@@ -0,0 +1,407 @@
+/*
+ * libeg/test/imagetest.c
+ * Host test and benchmark for egScaleImage in libeg/image.c
+ *
+ * image.c is built against the stub headers in 'efi'. Each test case scales
+ * a generated image and checks the result two ways. It must be within
+ * ScaleDiffLimit levels of an exact floating point bilinear or area average
+ * reference, and it must match the golden output in 'scale' exactly, so that
+ * any change to the fixed point arithmetic shows up. Run with 'update' to
+ * rewrite the golden outputs after an intended change, or with 'bench' to
+ * time typical screen sized scales.
+ *
+ * This program is licensed under the terms of the GNU GPL, version 3,
+ * or (at your option) any later version.
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "efi/refit_stubs.h"
+
+// Largest difference from the exact reference, in levels
+#define ScaleDiffLimit  2
+
+typedef struct {
+    const char *Name;
+    UINTN       SrcWidth, SrcHeight;
+    UINTN       DstWidth, DstHeight;
+} SCALE_CASE;
+
+static const SCALE_CASE ScaleCases[] = {
+    { "up",        37, 23, 100, 61 },   // Bilinear enlargement
+    { "mild",      37, 23,  25, 17 },   // Bilinear reduction below 2x
+    { "area3",     36, 24,  12,  8 },   // Area average, whole ratio
+    { "area_frac", 37, 23,  12,  7 },   // Area average, fractional ratio
+    { "mixed",     37, 23,  80, 10 },   // Bilinear across, area average down
+    { "row",       40,  1,  13,  1 },   // Single row source
+};
+
+static const char *DataDir = "scale";
+static int         Failures;
+
+//
+// Functions that image.c links against. Memory handling uses libc, and the
+// file, directory and decoder functions are never reached by these tests.
+//
+
+BOOLEAN       gKernelStarted    = FALSE;
+BOOLEAN       AllowGraphicsMode = TRUE;
+REFIT_CONFIG  GlobalConfig;
+EFI_FILE     *SelfDir           = NULL;
+UINT64        ReadWriteCreate   = EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE | EFI_FILE_MODE_CREATE;
+
+VOID * AllocatePool (IN UINTN Size)                          { return malloc (Size ? Size : 1); }
+VOID * AllocateZeroPool (IN UINTN Size)                      { return calloc (1, Size ? Size : 1); }
+VOID   FreePool (IN VOID *Buffer)                            { free (Buffer); }
+VOID   CopyMem (OUT VOID *Dest, IN CONST VOID *Src, IN UINTN Size) { memmove (Dest, Src, Size); }
+VOID   SetMem (OUT VOID *Buffer, IN UINTN Size, IN UINT8 Value)    { memset (Buffer, Value, Size); }
+VOID   ZeroMem (OUT VOID *Buffer, IN UINTN Size)             { memset (Buffer, 0, Size); }
+INTN   CompareMem (IN CONST VOID *Dest, IN CONST VOID *Src, IN UINTN Size) { return memcmp (Dest, Src, Size); }
+
+VOID * AllocateCopyPool (IN UINTN Size, IN CONST VOID *Buffer) {
+    VOID *Copy = AllocatePool (Size);
+
+    if (Copy != NULL) {
+        memcpy (Copy, Buffer, Size);
+    }
+
+    return Copy;
+}
+
+UINTN StrLen (IN CONST CHAR16 *String) {
+    UINTN Length = 0;
+
+    while (String[Length] != 0) {
+        Length++;
+    }
+
+    return Length;
+}
+
+CHAR16 * StrDuplicate (IN CONST CHAR16 *Src) {
+    return AllocateCopyPool ((StrLen (Src) + 1) * sizeof (CHAR16), Src);
+}
+
+BOOLEAN MyStriCmp (IN const CHAR16 *String1, IN const CHAR16 *String2) {
+    return FALSE;
+}
+
+CHAR16 * FindCommaDelimited (IN CHAR16 *InString, IN UINTN Index)  { return NULL; }
+UINTN    Print (IN CONST CHAR16 *Format, ...)                      { return 0; }
+CHAR16 * PoolPrint (IN CONST CHAR16 *Format, ...)                  { return NULL; }
+
+EFI_FILE_INFO * LibFileInfo (IN EFI_FILE_HANDLE FHand)             { return NULL; }
+EFI_FILE_HANDLE LibOpenRoot (IN EFI_HANDLE DeviceHandle)           { return NULL; }
+
+EFI_STATUS LibLocateHandle (
+    IN  EFI_LOCATE_SEARCH_TYPE   SearchType,
+    IN  EFI_GUID                *Protocol OPTIONAL,
+    IN  VOID                    *SearchKey OPTIONAL,
+    OUT UINTN                   *NoHandles,
+    OUT EFI_HANDLE             **Buffer
+) {
+    return EFI_NOT_FOUND;
+}
+
+VOID DirIterOpen (
+    IN  EFI_FILE       *BaseDir,
+    IN  CHAR16         *RelativePath OPTIONAL,
+    OUT REFIT_DIR_ITER *DirIter
+) {
+    DirIter->LastStatus = EFI_NOT_FOUND;
+}
+
+BOOLEAN DirIterNext (
+    IN  OUT REFIT_DIR_ITER  *DirIter,
+    IN      UINTN            FilterMode,
+    IN      CHAR16          *FilePattern OPTIONAL,
+    OUT     EFI_FILE_INFO  **DirEntry
+) {
+    return FALSE;
+}
+
+EFI_STATUS DirIterClose (IN OUT REFIT_DIR_ITER *DirIter) { return DirIter->LastStatus; }
+
+EG_IMAGE * egDecodeBMP (IN UINT8 *FileData, IN UINTN FileDataLength, IN UINTN IconSize, IN BOOLEAN WantAlpha)  { return NULL; }
+EG_IMAGE * egDecodeICNS (IN UINT8 *FileData, IN UINTN FileDataLength, IN UINTN IconSize, IN BOOLEAN WantAlpha) { return NULL; }
+EG_IMAGE * egDecodeJPEG (IN UINT8 *FileData, IN UINTN FileDataLength, IN UINTN IconSize, IN BOOLEAN WantAlpha) { return NULL; }
+EG_IMAGE * egDecodePNG (IN UINT8 *FileData, IN UINTN FileDataLength, IN UINTN IconSize, IN BOOLEAN WantAlpha)  { return NULL; }
+
+VOID egDecompressIcnsRLE (
+    IN OUT UINT8 **CompData,
+    IN OUT UINTN  *CompLen,
+    IN     UINT8  *DestPlanePtr,
+    IN     UINTN   PixelCount
+) {
+}
+
+//
+// Test images and references
+//
+
+// Smooth gradients with hard edges and a little noise in every channel,
+// including alpha, so that lane carries and edge handling both show up
+static EG_IMAGE * MakeSource (UINTN Width, UINTN Height) {
+    EG_IMAGE  *Image;
+    EG_PIXEL  *Pixel;
+    UINTN      x, y;
+    UINT32     Seed = 12345;
+
+    Image = egCreateImage (Width, Height, TRUE);
+    if (Image == NULL) {
+        return NULL;
+    }
+
+    Pixel = Image->PixelData;
+    for (y = 0; y < Height; y++) {
+        for (x = 0; x < Width; x++, Pixel++) {
+            Seed     = Seed * 1103515245 + 12345;
+            Pixel->b = (UINT8) ((x * 255) / (Width > 1 ? Width - 1 : 1));
+            Pixel->g = (UINT8) ((y * 255) / (Height > 1 ? Height - 1 : 1));
+            Pixel->r = ((x / 5 + y / 3) & 1) ? 240 : 15;
+            Pixel->a = (UINT8) (128 + (INT32) ((Seed >> 16) % 255) / 2 - 63);
+        }
+    }
+
+    return Image;
+}
+
+// Weights of each source sample for output sample i along one axis, in the
+// way egBuildScaleFilter describes them, but exact
+static void ReferenceWeights (UINTN SrcSize, UINTN DstSize, UINTN i, double *Weights) {
+    double Lo, Hi, Pos, Frac;
+    UINTN  s;
+
+    memset (Weights, 0, SrcSize * sizeof (double));
+    if (SrcSize == DstSize) {
+        Weights[i] = 1.0;
+    }
+    else if (SrcSize >= DstSize * 2) {
+        Lo = (double) i * SrcSize / DstSize;
+        Hi = (double) (i + 1) * SrcSize / DstSize;
+        for (s = 0; s < SrcSize; s++) {
+            double PixLo = (s > Lo) ? s : Lo;
+            double PixHi = (s + 1 < Hi) ? s + 1 : Hi;
+            if (PixHi > PixLo) {
+                Weights[s] = (PixHi - PixLo) * DstSize / SrcSize;
+            }
+        }
+    }
+    else {
+        Pos  = (double) i * (SrcSize - 1) / DstSize;
+        s    = (UINTN) Pos;
+        Frac = Pos - s;
+        Weights[s] = 1.0 - Frac;
+        if (Frac > 0) {
+            Weights[s + 1] = Frac;
+        }
+    }
+}
+
+static EG_IMAGE * ReferenceScale (EG_IMAGE *Src, UINTN DstWidth, UINTN DstHeight) {
+    EG_IMAGE  *Dst;
+    double    *WeightX, *WeightY, Sum[4];
+    UINT8     *Pixel;
+    UINTN      x, y, sx, sy, c;
+
+    Dst     = egCreateImage (DstWidth, DstHeight, Src->HasAlpha);
+    WeightX = malloc (Src->Width  * sizeof (double));
+    WeightY = malloc (Src->Height * sizeof (double));
+
+    for (y = 0; y < DstHeight; y++) {
+        ReferenceWeights (Src->Height, DstHeight, y, WeightY);
+        for (x = 0; x < DstWidth; x++) {
+            ReferenceWeights (Src->Width, DstWidth, x, WeightX);
+            memset (Sum, 0, sizeof (Sum));
+            for (sy = 0; sy < Src->Height; sy++) {
+                if (WeightY[sy] == 0) {
+                    continue;
+                }
+                for (sx = 0; sx < Src->Width; sx++) {
+                    if (WeightX[sx] == 0) {
+                        continue;
+                    }
+                    Pixel = (UINT8 *) &Src->PixelData[sy * Src->Width + sx];
+                    for (c = 0; c < 4; c++) {
+                        Sum[c] += WeightX[sx] * WeightY[sy] * Pixel[c];
+                    }
+                }
+            }
+            Pixel = (UINT8 *) &Dst->PixelData[y * DstWidth + x];
+            for (c = 0; c < 4; c++) {
+                Pixel[c] = (UINT8) floor (Sum[c] + 0.5);
+            }
+        }
+    }
+
+    free (WeightX);
+    free (WeightY);
+
+    return Dst;
+}
+
+//
+// Golden outputs ... PAM files with a BGRA byte order tuple type
+//
+
+static int ReadGolden (const char *Path, UINTN Width, UINTN Height, EG_PIXEL **Data) {
+    FILE   *File;
+    char    Header[160];
+    size_t  Size = Width * Height * sizeof (EG_PIXEL);
+    int     Ok   = 0;
+
+    File = fopen (Path, "rb");
+    if (File == NULL) {
+        return 0;
+    }
+    snprintf (Header, sizeof (Header),
+        "P7\nWIDTH %lu\nHEIGHT %lu\nDEPTH 4\nMAXVAL 255\nTUPLTYPE BGRA\nENDHDR\n",
+        (unsigned long) Width, (unsigned long) Height
+    );
+    *Data = malloc (Size);
+    if (*Data != NULL) {
+        char Got[sizeof (Header)];
+        size_t Length = strlen (Header);
+
+        Ok = fread (Got, 1, Length, File) == Length && memcmp (Got, Header, Length) == 0 &&
+            fread (*Data, 1, Size, File) == Size;
+    }
+    fclose (File);
+
+    return Ok;
+}
+
+static int WriteGolden (const char *Path, EG_IMAGE *Image) {
+    FILE *File;
+    int   Ok;
+
+    File = fopen (Path, "wb");
+    if (File == NULL) {
+        return 0;
+    }
+    fprintf (File, "P7\nWIDTH %lu\nHEIGHT %lu\nDEPTH 4\nMAXVAL 255\nTUPLTYPE BGRA\nENDHDR\n",
+        (unsigned long) Image->Width, (unsigned long) Image->Height
+    );
+    Ok = fwrite (Image->PixelData, sizeof (EG_PIXEL), Image->Width * Image->Height, File) ==
+        Image->Width * Image->Height;
+    fclose (File);
+
+    return Ok;
+}
+
+static void Check (int Ok, const char *Name, const char *Message, int Value) {
+    printf ("%s  %-10s %s %d\n", Ok ? "PASS" : "FAIL", Name, Message, Value);
+    if (!Ok) {
+        Failures++;
+    }
+}
+
+static void TestCase (const SCALE_CASE *Case, int Update) {
+    char       Path[512];
+    EG_IMAGE  *Src, *Got, *Ref;
+    EG_PIXEL  *Golden;
+    UINT8     *GotBytes, *RefBytes;
+    size_t     i, Size;
+    int        Diff, MaxDiff = 0;
+
+    Src = MakeSource (Case->SrcWidth, Case->SrcHeight);
+    Got = egScaleImage (Src, Case->DstWidth, Case->DstHeight);
+    if (Got == NULL || Got->Width != Case->DstWidth || Got->Height != Case->DstHeight) {
+        Check (0, Case->Name, "egScaleImage failed", 0);
+        return;
+    }
+
+    Ref      = ReferenceScale (Src, Case->DstWidth, Case->DstHeight);
+    Size     = Case->DstWidth * Case->DstHeight * sizeof (EG_PIXEL);
+    GotBytes = (UINT8 *) Got->PixelData;
+    RefBytes = (UINT8 *) Ref->PixelData;
+    for (i = 0; i < Size; i++) {
+        Diff = abs ((int) GotBytes[i] - (int) RefBytes[i]);
+        if (Diff > MaxDiff) {
+            MaxDiff = Diff;
+        }
+    }
+    Check (MaxDiff <= ScaleDiffLimit, Case->Name, "max diff from exact reference", MaxDiff);
+
+    snprintf (Path, sizeof (Path), "%s/%s.pam", DataDir, Case->Name);
+    if (Update) {
+        Check (WriteGolden (Path, Got), Case->Name, "golden output written", 1);
+    }
+    else if (!ReadGolden (Path, Case->DstWidth, Case->DstHeight, &Golden)) {
+        Check (0, Case->Name, "cannot read golden output", 0);
+    }
+    else {
+        Check (memcmp (Golden, Got->PixelData, Size) == 0, Case->Name, "matches golden output", 1);
+        free (Golden);
+    }
+
+    MY_FREE_IMAGE(Src);
+    MY_FREE_IMAGE(Got);
+    MY_FREE_IMAGE(Ref);
+}
+
+static double NowMs (void) {
+    struct timespec Now;
+
+    clock_gettime (CLOCK_MONOTONIC, &Now);
+    return Now.tv_sec * 1e3 + Now.tv_nsec / 1e6;
+}
+
+// Best of several runs, as a quiet machine gives the most repeatable figure
+static void Bench (UINTN SrcWidth, UINTN SrcHeight, UINTN DstWidth, UINTN DstHeight) {
+    EG_IMAGE  *Src, *Dst;
+    double     Start, Time, Best = 1e9;
+    int        Run;
+
+    Src = MakeSource (SrcWidth, SrcHeight);
+    for (Run = 0; Run < 10; Run++) {
+        Start = NowMs();
+        Dst   = egScaleImage (Src, DstWidth, DstHeight);
+        Time  = NowMs() - Start;
+        MY_FREE_IMAGE(Dst);
+        if (Time < Best) {
+            Best = Time;
+        }
+    }
+    MY_FREE_IMAGE(Src);
+
+    printf ("%4lux%-4lu -> %4lux%-4lu  %7.2f ms\n",
+        (unsigned long) SrcWidth, (unsigned long) SrcHeight,
+        (unsigned long) DstWidth, (unsigned long) DstHeight, Best
+    );
+}
+
+int main (int argc, char *argv[]) {
+    size_t i;
+    int    Update = 0;
+
+    if (argc > 1 && strcmp (argv[1], "bench") == 0) {
+        Bench (3840, 2160, 1920, 1080);
+        Bench (3840, 2160, 2560, 1440);
+        Bench (1920, 1080, 3840, 2160);
+        Bench ( 256,  256,  128,  128);
+        Bench ( 128,  128,   48,   48);
+        return 0;
+    }
+    if (argc > 1 && strcmp (argv[1], "update") == 0) {
+        Update = 1;
+        argc--;
+        argv++;
+    }
+    if (argc > 1) {
+        DataDir = argv[1];
+    }
+
+    for (i = 0; i < sizeof (ScaleCases) / sizeof (ScaleCases[0]); i++) {
+        TestCase (&ScaleCases[i], Update);
+    }
+
+    printf ("%d failure(s)\n", Failures);
+    return (Failures == 0) ? 0 : 1;
+}
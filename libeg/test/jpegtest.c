@@ -0,0 +1,290 @@
+/*
+ * libeg/test/jpegtest.c
+ * Host test for the NanoJPEG decoder in libeg/nanojpeg.c
+ *
+ * Each test image is decoded at full size and at every reduction that
+ * njDecodeScaled can pick. Full size output is compared with a libjpeg
+ * decode of the same file. Reduced output is compared with the libjpeg
+ * decode averaged over the same block size, which is what a reduced IDCT
+ * approximates. A progressive file must decode exactly like its baseline
+ * twin at every size.
+ *
+ * This program is licensed under the terms of the GNU GPL, version 3,
+ * or (at your option) any later version.
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// nanojpeg.c maps its libc calls to these firmware functions
+static void * AllocatePool (size_t Size)                          { return malloc (Size); }
+static void   FreePool (void *Buffer)                             { free (Buffer); }
+static void * MyMemSet (void *Dest, int Value, size_t Size)       { return memset (Dest, Value, Size); }
+static void * MyMemCpy (void *Dest, const void *Src, size_t Size) { return memmove (Dest, Src, Size); }
+
+#include "../nanojpeg.c"
+
+// Largest differences from the reference, in levels, by log2 of the reduction.
+// At 1/8, subsampled chroma is a single DC term per 16 pixels, so colour
+// images drift further from the averaged reference.
+static const int    MaxDiffLimit[4]  = { 8,   16,  16,  24  };
+static const double MeanDiffLimit[4] = { 1.0, 3.0, 3.0, 5.0 };
+
+typedef struct {
+    const char *Name;
+    const char *RefExt;
+} TEST_IMAGE;
+
+static const TEST_IMAGE TestImages[] = {
+    { "rgb420", "ppm" },
+    { "rgb444", "ppm" },
+    { "rgb422", "ppm" },
+    { "gray",   "pgm" },
+};
+
+typedef struct {
+    int            Width, Height, Channels;
+    unsigned char *Data;
+} PIXMAP;
+
+static const char *DataDir = "jpeg";
+static int         Failures;
+
+static unsigned char * ReadFile (const char *Path, int *Size) {
+    FILE          *File;
+    long           Length;
+    unsigned char *Data;
+
+    File = fopen (Path, "rb");
+    if (File == NULL) {
+        return NULL;
+    }
+    fseek (File, 0, SEEK_END);
+    Length = ftell (File);
+    fseek (File, 0, SEEK_SET);
+    Data = (unsigned char *) (malloc) (Length > 0 ? Length : 1);
+    if (Data != NULL && fread (Data, 1, Length, File) != (size_t) Length) {
+        (free) (Data);
+        Data = NULL;
+    }
+    fclose (File);
+
+    *Size = (int) Length;
+    return Data;
+}
+
+static int ReadPnm (const char *Path, PIXMAP *Map) {
+    FILE *File;
+    char  Magic[3];
+    int   MaxVal;
+    long  Size;
+
+    File = fopen (Path, "rb");
+    if (File == NULL) {
+        return 0;
+    }
+    if (fscanf (File, "%2s %d %d %d", Magic, &Map->Width, &Map->Height, &MaxVal) != 4 ||
+        MaxVal != 255 || fgetc (File) == EOF
+    ) {
+        fclose (File);
+        return 0;
+    }
+    Map->Channels = (strcmp (Magic, "P6") == 0) ? 3 : 1;
+    Size          = (long) Map->Width * Map->Height * Map->Channels;
+    Map->Data     = (unsigned char *) (malloc) (Size);
+    if (Map->Data == NULL || fread (Map->Data, 1, Size, File) != (size_t) Size) {
+        fclose (File);
+        return 0;
+    }
+    fclose (File);
+
+    return 1;
+}
+
+// Decodes Jpeg through njDecodeScaled into Out, which owns a copy of the pixels
+static int Decode (const unsigned char *Jpeg, int Size, int MinSize, PIXMAP *Out) {
+    nj_result_t Result;
+    int         Length;
+
+    Result = njDecodeScaled (Jpeg, Size, MinSize);
+    if (Result != NJ_OK) {
+        njDone();
+        return (int) Result;
+    }
+
+    Out->Width    = njGetWidth();
+    Out->Height   = njGetHeight();
+    Out->Channels = njIsColor() ? 3 : 1;
+    Length        = njGetImageSize();
+    Out->Data     = (unsigned char *) (malloc) (Length);
+    memcpy (Out->Data, njGetImage(), Length);
+    njDone();
+
+    return NJ_OK;
+}
+
+// Averages Ref over Scale x Scale blocks, repeating the last row and column
+// to fill partial blocks the way the decoder pads its MCUs
+static void BoxReference (const PIXMAP *Ref, int Scale, PIXMAP *Out) {
+    int x, y, c, dx, dy, sx, sy, Sum;
+
+    Out->Width    = (Ref->Width  + Scale - 1) / Scale;
+    Out->Height   = (Ref->Height + Scale - 1) / Scale;
+    Out->Channels = Ref->Channels;
+    Out->Data     = (unsigned char *) (malloc) ((size_t) Out->Width * Out->Height * Out->Channels);
+
+    for (y = 0; y < Out->Height; y++) {
+        for (x = 0; x < Out->Width; x++) {
+            for (c = 0; c < Ref->Channels; c++) {
+                Sum = 0;
+                for (dy = 0; dy < Scale; dy++) {
+                    sy = y * Scale + dy;
+                    if (sy >= Ref->Height) {
+                        sy = Ref->Height - 1;
+                    }
+                    for (dx = 0; dx < Scale; dx++) {
+                        sx = x * Scale + dx;
+                        if (sx >= Ref->Width) {
+                            sx = Ref->Width - 1;
+                        }
+                        Sum += Ref->Data[((size_t) sy * Ref->Width + sx) * Ref->Channels + c];
+                    }
+                }
+                Out->Data[((size_t) y * Out->Width + x) * Out->Channels + c] =
+                    (unsigned char) ((Sum + Scale * Scale / 2) / (Scale * Scale));
+            }
+        }
+    }
+}
+
+static void Check (int Ok, const char *Name, const char *Format, ...) {
+    va_list Args;
+
+    printf ("%s  %-12s ", Ok ? "PASS" : "FAIL", Name);
+    va_start (Args, Format);
+    vprintf (Format, Args);
+    va_end (Args);
+    printf ("\n");
+
+    if (!Ok) {
+        Failures++;
+    }
+}
+
+static void Compare (const char *Name, int Scale, const PIXMAP *Got, const PIXMAP *Ref) {
+    size_t i, Count;
+    int    Diff, MaxDiff = 0;
+    double Mean, Total = 0;
+    int    Shift     = (Scale == 8) ? 3 : Scale / 2;
+    double MeanLimit = MeanDiffLimit[Shift];
+    int    MaxLimit  = MaxDiffLimit[Shift];
+
+    if (Got->Width != Ref->Width || Got->Height != Ref->Height || Got->Channels != Ref->Channels) {
+        Check (0, Name, "1/%d: %dx%dx%d, reference is %dx%dx%d", Scale,
+            Got->Width, Got->Height, Got->Channels, Ref->Width, Ref->Height, Ref->Channels
+        );
+        return;
+    }
+
+    Count = (size_t) Got->Width * Got->Height * Got->Channels;
+    for (i = 0; i < Count; i++) {
+        Diff = abs ((int) Got->Data[i] - (int) Ref->Data[i]);
+        Total += Diff;
+        if (Diff > MaxDiff) {
+            MaxDiff = Diff;
+        }
+    }
+    Mean = Total / Count;
+
+    Check (MaxDiff <= MaxLimit && Mean <= MeanLimit, Name,
+        "1/%d: %dx%d, mean diff %.2f, max diff %d", Scale, Got->Width, Got->Height, Mean, MaxDiff
+    );
+}
+
+static int SamePixmap (const PIXMAP *A, const PIXMAP *B) {
+    return A->Width == B->Width && A->Height == B->Height && A->Channels == B->Channels &&
+        memcmp (A->Data, B->Data, (size_t) A->Width * A->Height * A->Channels) == 0;
+}
+
+static void TestImage (const TEST_IMAGE *Image) {
+    char           Path[512];
+    unsigned char *Baseline, *Progressive;
+    int            BaselineSize, ProgressiveSize;
+    int            Scale, MinSize, Larger, Result;
+    PIXMAP         Ref, Box, Got, GotProg;
+
+    snprintf (Path, sizeof (Path), "%s/%s.%s", DataDir, Image->Name, Image->RefExt);
+    if (!ReadPnm (Path, &Ref)) {
+        Check (0, Image->Name, "cannot read %s", Path);
+        return;
+    }
+    snprintf (Path, sizeof (Path), "%s/%s_b.jpg", DataDir, Image->Name);
+    Baseline = ReadFile (Path, &BaselineSize);
+    snprintf (Path, sizeof (Path), "%s/%s_p.jpg", DataDir, Image->Name);
+    Progressive = ReadFile (Path, &ProgressiveSize);
+    if (Baseline == NULL || Progressive == NULL) {
+        Check (0, Image->Name, "cannot read the JPEG files");
+        return;
+    }
+
+    Larger = (Ref.Width > Ref.Height) ? Ref.Width : Ref.Height;
+    for (Scale = 1; Scale <= 8; Scale *= 2) {
+        // The smallest size that still allows this reduction
+        MinSize = (Scale == 1) ? 0 : (Larger + Scale - 1) / Scale;
+
+        Result = Decode (Baseline, BaselineSize, MinSize, &Got);
+        if (Result != NJ_OK) {
+            Check (0, Image->Name, "1/%d: baseline decode failed with %d", Scale, Result);
+            continue;
+        }
+        Result = Decode (Progressive, ProgressiveSize, MinSize, &GotProg);
+        if (Result != NJ_OK) {
+            Check (0, Image->Name, "1/%d: progressive decode failed with %d", Scale, Result);
+            (free) (Got.Data);
+            continue;
+        }
+
+        // The decoder may keep a larger size when chroma planes get too small
+        if (Got.Width == (Ref.Width + Scale - 1) / Scale) {
+            if (Scale == 1) {
+                Compare (Image->Name, Scale, &Got, &Ref);
+            }
+            else {
+                BoxReference (&Ref, Scale, &Box);
+                Compare (Image->Name, Scale, &Got, &Box);
+                (free) (Box.Data);
+            }
+        }
+        else {
+            Check (1, Image->Name, "1/%d: not used, decoded at %dx%d", Scale, Got.Width, Got.Height);
+        }
+
+        Check (SamePixmap (&Got, &GotProg), Image->Name, "1/%d: progressive matches baseline", Scale);
+
+        (free) (Got.Data);
+        (free) (GotProg.Data);
+    }
+
+    (free) (Baseline);
+    (free) (Progressive);
+    (free) (Ref.Data);
+}
+
+int main (int argc, char *argv[]) {
+    size_t i;
+
+    if (argc > 1) {
+        DataDir = argv[1];
+    }
+
+    for (i = 0; i < sizeof (TestImages) / sizeof (TestImages[0]); i++) {
+        TestImage (&TestImages[i]);
+    }
+
+    printf ("%d failure(s)\n", Failures);
+    return (Failures == 0) ? 0 : 1;
+}
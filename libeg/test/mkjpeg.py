@@ -0,0 +1,54 @@
+#!/usr/bin/env python3
+#
+# libeg/test/mkjpeg.py
+# Regenerates the JPEG test images and their reference decodes.
+#
+# Needs Python 3 with Pillow and NumPy. The references are full size libjpeg
+# decodes of the baseline files, written as binary PPM or PGM. The progressive
+# twins hold the same coefficients, so they share the reference.
+#
+
+import os
+
+import numpy as np
+from PIL import Image
+
+OUTDIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'jpeg')
+
+# name, width, height, mode, chroma subsampling, quality, restart interval
+CASES = [
+    ('rgb420',  96, 72, 'RGB', 2, 90, 0),
+    ('rgb444',  33, 65, 'RGB', 0, 95, 0),
+    ('rgb422',  61, 40, 'RGB', 1, 75, 3),
+    ('gray',    64, 48, 'L',   0, 90, 0),
+]
+
+
+def photo(width, height, seed):
+    rng = np.random.default_rng(seed)
+    y, x = np.mgrid[0:height, 0:width]
+    r = 128 + 100 * np.sin(x / 15.0 + seed) * np.cos(y / 23.0)
+    g = 128 + 90 * np.sin((x + y) / 27.0)
+    b = 128 + 100 * np.cos(x / 19.0 - y / 31.0 + seed)
+    a = np.stack([r, g, b], -1) + rng.normal(0, 12, (height, width, 3))
+    return Image.fromarray(np.clip(a, 0, 255).astype(np.uint8))
+
+
+def main():
+    os.makedirs(OUTDIR, exist_ok=True)
+    for seed, (name, width, height, mode, sub, quality, restart) in enumerate(CASES):
+        image = photo(width, height, seed).convert(mode)
+        for kind, progressive in (('b', False), ('p', True)):
+            args = dict(quality=quality, progressive=progressive)
+            if mode == 'RGB':
+                args['subsampling'] = sub
+            if restart:
+                args['restart_marker_blocks'] = restart
+            image.save(os.path.join(OUTDIR, '%s_%s.jpg' % (name, kind)), **args)
+
+        ref = Image.open(os.path.join(OUTDIR, '%s_b.jpg' % name))
+        ref.save(os.path.join(OUTDIR, '%s.%s' % (name, 'ppm' if mode == 'RGB' else 'pgm')))
+
+
+if __name__ == '__main__':
+    main()
@@ -128,6 +128,157 @@ VOID egMeasureText (
     if (Width  != NULL) *Width  = StrLen (Text) * FontCellWidth;
 } // VOID egMeasureText()
 
+//
+// Glyph atlas
+//
+// Each font variant is reduced to per-glyph runs of covered pixels, with the
+// colours premultiplied by alpha in the packed layout used by egRawCompose.
+// Rendering a string then blends only the pixels that glyphs actually cover.
+//
+
+typedef struct {
+    UINT32  PremulRB;       // Blue and red times alpha, in two 16-bit lanes
+    UINT16  PremulG;        // Green times alpha
+    UINT8   InvAlpha;       // 255 - alpha
+    UINT8   Reserved;
+} EG_GLYPH_PIXEL;
+
+typedef struct {
+    UINT16  Row;
+    UINT16  Column;
+    UINT32  Length;
+    UINTN   FirstPixel;     // Index into EG_GLYPH_ATLAS.Pixels
+} EG_GLYPH_RUN;
+
+typedef struct {
+    UINTN   FirstRun;
+    UINTN   RunCount;
+} EG_GLYPH;
+
+typedef struct {
+    BOOLEAN          Ready;
+    UINTN            Height;
+    EG_GLYPH         Glyphs[FONT_NUM_CHARS];
+    EG_GLYPH_RUN    *Runs;
+    EG_GLYPH_PIXEL  *Pixels;
+} EG_GLYPH_ATLAS;
+
+static EG_GLYPH_ATLAS  DarkGlyphAtlas;
+static EG_GLYPH_ATLAS  LightGlyphAtlas;
+
+static
+VOID egFreeGlyphAtlas (
+    IN OUT EG_GLYPH_ATLAS *Atlas
+) {
+    MY_FREE_POOL(Atlas->Runs);
+    MY_FREE_POOL(Atlas->Pixels);
+    ZeroMem (Atlas, sizeof (EG_GLYPH_ATLAS));
+} // static VOID egFreeGlyphAtlas()
+
+// Builds the atlas for a font variant from BaseFontImage.
+// The light variant is derived on the fly when LightColour is not NULL.
+static
+BOOLEAN egBuildGlyphAtlas (
+    IN OUT EG_GLYPH_ATLAS *Atlas,
+    IN     EG_PIXEL       *LightColour OPTIONAL
+) {
+    EG_PIXEL        *Src;
+    EG_PIXEL         Pixel;
+    EG_GLYPH_RUN    *Run;
+    EG_GLYPH_PIXEL  *Out;
+    UINTN            RunCount;
+    UINTN            PixelCount;
+    UINTN            Pass;
+    UINTN            c, x, y;
+    UINTN            Start;
+
+    egFreeGlyphAtlas (Atlas);
+
+    if (BaseFontImage == NULL || FontCellWidth == 0) return FALSE;
+
+    // First pass counts runs and covered pixels, second pass fills them in
+    RunCount = PixelCount = 0;
+    for (Pass = 0; Pass < 2; Pass++) {
+        if (Pass == 1) {
+            Atlas->Runs   = AllocatePool (RunCount   * sizeof (EG_GLYPH_RUN));
+            Atlas->Pixels = AllocatePool (PixelCount * sizeof (EG_GLYPH_PIXEL));
+            if ((RunCount   > 0 && Atlas->Runs   == NULL) ||
+                (PixelCount > 0 && Atlas->Pixels == NULL)
+            ) {
+                egFreeGlyphAtlas (Atlas);
+
+                return FALSE;
+            }
+            RunCount = PixelCount = 0;
+        }
+
+        for (c = 0; c < FONT_NUM_CHARS; c++) {
+            if (Pass == 1) {
+                Atlas->Glyphs[c].FirstRun = RunCount;
+            }
+
+            for (y = 0; y < BaseFontImage->Height; y++) {
+                Src = BaseFontImage->PixelData + y * BaseFontImage->Width + c * FontCellWidth;
+
+                x = 0;
+                while (x < FontCellWidth) {
+                    if (Src[x].a == 0) {
+                        x++;
+                        continue;
+                    }
+
+                    Start = x;
+                    while (x < FontCellWidth && Src[x].a != 0) {
+                        if (Pass == 1) {
+                            Pixel = Src[x];
+                            if (LightColour != NULL) {
+                                if (Pixel.r == 0 && Pixel.g == 0 && Pixel.b == 0) {
+                                    Pixel.r = LightColour->r;
+                                    Pixel.g = LightColour->g;
+                                    Pixel.b = LightColour->b;
+                                }
+                                else {
+                                    Pixel.r = 255 - Pixel.r;
+                                    Pixel.g = 255 - Pixel.g;
+                                    Pixel.b = 255 - Pixel.b;
+                                }
+                            }
+
+                            Out           = &Atlas->Pixels[PixelCount + (x - Start)];
+                            Out->PremulRB = ((UINT32) Pixel.b * Pixel.a) |
+                                            (((UINT32) Pixel.r * Pixel.a) << 16);
+                            Out->PremulG  = (UINT16) (Pixel.g * Pixel.a);
+                            Out->InvAlpha = (UINT8) (255 - Pixel.a);
+                            Out->Reserved = 0;
+                        }
+                        x++;
+                    } // while
+
+                    if (Pass == 1) {
+                        Run             = &Atlas->Runs[RunCount];
+                        Run->Row        = (UINT16) y;
+                        Run->Column     = (UINT16) Start;
+                        Run->Length     = (UINT32) (x - Start);
+                        Run->FirstPixel = PixelCount;
+                    }
+
+                    RunCount++;
+                    PixelCount += x - Start;
+                } // while x < FontCellWidth
+            } // for y
+
+            if (Pass == 1) {
+                Atlas->Glyphs[c].RunCount = RunCount - Atlas->Glyphs[c].FirstRun;
+            }
+        } // for c
+    } // for Pass
+
+    Atlas->Height = BaseFontImage->Height;
+    Atlas->Ready  = TRUE;
+
+    return TRUE;
+} // static BOOLEAN egBuildGlyphAtlas()
+
 VOID egRenderText (
     IN CHAR16       *Text,
     IN OUT EG_IMAGE *CompImage,
@@ -135,71 +286,60 @@ VOID egRenderText (
     IN UINTN         PosY,
     IN UINT8         BGBrightness
 ) {
-    EG_IMAGE        *FontImage;
-    EG_PIXEL        *BufferPtr;
-    EG_PIXEL        *FontPixelData;
+    EG_GLYPH_ATLAS  *Atlas;
+    EG_GLYPH_RUN    *Run;
+    EG_GLYPH_RUN    *RunEnd;
+    EG_GLYPH_PIXEL  *Pixel;
+    EG_PIXEL         OurFont;
+    UINT32          *BufferPtr;
+    UINT32          *Dest;
+    UINT32           Comp;
+    UINT32           TempRB;
+    UINT32           TempG;
     UINTN            BufferLineOffset;
-    UINTN            FontLineOffset;
+    UINTN            MaxRows;
     UINTN            TextLength;
-    UINTN            i, c;
-
-    static EG_IMAGE *DarkFontImage  = NULL;
-    static EG_IMAGE *LightFontImage = NULL;
+    UINTN            i, k, c;
 
     // Early Return if nothing was passed
-    if (Text == NULL) return;
+    if (Text == NULL || CompImage == NULL) return;
 
     egPrepareFont();
 
+    if (PosX >= CompImage->Width || PosY >= CompImage->Height) return;
+
     // Clip the text
     TextLength = StrLen (Text);
 
     if (TextLength * FontCellWidth + PosX > CompImage->Width) {
         TextLength = (CompImage->Width - PosX) / FontCellWidth;
     }
+    if (TextLength == 0) return;
 
     if (BGBrightness >= 128) {
-        if (DarkFontImage == NULL) DarkFontImage = egCopyImage (BaseFontImage);
-        if (DarkFontImage == NULL) return;
-
-        FontImage = DarkFontImage;
+        Atlas = &DarkGlyphAtlas;
+        if (!Atlas->Ready && !egBuildGlyphAtlas (Atlas, NULL)) return;
     }
     else {
-        if (LightFontImage == NULL) {
-            LightFontImage = egCopyImage (BaseFontImage);
-            if (LightFontImage == NULL) return;
-
-            EG_PIXEL OurFont = {0xFF, 0xFF, 0xFF, 0};
+        Atlas = &LightGlyphAtlas;
+        if (!Atlas->Ready) {
+            OurFont.b = OurFont.g = OurFont.r = 0xFF;
+            OurFont.a = 0;
             if (DefaultBanner || GlobalConfig.HelpText) {
                 OurFont = FontComplement();
             }
 
-            for (i = 0; i < (LightFontImage->Width * LightFontImage->Height); i++) {
-                if (LightFontImage->PixelData[i].r == 0 &&
-                    LightFontImage->PixelData[i].g == 0 &&
-                    LightFontImage->PixelData[i].b == 0
-                ) {
-                    LightFontImage->PixelData[i].r = OurFont.r;
-                    LightFontImage->PixelData[i].g = OurFont.g;
-                    LightFontImage->PixelData[i].b = OurFont.b;
-                }
-                else {
-                    LightFontImage->PixelData[i].r = 255 - LightFontImage->PixelData[i].r;
-                    LightFontImage->PixelData[i].g = 255 - LightFontImage->PixelData[i].g;
-                    LightFontImage->PixelData[i].b = 255 - LightFontImage->PixelData[i].b;
-                }
-            } // for
-        } // if LightFontImage == NULL
-
-        FontImage = LightFontImage;
+            if (!egBuildGlyphAtlas (Atlas, &OurFont)) return;
+        }
     } // if/else BGBrightness >= 128
 
     // Render it
-    BufferPtr         = CompImage->PixelData;
+    if (!egUnshareImage (CompImage)) return;
+
+    MaxRows           = CompImage->Height - PosY;
     BufferLineOffset  = CompImage->Width;
+    BufferPtr         = (UINT32 *) CompImage->PixelData;
     BufferPtr        += PosX + PosY * BufferLineOffset;
-    FontPixelData     = FontImage->PixelData;
-    FontLineOffset    = FontImage->Width;
 
     for (i = 0; i < TextLength; i++) {
         c = Text[i];
@@ -210,19 +350,34 @@ VOID egRenderText (
             c -= 32;
         }
 
-        egRawCompose (
-            BufferPtr, FontPixelData + c * FontCellWidth,
-            FontCellWidth, FontImage->Height,
-            BufferLineOffset, FontLineOffset
-        );
+        // Same blend as egRawCompose, with the glyph side precomputed
+        Run    = Atlas->Runs + Atlas->Glyphs[c].FirstRun;
+        RunEnd = Run + Atlas->Glyphs[c].RunCount;
+        for (; Run < RunEnd && Run->Row < MaxRows; Run++) {
+            Dest  = BufferPtr + Run->Row * BufferLineOffset + Run->Column;
+            Pixel = Atlas->Pixels + Run->FirstPixel;
+
+            for (k = 0; k < Run->Length; k++, Dest++, Pixel++) {
+                Comp   = *Dest;
+                TempRB = (Comp & 0x00FF00FF) * Pixel->InvAlpha + Pixel->PremulRB + 0x00800080;
+                TempRB = ((TempRB + ((TempRB >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+                TempG  = ((Comp >> 8) & 0xFF) * Pixel->InvAlpha + Pixel->PremulG + 0x80;
+                TempG  = ((TempG + (TempG >> 8)) >> 8) & 0xFF;
+                *Dest  = (Comp & 0xFF000000) | TempRB | (TempG << 8);
+            }
+        } // for Run
+
         BufferPtr += FontCellWidth;
-    }
+    } // for i
 } // VOID egRenderText()
 
 // Load a font bitmap from the specified file
 VOID egLoadFont (
     IN CHAR16 *Filename
 ) {
+    egFreeGlyphAtlas (&DarkGlyphAtlas);
+    egFreeGlyphAtlas (&LightGlyphAtlas);
+
     MY_FREE_IMAGE(BaseFontImage);
     BaseFontImage = egLoadImage (SelfDir, Filename, TRUE);
     if (BaseFontImage == NULL) {